@@ -1,6 +1,6 @@
 #version 330 core
 
-uniform vec3 color;
+flat in vec3 color;
 
 out vec4 fragColor;
 
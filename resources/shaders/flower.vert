@@ -3,13 +3,15 @@
 in vec3 position; // Position of the vertex
 in vec3 normal; // normal of the vertex
 
-uniform mat4 mvp; // Modelview Projection matrix. This maps the vertices in model (object) space to screen coordinates
-uniform mat4 m; // model matrix (object -> world)
+// Per flower part, from the instance buffer FlowersRenderer builds on refresh
+in mat4 model; // Moon-local model matrix (object -> moon)
+in vec4 instanceColor; // Color of the part, then unused
 
+uniform mat4 mvp; // Projection * view * the moon's orbit, once per frame
 
-void main(){
-
-    vec3 position_worldSpace = (m * vec4(position, 1.0)).xyz; // Vertex position in world space
+flat out vec3 color;
 
-    gl_Position =  mvp*vec4(position, 1.0); // Vertex position in screen space
+void main(){
+    color = instanceColor.rgb;
+    gl_Position = mvp * model * vec4(position, 1.0); // Vertex position in screen space
 }
@@ -2,21 +2,34 @@
 
 in float noise;
 
-uniform float threshold;
-uniform vec4 colorLow; // 4th parameter is mix variable
-uniform vec4 colorHigh; // 4th parameter is mix variable
+// Per planet, from planet.vert
+flat in vec4 low; // 4th parameter is mix variable
+flat in vec4 high; // 4th parameter is mix variable
+flat in float threshold;
+flat in vec2 ditherRange; // Only pixels whose dither value is in [x, y) are drawn, for LOD cross fades
 
 out vec4 fragColor;
 
+// 4x4 ordered dither, so two meshes with complementary ranges cover each pixel once
+float dither() {
+    const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0,
+                                      3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+    ivec2 p = ivec2(gl_FragCoord.xy) & 3;
+    return (bayer[p.y*4 + p.x] + 0.5) / 16.0;
+}
+
 void main() {
+    float d = dither();
+    if (d < ditherRange.x || d >= ditherRange.y) discard;
+
     vec4 color;
     float height = noise * 100.0;
     
     // Low color
-    if (height < threshold) color = colorLow;
+    if (height < threshold) color = low;
     
     // Ground
-    else color = colorHigh;
+    else color = high;
 
     vec3 finalColor = color.xyz * (color.w + 10.0*noise);
     fragColor = vec4(finalColor*1.25f, 1.0);
@@ -1,12 +1,15 @@
 #version 330 core
 
+// Run once per seed with transform feedback - planet.vert draws what's captured
 in vec3 position;
 in vec3 normal;
 
 uniform float seed;
-uniform mat4x4 mvp;
+uniform int octaves; // Finer octaves than the mesh can sample only alias
+uniform bool simplex; // Simplex instead of Perlin for every noise call
 
-out float noise;
+out vec3 bakedPosition;
+out float bakedNoise;
 
 vec3 mod289(vec3 x)
 {
@@ -28,6 +31,9 @@ vec4 taylorInvSqrt(vec4 r)
   return 1.79284291400159 - 0.85373472095314 * r;
 }
 
+// Scales simplex so its mean absolute value matches pnoise's
+const float SIMPLEX_SCALE = 0.78;
+
 vec3 fade(vec3 t) {
   return t*t*t*(t*(t*6.0-15.0)+10.0);
 }
@@ -102,21 +108,84 @@ float pnoise(vec3 P, vec3 rep)
   return 2.2 * n_xyz;
 }
  
+// Simplex (Gustavson and McEwan's) - 4 corners instead of 8, and no period
+float snoise(vec3 v)
+{
+  const vec2 C = vec2(1.0/6.0, 1.0/3.0);
+  const vec4 D = vec4(0.0, 0.5, 1.0, 2.0);
+
+  // First corner
+  vec3 i = floor(v + dot(v, C.yyy));
+  vec3 x0 = v - i + dot(i, C.xxx);
+
+  // Other corners
+  vec3 g = step(x0.yzx, x0.xyz);
+  vec3 l = 1.0 - g;
+  vec3 i1 = min(g.xyz, l.zxy);
+  vec3 i2 = max(g.xyz, l.zxy);
+  vec3 x1 = x0 - i1 + C.xxx;
+  vec3 x2 = x0 - i2 + C.yyy;
+  vec3 x3 = x0 - D.yyy;
+
+  // Permutations
+  i = mod289(i);
+  vec4 p = permute(permute(permute(
+             i.z + vec4(0.0, i1.z, i2.z, 1.0))
+           + i.y + vec4(0.0, i1.y, i2.y, 1.0))
+           + i.x + vec4(0.0, i1.x, i2.x, 1.0));
+
+  // Gradients: 7x7 points over a square, mapped onto an octahedron
+  float n_ = 1.0/7.0;
+  vec3 ns = n_ * D.wyz - D.xzx;
+  vec4 j = p - 49.0 * floor(p * ns.z * ns.z);
+  vec4 x_ = floor(j * ns.z);
+  vec4 y_ = floor(j - 7.0 * x_);
+  vec4 x = x_ * ns.x + ns.yyyy;
+  vec4 y = y_ * ns.x + ns.yyyy;
+  vec4 h = 1.0 - abs(x) - abs(y);
+  vec4 b0 = vec4(x.xy, y.xy);
+  vec4 b1 = vec4(x.zw, y.zw);
+  vec4 s0 = floor(b0)*2.0 + 1.0;
+  vec4 s1 = floor(b1)*2.0 + 1.0;
+  vec4 sh = -step(h, vec4(0.0));
+  vec4 a0 = b0.xzyw + s0.xzyw*sh.xxyy;
+  vec4 a1 = b1.xzyw + s1.xzyw*sh.zzww;
+  vec3 p0 = vec3(a0.xy, h.x);
+  vec3 p1 = vec3(a0.zw, h.y);
+  vec3 p2 = vec3(a1.xy, h.z);
+  vec3 p3 = vec3(a1.zw, h.w);
+
+  // Normalise gradients
+  vec4 norm = taylorInvSqrt(vec4(dot(p0,p0), dot(p1,p1), dot(p2,p2), dot(p3,p3)));
+  p0 *= norm.x;
+  p1 *= norm.y;
+  p2 *= norm.z;
+  p3 *= norm.w;
+
+  // Mix final noise value
+  vec4 m = max(0.6 - vec4(dot(x0,x0), dot(x1,x1), dot(x2,x2), dot(x3,x3)), 0.0);
+  m = m * m;
+  return 42.0 * SIMPLEX_SCALE * dot(m*m, vec4(dot(p0,x0), dot(p1,x1), dot(p2,x2), dot(p3,x3)));
+}
+
+float basis(vec3 p, vec3 rep) {
+    return simplex ? snoise(p) : pnoise(p, rep);
+}
+ 
 float turbulence( vec3 p ) {
-    float w = 100.0;
     float t = -0.5;
-    for (float f = 1.0; f <= 10.0; f++ ){
-        float power = pow(2.0, f);
-        t += abs(pnoise(vec3(power * p), vec3(10.0))/power);
+    float power = 1.0;
+    for (int f = 1; f <= octaves; f++) {
+        power *= 2.0;
+        t += abs(basis(power * p, vec3(10.0))/power);
     }
     return t;
 }
  
 void main() {
-    noise = 5.6 *  -0.018 * turbulence(0.73 * normal + seed);
-    float disturbance =  pnoise(0.05 * position, vec3(100.0));
-    float displacement = 1.5 * noise + disturbance;
-     
-    vec3 newPosition = position + normal * displacement;
-    gl_Position = mvp * vec4(newPosition, 0.75);
+    bakedNoise = 5.6 *  -0.018 * turbulence(0.73 * normal + seed);
+    float disturbance = basis(0.05 * position, vec3(100.0));
+    float displacement = 1.5 * bakedNoise + disturbance;
+
+    bakedPosition = position + normal * displacement;
 }
@@ -0,0 +1,47 @@
+#version 330 core
+
+const int BODY_TEXELS = 4; // PLANET_BODY_TEXELS in PlanetsRenderer
+const float TWO_PI = 6.28318530718;
+
+in vec4 positionNoise; // Displaced position, then noise - baked once per seed by noise.vert
+
+// Per planet, from the instance buffer (or a constant attribute for terrain)
+in vec4 instance; // Body index, then the dither range, then unused
+
+// Every body's orbit and colors, written once per refresh by PlanetsRenderer::createBodyBuffer
+uniform samplerBuffer bodies;
+uniform samplerBuffer positions; // Position, then size - moved every frame with --nbody, where 1/year is 0
+uniform float time; // Scene::getRotationalSpeed
+uniform mat4x4 viewProjection;
+
+out float noise;
+flat out vec4 low;
+flat out vec4 high;
+flat out float threshold;
+flat out vec2 ditherRange;
+
+/**
+ * Rotates v by angle radians around a unit axis, the same way glm::rotate does
+ */
+vec3 rotateAround(vec3 v, vec3 axis, float angle) {
+    float c = cos(angle);
+    float s = sin(angle);
+    return v*c + cross(axis, v)*s + axis*dot(axis, v)*(1.0 - c);
+}
+
+void main() {
+    int body = int(instance.x) * BODY_TEXELS;
+    vec4 positionSize = texelFetch(positions, int(instance.x));
+    vec4 axisDay = texelFetch(bodies, body); // Unit tilt, then 1/day
+    low = texelFetch(bodies, body + 1);
+    high = texelFetch(bodies, body + 2);
+    vec4 yearThreshold = texelFetch(bodies, body + 3); // 1/year, then threshold
+    noise = positionNoise.w;
+    threshold = yearThreshold.y;
+    ditherRange = instance.yz;
+
+    // PlanetsRenderer::applyPlanetTrans on (position, 0.75) - scale, spin, move out to the orbit, then orbit
+    vec3 local = rotateAround(positionSize.w * positionNoise.xyz, axisDay.xyz, mod(time * axisDay.w, TWO_PI));
+    vec3 world = rotateAround(local + 0.75 * positionSize.xyz, vec3(0, 1, 0), mod(time * yearThreshold.x, TWO_PI));
+    gl_Position = viewProjection * vec4(world, 0.75);
+}
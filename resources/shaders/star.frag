@@ -1,19 +1,21 @@
 #version 330 core
 
 in vec2 uv; // uv coordinate for frag position
+in vec4 color; // Color from the star, alpha is how alive it is
+flat in float twinklePhase; // Twinkle phase as a fraction of one twinkle
 
-uniform mat4 mvp; // Modelview Projection matrix. This maps the vertices in model (object) space to film coordinates (world->film)
-uniform vec4 color;
-uniform sampler2D textureSampler;
+uniform bool bake; // Drawing into the sky cubemap
 
 out vec4 fragColor; //output color
 
 void main(){
-    // Figure out something reasonable to do with texColor and color...
-    vec4 texColor = texture(textureSampler, uv);
+    // Fade out radially from the center of the particle
     float dx = 0.5f - uv.x;
     float dy = 0.5f - uv.y;
     float radius = sqrt(dx*dx + dy*dy);
     float opacity = pow(0.75f - radius,2);
-    fragColor = color * color.a * opacity * 3.0f;//texColor*color;//(0.5*color) + (0.5*texColor);
+
+    // Baked stars are added at full life, the same as blending by alpha below - life is applied when sampled
+    if (bake) fragColor = vec4(color.rgb * opacity * opacity * 9.0f, twinklePhase);
+    else fragColor = color * color.a * opacity * 3.0f;
 }
@@ -1,16 +1,63 @@
 #version 330 core
 
-in vec3 position; // Position of the vertex
-in vec2 texCoord; // UV texture coordinates of the vertex
+in vec3 position; // Corner of the particle quad
+in vec2 texCoord; // UV texture coordinates of the corner
+in vec4 posLife; // Per star: position, then life (or twinkle phase for static stars)
+in vec4 dirDecay; // Per star: direction moved each step, then decay (unused for static stars)
 
-out vec2 uv; //UV texture coordinates of the vertex
+out vec2 uv; // UV texture coordinates of the vertex
+out vec4 color; // Color of the star, alpha is how alive it is
+flat out float twinklePhase; // Twinkle phase as a fraction of one twinkle, for baking
 
-uniform mat4 m; // model matrix (object -> world)
-uniform mat4 v; // viewing matrix (world -> camera)
-uniform mat4 mvp; // Modelview Projection matrix. (object -> film)
+uniform mat4 vp; // Viewing and projection matrix (world -> film)
+uniform mat4 atmosphericRotation; // Slow rotation of the whole sky
+uniform vec3 eye; // Normalized eye position
+uniform float alpha; // How far between the last two steps to draw
+uniform float streak; // Steps a shooting star is stretched back over, so trails don't break up
+uniform bool twinkle; // Static stars - life comes from the phase and twinkleTime
+uniform float twinkleTime; // Steps since refresh, wrapped to one twinkle period
+uniform bool bake; // Drawing static stars into the sky cubemap from the center - fully alive, no culling
+uniform float maxLife;
+uniform vec3 starColor;
+uniform vec3 shootingColor;
+
+// Rotates v by the rotation that takes +z onto n
+vec3 faceTowards(vec3 v, vec3 n) {
+    vec3 axis = cross(vec3(0.0, 0.0, 1.0), n);
+    float s = length(axis);
+    float c = n.z;
+    if (s < 1e-6) return c > 0.0 ? v : -v;
+    axis /= s;
+    return v*c + cross(axis, v)*s + axis*dot(axis, v)*(1.0 - c);
+}
 
 void main(){
-        uv = texCoord;
+    uv = texCoord;
+    vec3 dir = twinkle ? vec3(0.0) : dirDecay.xyz;
+    bool shooting = dot(dir, dir) > 0.0;
+
+    // Life bounces between 0 and maxLife, a triangle wave for stars that never move
+    float life = posLife.w;
+    if (twinkle) {
+        float phase = mod(posLife.w + twinkleTime, 2.0 * maxLife);
+        life = phase < maxLife ? phase : 2.0 * maxLife - phase;
+    }
+    twinklePhase = posLife.w / (2.0 * maxLife);
+    if (bake) life = maxLife;
+    vec3 toCenter = normalize(-posLife.xyz);
+
+    // Backface culling - stars on the eye's side of the sky collapse to nothing
+    if (!bake && dot(eye, mat3(atmosphericRotation) * toCenter) <= 0.0) {
+        color = vec4(0.0);
+        gl_Position = vec4(0.0);
+        return;
+    }
+
+    // Shooting stars cover everywhere they've been since the last frame
+    vec3 center = posLife.xyz + (alpha - 0.5 * streak) * dir;
+
+    color = vec4(shooting ? shootingColor : starColor, life / maxLife);
 
-        gl_Position =  mvp*vec4(position, 1.0);
+    vec3 corner = faceTowards(position, toCenter) + dir * (0.5 * streak * position.y);
+    gl_Position = vp * atmosphericRotation * vec4(center + corner, 1.0);
 }
@@ -0,0 +1,48 @@
+#version 330 core
+
+in vec4 posLife; // Position, then life
+in vec4 dirDecay; // Direction moved each step, then decay
+
+out vec4 outPosLife; // Captured by transform feedback
+out vec4 outDirDecay;
+
+uniform uint seed; // Seed for this set of stars
+uniform uint stepCount; // Steps taken since the stars were made
+uniform float maxLife;
+uniform float spread;
+
+// Must match hashN in GLMath.h exactly
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Must match hashRandN in GLMath.h exactly - a float in [0,1)
+float hashRand(uint i, uint n) {
+    return float(hash(seed ^ hash(i ^ hash(n))) >> 8) / 16777216.0;
+}
+
+void main(){
+    vec3 pos = posLife.xyz + dirDecay.xyz;
+    float life = posLife.w + dirDecay.w;
+    float decay = dirDecay.w;
+
+    // Bounce life between 0 and max, moving shooting stars somewhere new when they fade out
+    if (life <= 0.0 || life >= maxLife) {
+        decay = -decay;
+        if (dot(dirDecay.xyz, dirDecay.xyz) > 0.0 && life <= 0.0) {
+            uint i = uint(gl_VertexID);
+            uint n = stepCount * 3u;
+            pos = vec3(-spread + 2.0 * spread * hashRand(i, n),
+                       -spread + 2.0 * spread * hashRand(i, n + 1u),
+                       -spread + 2.0 * spread * hashRand(i, n + 2u));
+        }
+    }
+
+    outPosLife = vec4(pos, life);
+    outDirDecay = vec4(dirDecay.xyz, decay);
+}
@@ -6,14 +6,43 @@ in vec2 uv; // Input to this fragment shader is the output of tex.gvert
 uniform sampler2D starTex;
 uniform sampler2D planetTex;
 
+// Static stars baked once per refresh, if skyCubemap is set
+uniform bool skyCubemap;
+uniform samplerCube skyTex; // Sky space, seen from the center: rgb at full life, alpha is twinkle phase
+uniform mat4 inverseVP; // Film -> world
+uniform mat3 inverseRotation; // World -> sky space, undoing the atmospheric rotation
+uniform vec3 skyEye; // Eye position in sky space
+uniform float skyRadius; // Baked stars are looked up where the view ray leaves a sphere this big
+uniform float twinkleTime; // Steps since refresh, wrapped to one twinkle period
+uniform float maxLife;
+
 // Output color vector
 out vec4 fragColor;
 
+// Static stars behind this pixel from the cubemap, twinkled to now
+vec3 skyColor() {
+    vec4 far = inverseVP * vec4(uv * 2.0 - 1.0, 1.0, 1.0);
+    vec3 dir = normalize(inverseRotation * (far.xyz / far.w) - skyEye);
+
+    // The eye is always inside the sphere, so take the far hit - this keeps parallax when zoomed out
+    float b = dot(skyEye, dir);
+    vec3 hit = skyEye + dir * (sqrt(b*b - dot(skyEye, skyEye) + skyRadius*skyRadius) - b);
+
+    // Same backface culling as star.vert
+    if (dot(skyEye, hit) >= 0.0) return vec3(0.0);
+
+    vec4 sky = texture(skyTex, hit);
+    float phase = mod(sky.a * 2.0 * maxLife + twinkleTime, 2.0 * maxLife);
+    float life = (phase < maxLife ? phase : 2.0 * maxLife - phase) / maxLife;
+    return sky.rgb * life * life * life;
+}
+
 void main(void)
 {
     vec3 planetColor = texture(planetTex, uv).rgb;
 
     // If flower isn't black, draw it, otherwise try planet, otherwise draw star
     if (length(planetColor) > 0) fragColor = vec4(planetColor, 1.0);
+    else if (skyCubemap) fragColor = vec4(min(texture(starTex, uv).rgb + skyColor(), 1.0), 1.0);
     else fragColor = vec4(texture(starTex, uv).rgb, 1.0);
 }
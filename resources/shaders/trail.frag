@@ -0,0 +1,14 @@
+#version 400
+
+in vec2 uv; // Input to this fragment shader is the output of tex.vert
+
+uniform sampler2D trailTex; // Last frame's trails
+uniform float decay; // How much of them is left
+
+// Output color vector
+out vec4 fragColor;
+
+void main(void)
+{
+    fragColor = vec4(texture(trailTex, uv).rgb * decay, 1.0);
+}
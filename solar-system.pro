@@ -1,6 +1,7 @@
 QT += core gui opengl
 TARGET = "The Little Prince"
 TEMPLATE = app
+CONFIG += c++11
 
 INCLUDEPATH += src src/data src/lib src/render src/scene src/shapes
 DEPENDPATH += src src/data src/lib src/render src/scene src/shapes
@@ -10,18 +11,37 @@ SOURCES += \
     src/data/ResourceLoader.cpp \
     src/data/Settings.cpp \
     src/data/Window.cpp \
+    src/lib/Noise.cpp \
+    src/render/Benchmark.cpp \
     src/render/FlowersRenderer.cpp \
     src/render/GLRenderWidget.cpp \
+    src/render/MicroBenchmark.cpp \
     src/render/PlanetsRenderer.cpp \
+    src/render/Scene.cpp \
+    src/render/StarSimulation.cpp \
     src/render/StarsRenderer.cpp \
     src/scene/Camera.cpp \
+    src/scene/FlowerField.cpp \
+    src/scene/GardenCuller.cpp \
+    src/scene/GardenMesh.cpp \
+    src/scene/GardenSampler.cpp \
+    src/scene/NBodySystem.cpp \
     src/scene/Particle.cpp \
+    src/scene/PlanetLOD.cpp \
+    src/scene/PlanetMesh.cpp \
+    src/scene/PlanetTerrain.cpp \
+    src/scene/SceneGraph.cpp \
+    src/scene/SimulationClock.cpp \
+    src/scene/SkyGrid.cpp \
+    src/scene/StarField.cpp \
+    src/scene/StarGenerator.cpp \
     src/scene/TexturedQuad.cpp \
     src/scene/Transforms.cpp \
     src/shapes/Cone.cpp \
     src/shapes/Cube.cpp \
+    src/shapes/CubeSphere.cpp \
     src/shapes/Cylinder.cpp \
-    src/shapes/Flower.cpp \
+    src/shapes/IcoSphere.cpp \
     src/shapes/Shape.cpp \
     src/shapes/Sphere.cpp \
     src/main.cpp \
@@ -35,19 +55,41 @@ HEADERS += \
     src/data/Window.h \
     src/lib/GLCommon.h \
     src/lib/GLMath.h \
+    src/lib/Noise.h \
+    src/lib/Parallel.h \
+    src/lib/Random.h \
+    src/lib/SIMD.h \
+    src/render/Benchmark.h \
     src/render/FlowersRenderer.h \
     src/render/GLRenderWidget.h \
+    src/render/MicroBenchmark.h \
     src/render/PlanetsRenderer.h \
     src/render/Renderer.h \
+    src/render/Scene.h \
+    src/render/StarSimulation.h \
     src/render/StarsRenderer.h \
     src/scene/Camera.h \
+    src/scene/FlowerField.h \
+    src/scene/GardenCuller.h \
+    src/scene/GardenMesh.h \
+    src/scene/GardenSampler.h \
+    src/scene/NBodySystem.h \
     src/scene/Particle.h \
+    src/scene/PlanetLOD.h \
+    src/scene/PlanetMesh.h \
+    src/scene/PlanetTerrain.h \
+    src/scene/SceneGraph.h \
+    src/scene/SimulationClock.h \
+    src/scene/SkyGrid.h \
+    src/scene/StarField.h \
+    src/scene/StarGenerator.h \
     src/scene/TexturedQuad.h \
     src/scene/Transforms.h \
     src/shapes/Cone.h \
     src/shapes/Cube.h \
+    src/shapes/CubeSphere.h \
     src/shapes/Cylinder.h \
-    src/shapes/Flower.h \
+    src/shapes/IcoSphere.h \
     src/shapes/Shape.h \
     src/shapes/Sphere.h \
     src/data/PlanetDataParser.h
@@ -62,8 +104,14 @@ DISTFILES +=
 
 # Flags and compile options
 DEFINES += TIXML_USE_STL
+DEFINES += GLM_FORCE_RADIANS # Every file, not just those including GLCommon.h before glm
 QMAKE_CXXFLAGS_RELEASE -= -O2
 QMAKE_CXXFLAGS_RELEASE += -O3
+
+# SSE2 kernels are always built on x86-64, qmake CONFIG+=avx2 builds the 8 wide ones
+avx2 {
+    QMAKE_CXXFLAGS += -mavx2
+}
 QMAKE_CXXFLAGS_WARN_ON -= -Wall
 QMAKE_CXXFLAGS_WARN_ON += -Waddress -Warray-bounds -Wc++0x-compat -Wchar-subscripts -Wformat\
                           -Wmain -Wmissing-braces -Wparentheses -Wreorder -Wreturn-type \
@@ -92,6 +140,8 @@ win32 {
     DEPENDPATH += C:\Users\Aisha\Documents\cs123\glew-1.11.0\include
 }
 unix:!macx {
+    QMAKE_CXXFLAGS += -pthread
+    LIBS += -pthread
     LIBS += -lGLU
     LIBS += -L/course/cs123/lib/glew/glew-1.10.0/lib/release/ -lGLEW
 }
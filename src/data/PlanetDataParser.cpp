@@ -1,7 +1,10 @@
 #include "PlanetDataParser.h"
 #include "ResourceLoader.h"
+#include "Random.h"
 #include <QFile>
 
+#define BELTSTREAM 0x62656c74 // Philox stream of the first belt ("belt"), the rest follow it
+
 /**
  * @brief Create an xml stream reader from the file and parse it right away
  * @param file A filepath to parse
@@ -21,7 +24,7 @@ PlanetDataParser::~PlanetDataParser() {}
  * @brief Gives back list of all resolutions
  * @return
  */
-QList<int> PlanetDataParser::getResolutions() {
+QList<PlanetResolution> PlanetDataParser::getResolutions() {
     return m_resolutions.values();
 }
 
@@ -33,6 +36,51 @@ QHash<QString, PlanetData> PlanetDataParser::getPlanets() {
     return m_planets;
 }
 
+/**
+ * @brief Gives back every planet, then every belt's bodies, as one list
+ * Belt bodies are a pure function of the seed, the belt, and the body's
+ * index, so a seed always makes the same belts.
+ * @param seed The scene seed
+ * @return Planets sorted by name, then each belt's bodies in order
+ */
+QList<PlanetData> PlanetDataParser::getBodies(uint seed) {
+    QList<PlanetData> bodies;
+    QStringList names = m_planets.keys();
+    names.sort();
+    for (int i = 0; i < names.size(); i++) bodies.append(m_planets.value(names.at(i)));
+
+    for (int b = 0; b < m_belts.size(); b++) {
+        const PlanetBelt &belt = m_belts.at(b);
+        Philox random(seed, BELTSTREAM + b);
+        float inner = pow(belt.radius.x, 1.5f), outer = pow(belt.radius.y, 1.5f);
+        for (int i = 0; i < belt.count; i++) {
+            float orbit[4], spin[4];
+            random.uniform(i, 0, orbit);
+            random.uniform(i, 1, spin);
+
+            // Even over the ring's area, with Kepler's third law between the two year lengths
+            float radius = sqrt(glm::mix(belt.radius.x * belt.radius.x, belt.radius.y * belt.radius.y, orbit[1]));
+            float kepler = outer > inner ? (pow(radius, 1.5f) - inner) / (outer - inner) : 0.0f;
+            float angle = orbit[0] * 2.0f * (float)M_PI;
+            float z = spin[1] * 2.0f - 1.0f, around = spin[2] * 2.0f * (float)M_PI;
+
+            PlanetData data = PlanetData();
+            data.name = QString("%1 %2").arg(belt.name).arg(i);
+            data.size = glm::mix(belt.size.x, belt.size.y, orbit[3]);
+            data.tilt = glm::vec3(sqrt(1.0f - z*z) * cos(around), z, sqrt(1.0f - z*z) * sin(around));
+            data.day = glm::mix(belt.day.x, belt.day.y, spin[0]);
+            data.year = glm::mix(belt.year.x, belt.year.y, kepler);
+            data.mass = glm::mix(belt.mass.x, belt.mass.y, spin[3]);
+            data.position = glm::vec3(radius * cos(angle), (orbit[2] * 2.0f - 1.0f) * belt.height, radius * sin(angle));
+            data.color = belt.color;
+            data.resolution = belt.resolution;
+            data.noise = belt.noise;
+            bodies.append(data);
+        }
+    }
+    return bodies;
+}
+
 void PlanetDataParser::parse(QXmlStreamReader &xml) {
     while(!xml.atEnd() && !xml.hasError()) {
         xml.readNext();
@@ -89,6 +137,7 @@ void PlanetDataParser::parseColors(QXmlStreamReader &xml) {
 
 void PlanetDataParser::parseResolutions(QXmlStreamReader &xml) {
     QStringRef name = NULL;
+    PlanetMeshType mesh = MESH_UV;
     while(!xml.atEnd() && !xml.hasError()) {
         xml.readNext();
 
@@ -96,18 +145,39 @@ void PlanetDataParser::parseResolutions(QXmlStreamReader &xml) {
         if (xml.isEndElement() && xml.name() == "resolutions") return;
 
         // Start of an element, so save/delete the name
-        if (xml.isStartElement() && name == NULL) name = xml.name();
+        if (xml.isStartElement() && name == NULL) {
+            name = xml.name();
+            mesh = parseMeshType(xml);
+        }
         else if (xml.isStartElement()) throwError(xml,"Saw extra name: %s", xml.name().toString());
         else if (xml.isEndElement() && xml.name() == name) name = NULL;
 
         // Number! We have all we need
         else if (xml.isCharacters() && !xml.isWhitespace()) {
             if (name == NULL) throwError(xml, "In resolutions, saw a number without a name");
-            else m_resolutions.insert(name.toString(), parseInt(xml));
+            else m_resolutions.insert(name.toString(), PlanetResolution(parseInt(xml), mesh));
         }
     }
 }
 
+/**
+ * @brief Reads the optional mesh attribute of a resolution - uv, ico, or cube
+ * @param xml The reader, at the start of a resolution element
+ * @return The mesh type, MESH_UV if there's no attribute
+ */
+PlanetMeshType PlanetDataParser::parseMeshType(QXmlStreamReader &xml) {
+    PlanetMeshType mesh = MESH_UV;
+    foreach(const QXmlStreamAttribute &attr, xml.attributes()) {
+        QStringRef val = attr.value();
+        if (attr.name() != "mesh") throwError(xml, "Resolutions - Unexpected attribute: %s", attr.name().toString());
+        else if (val == "uv") mesh = MESH_UV;
+        else if (val == "ico") mesh = MESH_ICO;
+        else if (val == "cube") mesh = MESH_CUBE;
+        else throwError(xml, "Unknown mesh type: %s", val.toString());
+    }
+    return mesh;
+}
+
 void PlanetDataParser::parsePlanets(QXmlStreamReader &xml) {
     while(!xml.atEnd() && !xml.hasError()) {
         xml.readNext();
@@ -127,6 +197,7 @@ void PlanetDataParser::parsePlanets(QXmlStreamReader &xml) {
             }
             else throwError(xml,"Unexpected attribute: %s", attr.name().toString());
         }
+        else if (xml.isStartElement() && xml.name() == "belt") parseBelt(xml);
 
         // Problem
         else if (!xml.isWhitespace() && xml.isCharacters()) {
@@ -155,6 +226,7 @@ void PlanetDataParser::parsePlanet(QXmlStreamReader &xml, QString planetName) {
             if (currTag == "tilt") data.tilt = parseVec3(xml);
             else if (currTag == "position") data.position = parseVec3(xml);
             else if (currTag == "color") data.color = parsePlanetColor(xml);
+            else if (currTag == "noise") data.noise = parsePlanetNoise(xml);
             else if (xml.attributes().size() > 0) throwError(xml, "Extra attributes on tag %s", currTag.toString());
         }
         else if (xml.isStartElement()) throwError(xml, "No nesting allowed (planet): %s", xml.name().toString());
@@ -167,11 +239,60 @@ void PlanetDataParser::parsePlanet(QXmlStreamReader &xml, QString planetName) {
             else if (currTag == "size") data.size = parseFloat(xml, text);
             else if (currTag == "dayLength") data.day = parseFloat(xml, text);
             else if (currTag == "yearLength") data.year = parseFloat(xml, text);
+            else if (currTag == "mass") data.mass = parseFloat(xml, text);
             else throwError(xml, "Unexpected token found in planet (%s)", xml.text().toString());
         }
     }
 }
 
+/**
+ * @brief Parses a belt and all its ranges - any range not given keeps its default
+ * @param xml The reader, at the start of a belt element
+ */
+void PlanetDataParser::parseBelt(QXmlStreamReader &xml) {
+    PlanetBelt belt = PlanetBelt();
+    foreach(const QXmlStreamAttribute &attr, xml.attributes()) {
+        if (attr.name() == "name") belt.name = attr.value().toString();
+        else if (attr.name() == "count") belt.count = parseInt(xml, attr.value());
+        else throwError(xml, "Belt - Unexpected attribute: %s", attr.name().toString());
+    }
+    if (belt.count < 0) throwError(xml, "Belt has a negative count (%d)", belt.count);
+
+    QStringRef currTag = NULL;
+    while(!xml.atEnd() && !xml.hasError()) {
+        xml.readNext();
+
+        // Back to planets parser - save data
+        if (xml.isEndElement() && xml.name() == "belt") {
+            m_belts.append(belt);
+            return;
+        }
+
+        // Ranges are min and max attributes
+        else if (xml.isStartElement() && currTag == NULL) {
+            currTag = xml.name();
+            if (currTag == "color") belt.color = parsePlanetColor(xml);
+            else if (currTag == "noise") belt.noise = parsePlanetNoise(xml);
+            else if (currTag == "size") belt.size = parseRange(xml);
+            else if (currTag == "radius") belt.radius = parseRange(xml);
+            else if (currTag == "dayLength") belt.day = parseRange(xml);
+            else if (currTag == "yearLength") belt.year = parseRange(xml);
+            else if (currTag == "mass") belt.mass = parseRange(xml);
+            else if (xml.attributes().size() > 0) throwError(xml, "Extra attributes on tag %s", currTag.toString());
+        }
+        else if (xml.isStartElement()) throwError(xml, "No nesting allowed (belt): %s", xml.name().toString());
+        else if (xml.isEndElement() && xml.name() == currTag) currTag = NULL;
+
+        // Parse other tags
+        else if (!xml.isWhitespace() && xml.isCharacters()) {
+            QStringRef text = xml.text();
+            if (currTag == "resolution") belt.resolution = m_resolutions.value(text.toString());
+            else if (currTag == "height") belt.height = parseFloat(xml, text);
+            else throwError(xml, "Unexpected token found in belt (%s)", xml.text().toString());
+        }
+    }
+}
+
 glm::vec3 PlanetDataParser::parseVec3(QXmlStreamReader &xml, bool only) {
     glm::vec3 v(-1);
     foreach(const QXmlStreamAttribute &attr, xml.attributes()) {
@@ -207,6 +328,22 @@ float PlanetDataParser::parseFloat(QXmlStreamReader &xml, QStringRef ref) {
     return res;
 }
 
+/**
+ * @brief Parses min and max attributes into a range
+ * @param xml The reader, at the start of a range element
+ * @return The range as min, then max
+ */
+glm::vec2 PlanetDataParser::parseRange(QXmlStreamReader &xml) {
+    glm::vec2 range(-1);
+    foreach(const QXmlStreamAttribute &attr, xml.attributes()) {
+        if (attr.name() == "min") range.x = parseFloat(xml, attr.value());
+        else if (attr.name() == "max") range.y = parseFloat(xml, attr.value());
+        else throwError(xml, "Range - Unexpected attribute: %s", attr.name().toString());
+    }
+    if (range.x < 0 || range.y < range.x) throwError(xml, "Range needs 0 <= min <= max (%s)", xml.name().toString());
+    return range;
+}
+
 /**
  * @brief Parses either attributes into a color or text itself into a color
  * @param xml
@@ -248,8 +385,31 @@ PlanetColor PlanetDataParser::parsePlanetColor(QXmlStreamReader &xml) {
     return color;
 }
 
+/**
+ * @brief Reads a planet's noise attributes - basis (perlin or simplex), minOctaves, and maxOctaves
+ * @param xml The reader, at the start of a noise element
+ * @return The noise, with defaults for anything not given
+ */
+PlanetNoise PlanetDataParser::parsePlanetNoise(QXmlStreamReader &xml) {
+    PlanetNoise noise = PlanetNoise();
+    foreach(const QXmlStreamAttribute &attr, xml.attributes()) {
+        QStringRef val = attr.value();
+        QStringRef name = attr.name();
+        if (name == "basis" && val == "perlin") noise.basis = NOISE_PERLIN;
+        else if (name == "basis" && val == "simplex") noise.basis = NOISE_SIMPLEX;
+        else if (name == "basis") throwError(xml, "Unknown noise basis: %s", val.toString());
+        else if (name == "minOctaves") noise.minOctaves = parseInt(xml, val);
+        else if (name == "maxOctaves") noise.maxOctaves = parseInt(xml, val);
+        else throwError(xml, "Noise - Unexpected attribute: %s", name.toString());
+    }
+    if (noise.minOctaves < 1 || noise.maxOctaves > NOISE_MAX_OCTAVES || noise.minOctaves > noise.maxOctaves)
+        throwError(xml, "Noise octaves must be between 1 and %d, min first", NOISE_MAX_OCTAVES);
+    return noise;
+}
+
 void PlanetDataParser::errorBegin() {
     m_planets.clear();
+    m_belts.clear();
     m_resolutions.clear();
     m_colors.clear();
 
@@ -2,6 +2,7 @@
 #define PLANETDATA_H
 
 #include "ResourceLoader.h"
+#include "Noise.h"
 
 /**
  * @brief Represents all data for a color of a planet
@@ -17,6 +18,93 @@ struct PlanetColor {
     float threshold;
 };
 
+/**
+ * @brief How a planet's sphere is tesselated
+ * UV spheres repeat every vertex per triangle and bunch up at the poles.
+ * Icosahedral (geodesic) and cube spheres share vertices through an
+ * element buffer and keep triangles close to the same size.
+ */
+enum PlanetMeshType {
+    MESH_UV,
+    MESH_ICO,
+    MESH_CUBE
+};
+
+/**
+ * @brief A named resolution: how detailed a sphere is and how it's made
+ */
+struct PlanetResolution {
+    /**
+     * @brief Sets up default arguments
+     */
+    PlanetResolution(int detail = 5, PlanetMeshType mesh = MESH_UV) : detail(detail), mesh(mesh) {}
+
+    /**
+     * @brief Same detail and mesh type means the same sphere
+     * @param other The resolution to compare to
+     * @return If both give the same sphere
+     */
+    bool operator==(const PlanetResolution &other) const {
+        return detail == other.detail && mesh == other.mesh;
+    }
+
+    int detail; // Matches the UV sphere's tesselation in both directions
+    PlanetMeshType mesh;
+};
+
+/**
+ * @brief Lets resolutions key a QHash
+ * @param res The resolution to hash
+ * @return A hash of the detail and mesh type
+ */
+inline uint qHash(const PlanetResolution &res) {
+    return qHash(res.detail) ^ ((uint)res.mesh << 24);
+}
+
+/**
+ * @brief How much noise a planet's surface gets and what it's made of
+ * Octaves are picked per mesh from how far apart its vertices are, but
+ * never outside [minOctaves, maxOctaves], so a planet keeps its character
+ * when it's small and doesn't pay for detail it never shows up close.
+ */
+struct PlanetNoise {
+    /**
+     * @brief Sets up default arguments
+     */
+    PlanetNoise() : basis(NOISE_PERLIN), minOctaves(4), maxOctaves(NOISE_MAX_OCTAVES) {}
+
+    /**
+     * @brief Same basis and octave range means the same noise on every mesh
+     * @param other The noise to compare to
+     * @return If both give the same noise
+     */
+    bool operator==(const PlanetNoise &other) const {
+        return basis == other.basis && minOctaves == other.minOctaves && maxOctaves == other.maxOctaves;
+    }
+
+    /**
+     * @brief Picks the noise for vertices this far apart
+     * @param spacing Distance between neighboring vertices on the unit sphere
+     * @return The octaves and basis to bake with
+     */
+    NoiseOptions optionsFor(float spacing) const {
+        return NoiseOptions(Noise::octavesFor(spacing, minOctaves, maxOctaves), basis);
+    }
+
+    NoiseBasis basis;
+    int minOctaves;
+    int maxOctaves;
+};
+
+/**
+ * @brief Lets planet noise key a QHash
+ * @param noise The noise to hash
+ * @return A hash of the basis and octave range
+ */
+inline uint qHash(const PlanetNoise &noise) {
+    return ((uint)noise.basis << 16) ^ ((uint)noise.minOctaves << 8) ^ (uint)noise.maxOctaves;
+}
+
 /**
  * @brief Represents all data for a given planet
  */
@@ -25,7 +113,7 @@ struct PlanetData {
      * @brief Sets up default arguments
      */
     PlanetData() : name(""), size(1), tilt(glm::vec3(0)), day(1), year(1),
-        position(glm::vec3(0)), color(PlanetColor()), resolution(5) {}
+        position(glm::vec3(0)), mass(0), color(PlanetColor()), resolution(PlanetResolution()), noise(PlanetNoise()) {}
 
     QString name;
     float size;
@@ -33,14 +121,45 @@ struct PlanetData {
     float day;
     float year;
     glm::vec3 position;
+    float mass; // A fraction of the mass at the center, only used by --nbody - 0 pulls on nothing
+    PlanetColor color;
+    PlanetResolution resolution;
+    PlanetNoise noise;
+};
+
+/**
+ * @brief A procedural ring of small bodies around the origin
+ * Every body gets its own orbit, spin, and size from these ranges when
+ * the parser is asked for bodies with a seed. Inner bodies orbit faster,
+ * going from the first year length at the inner radius to the second at
+ * the outer one.
+ */
+struct PlanetBelt {
+    /**
+     * @brief Sets up default arguments
+     */
+    PlanetBelt() : name(""), count(0), color(PlanetColor()), resolution(PlanetResolution()), noise(PlanetNoise()),
+        size(glm::vec2(0.1f, 0.3f)), radius(glm::vec2(40, 60)), height(1), day(glm::vec2(5, 20)),
+        year(glm::vec2(100, 200)), mass(glm::vec2(0)) {}
+
+    QString name;
+    int count;
     PlanetColor color;
-    int resolution;
+    PlanetResolution resolution;
+    PlanetNoise noise;
+    glm::vec2 size; // Each range is min, then max
+    glm::vec2 radius;
+    float height; // Bodies are spread this far above and below the orbital plane
+    glm::vec2 day;
+    glm::vec2 year;
+    glm::vec2 mass;
 };
 
 /**
  * @brief Class used to load in/parse planet data
  * Given a file to load in, can create a list of resolutions,
- * a list of colors, and a list of planets separately. Assumes
+ * a list of colors, and a list of planets separately, or every
+ * planet and belt body as one flat list. Assumes
  * formatted correctly - but will print informative errors if
  * wrong
  */
@@ -49,8 +168,9 @@ public:
     PlanetDataParser(const char *file);
     ~PlanetDataParser();
 
-    QList<int> getResolutions();
+    QList<PlanetResolution> getResolutions();
     QHash<QString, PlanetData> getPlanets();
+    QList<PlanetData> getBodies(uint seed);
 
 private:
     void parse(QXmlStreamReader &xml);
@@ -58,21 +178,26 @@ private:
     void parseColors(QXmlStreamReader &xml);
     void parsePlanets(QXmlStreamReader &xml);
     void parsePlanet(QXmlStreamReader &xml, QString planetName);
+    void parseBelt(QXmlStreamReader &xml);
 
     glm::vec3 parseVec3(QXmlStreamReader &xml, bool only = true);
     int parseInt(QXmlStreamReader &xml);
     int parseInt(QXmlStreamReader &xml, QStringRef ref);
     float parseFloat(QXmlStreamReader &xml);
     float parseFloat(QXmlStreamReader &xml, QStringRef ref);
+    glm::vec2 parseRange(QXmlStreamReader &xml);
     PlanetColor parsePlanetColor(QXmlStreamReader &xml);
+    PlanetMeshType parseMeshType(QXmlStreamReader &xml);
+    PlanetNoise parsePlanetNoise(QXmlStreamReader &xml);
 
     void throwError(QXmlStreamReader &xml, const char *msg, QString error = 0);
     void throwError(QXmlStreamReader &xml, const char *msg, int error);
     void errorBegin();
     void errorEnd(QXmlStreamReader &xml);
 
-    QHash<QString, int> m_resolutions; // Need QString for name
+    QHash<QString, PlanetResolution> m_resolutions; // Need QString for name
     QHash<QString, PlanetData> m_planets;
+    QList<PlanetBelt> m_belts; // In file order, so bodies come out the same every time
     QHash<QString, glm::vec4> m_colors; // 4th component is noisebase
 };
 
@@ -56,6 +56,55 @@ GLuint ResourceLoader::loadShaders(const char *vertFile, const char * fragFile){
     return programId;
 }
 
+/**
+ * @brief Loads a vertex shader into a program whose outputs are captured
+ * Used for simulating on the GPU - the varyings are written interleaved, in
+ * order, to whatever is bound to GL_TRANSFORM_FEEDBACK_BUFFER index 0. There's
+ * no fragment shader, so draw with GL_RASTERIZER_DISCARD enabled.
+ * @param vertFile The vertex shader file
+ * @param varyings The names of the outputs to capture
+ * @param numVaryings How many names are in varyings
+ * @return A GLuint representing the program, or 0 if it didn't link
+ */
+GLuint ResourceLoader::loadTransformFeedbackShader(const char *vertFile, const char **varyings, int numVaryings) {
+    GLuint vertShaderID = loadShader(vertFile, GL_VERTEX_SHADER);
+
+    // Varyings have to be set before linking
+    GLuint programId = glCreateProgram();
+    glAttachShader(programId, vertShaderID);
+    glTransformFeedbackVaryings(programId, numVaryings, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(programId);
+    glDeleteShader(vertShaderID);
+
+    if (!checkProgram(programId, vertFile)) {
+        glDeleteProgram(programId);
+        return 0;
+    }
+    return programId;
+}
+
+/**
+ * @brief Checks the link status of a program, printing why if it failed
+ * @param programId The program to check
+ * @param name What to call the program when printing
+ * @return If the program linked
+ */
+bool ResourceLoader::checkProgram(GLuint programId, const char *name) {
+    GLint result = GL_FALSE;
+    int infoSize;
+    glGetProgramiv(programId, GL_LINK_STATUS, &result);
+    glGetProgramiv(programId, GL_INFO_LOG_LENGTH, &infoSize);
+    std::vector<char> programError(std::max(infoSize, int(1)));
+    glGetProgramInfoLog(programId, infoSize, NULL, &programError[0]);
+
+    if (result == GL_TRUE) {
+        fprintf(stdout, "Shader %s linked successfully!\n", name);
+        return true;
+    }
+    fprintf(stdout, "ERROR: %s not linked\n%s\n", name, &programError[0]);
+    return false;
+}
+
 /**
  * @brief Loads a shader in and returns a GLuint for it
  * Based on a filepath and a string representing type of shader,
@@ -7,11 +7,13 @@ class ResourceLoader {
 public:
     ResourceLoader();
     static GLuint loadShaders(const char *vertFile, const char *fragFile);
+    static GLuint loadTransformFeedbackShader(const char *vertFile, const char **varyings, int numVaryings);
     static QString fileToString(const char *file);
     static QString copyFileToLocalData(const char *filePath);
 
 private:
     static GLuint loadShader(const char *file, int type);
+    static bool checkProgram(GLuint programId, const char *name);
 };
 
 #endif // SHADER_H
@@ -22,6 +22,36 @@ public:
     // Gives the next texture
     int getAndIncrementTextureIndex();
 
+    // Seed for all randomly generated scene data (set from the command line)
+    unsigned int seed;
+
+    // Whether stars are stepped on the GPU with transform feedback (set from the command line)
+    bool gpuStarSimulation;
+
+    // Number of stars that never move, 0 for the default (set from the command line)
+    int staticStars;
+
+    // Whether static stars are drawn once per refresh into a cubemap instead of every frame (set from the command line)
+    bool skyCubemap;
+
+    // Whether planet noise is baked on the CPU instead of with transform feedback (set from the command line)
+    bool cpuPlanetNoise;
+
+    // Whether planets cross fade between resolutions instead of switching at once (set from the command line)
+    bool planetLODFade;
+
+    // Whether planets are drawn as chunked quadtree terrain (set from the command line)
+    bool planetTerrain;
+
+    // Whether bodies orbit under each other's gravity instead of in closed form (set from the command line)
+    bool nbodyOrbits;
+
+    // Number of flower gardens on the moon, 0 for the default (set from the command line)
+    int flowerGardens;
+
+    // Whether every flower is baked into one moon-local mesh instead of drawn instanced (set from the command line)
+    bool bakedGarden;
+
 private:
     int textureIndex;
 };
@@ -7,7 +7,9 @@
 #ifndef __CS123COMMON_H__
 #define __CS123COMMON_H__
 
+#ifndef GLM_FORCE_RADIANS
 #define GLM_FORCE_RADIANS
+#endif
 #include "GL/glew.h"
 #include <math.h>
 #include <stdio.h>
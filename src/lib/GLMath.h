@@ -18,6 +18,33 @@ inline float frandN() {
     return (float)rand() / (float)RAND_MAX;
 }
 
+/**
+ * @brief Mixes the bits of an int so nearby inputs give unrelated outputs
+ * Must match hash() in the GPU simulation shaders exactly
+ * @param x Any unsigned int
+ * @return A well mixed unsigned int
+ */
+inline unsigned int hashN(unsigned int x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * @brief Gives a random number in [0,1) that only depends on its arguments
+ * Must match hashRand() in the GPU simulation shaders exactly
+ * @param seed The seed for this run
+ * @param i Usually the index of what's being randomized
+ * @param n A counter, so each call for the same i differs
+ * @return A float in [0,1)
+ */
+inline float hashRandN(unsigned int seed, unsigned int i, unsigned int n) {
+    return (hashN(seed ^ hashN(i ^ hashN(n))) >> 8) / 16777216.0f;
+}
+
 /**
  * @brief Gives the minimum of two numbers
  * @param a The first float
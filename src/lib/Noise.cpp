@@ -0,0 +1,496 @@
+#include "Noise.h"
+#include "Parallel.h"
+#include "SIMD.h"
+
+#include <math.h>
+
+// The period turbulence() repeats over with Perlin noise
+#define TURBULENCE_PERIOD 10.0f
+
+// Simplex noise is scaled so its mean absolute value matches Perlin's
+#define SIMPLEX_SCALE 0.78f
+
+// The rest of noise.vert's main()
+#define NOISE_NORMAL_SCALE 0.73f
+#define NOISE_SCALE (5.6f * -0.018f)
+#define DISTURBANCE_SCALE 0.05f
+#define DISTURBANCE_PERIOD 100.0f
+#define DISPLACEMENT_SCALE 1.5f
+
+// Scalar versions of the SIMD wrappers, so each kernel below is written once for both
+static inline float vadd(float a, float b) { return a + b; }
+static inline float vsub(float a, float b) { return a - b; }
+static inline float vmul(float a, float b) { return a * b; }
+static inline float vdiv(float a, float b) { return a / b; }
+static inline float vfloor(float a) { return floorf(a); }
+static inline float vabs(float a) { return fabsf(a); }
+
+/**
+ * @brief GLSL's step(), 0 below edge and 1 otherwise
+ * @param edge Where the step is
+ * @param x What to compare
+ * @return 0 or 1
+ */
+static inline float vstep(float edge, float x) { return x < edge ? 0.0f : 1.0f; }
+#ifdef SIMD_WIDTH
+static inline vfloat vstep(vfloat edge, vfloat x) { return vand(vge(x, edge), vset1(1.0f)); }
+#endif
+
+/**
+ * @brief GLSL's min() and max()
+ * @param a The first value
+ * @param b The second value
+ * @return The smaller (or larger) of a and b
+ */
+static inline float vmin(float a, float b) { return b < a ? b : a; }
+static inline float vmax(float a, float b) { return a < b ? b : a; }
+#ifdef SIMD_WIDTH
+static inline vfloat vmin(vfloat a, vfloat b) { return vselect(vlt(b, a), b, a); }
+static inline vfloat vmax(vfloat a, vfloat b) { return vselect(vlt(a, b), b, a); }
+#endif
+
+/**
+ * @brief A constant in every lane
+ * @param f The constant
+ * @return f as F
+ */
+template <typename F> static inline F vconst(float f);
+template <> inline float vconst<float>(float f) { return f; }
+#ifdef SIMD_WIDTH
+template <> inline vfloat vconst<vfloat>(float f) { return vset1(f); }
+#endif
+
+/**
+ * @brief GLSL's fract()
+ * @param x Any float
+ * @return x - floor(x)
+ */
+template <typename F>
+static inline F fract(F x) {
+    return vsub(x, vfloor(x));
+}
+
+/**
+ * @brief GLSL's mod() with a constant period
+ * @param x Any float
+ * @param period What to wrap by
+ * @return x - period * floor(x / period)
+ */
+template <typename F>
+static inline F modPeriod(F x, float period) {
+    F y = vconst<F>(period);
+    return vsub(x, vmul(y, vfloor(vdiv(x, y))));
+}
+
+/**
+ * @brief mod289() from noise.vert
+ * @param x Any float
+ * @return x wrapped to [0,289)
+ */
+template <typename F>
+static inline F mod289(F x) {
+    return vsub(x, vmul(vfloor(vmul(x, vconst<F>(1.0f / 289.0f))), vconst<F>(289.0f)));
+}
+
+/**
+ * @brief permute() from noise.vert
+ * @param x Whole numbers in [0,289)
+ * @return A hash of x, also in [0,289)
+ */
+template <typename F>
+static inline F permute(F x) {
+    return mod289(vmul(vadd(vmul(x, vconst<F>(34.0f)), vconst<F>(1.0f)), x));
+}
+
+/**
+ * @brief GLSL's mix()
+ * @param a Value at t = 0
+ * @param b Value at t = 1
+ * @param t How far from a to b
+ * @return a * (1 - t) + b * t
+ */
+template <typename F>
+static inline F mix(F a, F b, F t) {
+    return vadd(vmul(a, vsub(vconst<F>(1.0f), t)), vmul(b, t));
+}
+
+/**
+ * @brief fade() from noise.vert
+ * @param t Fractional position in a cell
+ * @return The quintic fade curve at t
+ */
+template <typename F>
+static inline F fade(F t) {
+    F curve = vadd(vmul(t, vsub(vmul(t, vconst<F>(6.0f)), vconst<F>(15.0f))), vconst<F>(10.0f));
+    return vmul(vmul(vmul(t, t), t), curve);
+}
+
+/**
+ * @brief One corner's contribution, from its hash down to the dot product
+ * noise.vert does this for four corners at a time in vec4s, but every
+ * step is per corner, so it's the same arithmetic in the same order.
+ * @param hash The permuted corner hash (a component of ixy0 or ixy1)
+ * @param px Offset from the corner in x
+ * @param py Offset from the corner in y
+ * @param pz Offset from the corner in z
+ * @return The normalized gradient dotted with the offset
+ */
+template <typename F>
+static inline F corner(F hash, F px, F py, F pz) {
+    F gx = vmul(hash, vconst<F>(1.0f / 7.0f));
+    F gy = vsub(fract(vmul(vfloor(gx), vconst<F>(1.0f / 7.0f))), vconst<F>(0.5f));
+    gx = fract(gx);
+    F gz = vsub(vsub(vconst<F>(0.5f), vabs(gx)), vabs(gy));
+    F sz = vstep(gz, vconst<F>(0.0f));
+    gx = vsub(gx, vmul(sz, vsub(vstep(vconst<F>(0.0f), gx), vconst<F>(0.5f))));
+    gy = vsub(gy, vmul(sz, vsub(vstep(vconst<F>(0.0f), gy), vconst<F>(0.5f))));
+
+    // taylorInvSqrt
+    F lengthSq = vadd(vadd(vmul(gx, gx), vmul(gy, gy)), vmul(gz, gz));
+    F norm = vsub(vconst<F>(1.79284291400159f), vmul(vconst<F>(0.85373472095314f), lengthSq));
+    return vadd(vadd(vmul(vmul(gx, norm), px), vmul(vmul(gy, norm), py)), vmul(vmul(gz, norm), pz));
+}
+
+/**
+ * @brief pnoise() from noise.vert for one point per lane
+ * @param x The x coordinates
+ * @param y The y coordinates
+ * @param z The z coordinates
+ * @param rep The period on each axis
+ * @return Noise in about [-1,1]
+ */
+template <typename F>
+static F pnoiseT(F x, F y, F z, glm::vec3 rep) {
+    // Integer parts, wrapped to the period, then to 289
+    F ix0 = modPeriod(vfloor(x), rep.x);
+    F iy0 = modPeriod(vfloor(y), rep.y);
+    F iz0 = modPeriod(vfloor(z), rep.z);
+    F ix1 = mod289(modPeriod(vadd(ix0, vconst<F>(1.0f)), rep.x));
+    F iy1 = mod289(modPeriod(vadd(iy0, vconst<F>(1.0f)), rep.y));
+    F iz1 = mod289(modPeriod(vadd(iz0, vconst<F>(1.0f)), rep.z));
+    ix0 = mod289(ix0);
+    iy0 = mod289(iy0);
+    iz0 = mod289(iz0);
+
+    // Fractional parts, from each side of the cell
+    F fx0 = fract(x), fy0 = fract(y), fz0 = fract(z);
+    F fx1 = vsub(fx0, vconst<F>(1.0f));
+    F fy1 = vsub(fy0, vconst<F>(1.0f));
+    F fz1 = vsub(fz0, vconst<F>(1.0f));
+
+    // ixy, one corner of the xy face at a time
+    F px0 = permute(ix0), px1 = permute(ix1);
+    F h00 = permute(vadd(px0, iy0));
+    F h10 = permute(vadd(px1, iy0));
+    F h01 = permute(vadd(px0, iy1));
+    F h11 = permute(vadd(px1, iy1));
+
+    F n000 = corner(permute(vadd(h00, iz0)), fx0, fy0, fz0);
+    F n100 = corner(permute(vadd(h10, iz0)), fx1, fy0, fz0);
+    F n010 = corner(permute(vadd(h01, iz0)), fx0, fy1, fz0);
+    F n110 = corner(permute(vadd(h11, iz0)), fx1, fy1, fz0);
+    F n001 = corner(permute(vadd(h00, iz1)), fx0, fy0, fz1);
+    F n101 = corner(permute(vadd(h10, iz1)), fx1, fy0, fz1);
+    F n011 = corner(permute(vadd(h01, iz1)), fx0, fy1, fz1);
+    F n111 = corner(permute(vadd(h11, iz1)), fx1, fy1, fz1);
+
+    // Blend along z, then y, then x
+    F fadeX = fade(fx0), fadeY = fade(fy0), fadeZ = fade(fz0);
+    F nz0 = mix(n000, n001, fadeZ);
+    F nz1 = mix(n100, n101, fadeZ);
+    F nz2 = mix(n010, n011, fadeZ);
+    F nz3 = mix(n110, n111, fadeZ);
+    F nyz0 = mix(nz0, nz2, fadeY);
+    F nyz1 = mix(nz1, nz3, fadeY);
+    return vmul(vconst<F>(2.2f), mix(nyz0, nyz1, fadeX));
+}
+
+/**
+ * @brief One simplex corner's contribution, from its hash down to the falloff
+ * Per corner steps of snoise() in noise.vert, which does all four at once.
+ * @param hash The permuted corner hash (a component of p)
+ * @param px Offset from the corner in x
+ * @param py Offset from the corner in y
+ * @param pz Offset from the corner in z
+ * @return The normalized gradient dotted with the offset, times the falloff
+ */
+template <typename F>
+static inline F simplexCorner(F hash, F px, F py, F pz) {
+    // ns = (2/7, 0.5/7 - 1, 1/7), gradients on a 7x7 grid
+    F j = vsub(hash, vmul(vconst<F>(49.0f), vfloor(vmul(vmul(hash, vconst<F>(1.0f / 7.0f)), vconst<F>(1.0f / 7.0f)))));
+    F gridX = vfloor(vmul(j, vconst<F>(1.0f / 7.0f)));
+    F gridY = vfloor(vsub(j, vmul(vconst<F>(7.0f), gridX)));
+    F gx = vadd(vmul(gridX, vconst<F>(2.0f / 7.0f)), vconst<F>(0.5f / 7.0f - 1.0f));
+    F gy = vadd(vmul(gridY, vconst<F>(2.0f / 7.0f)), vconst<F>(0.5f / 7.0f - 1.0f));
+    F gz = vsub(vsub(vconst<F>(1.0f), vabs(gx)), vabs(gy));
+    F sh = vsub(vconst<F>(0.0f), vstep(gz, vconst<F>(0.0f)));
+    gx = vadd(gx, vmul(vadd(vmul(vfloor(gx), vconst<F>(2.0f)), vconst<F>(1.0f)), sh));
+    gy = vadd(gy, vmul(vadd(vmul(vfloor(gy), vconst<F>(2.0f)), vconst<F>(1.0f)), sh));
+
+    // taylorInvSqrt, then the radial falloff
+    F lengthSq = vadd(vadd(vmul(gx, gx), vmul(gy, gy)), vmul(gz, gz));
+    F norm = vsub(vconst<F>(1.79284291400159f), vmul(vconst<F>(0.85373472095314f), lengthSq));
+    F m = vmax(vsub(vconst<F>(0.6f), vadd(vadd(vmul(px, px), vmul(py, py)), vmul(pz, pz))), vconst<F>(0.0f));
+    m = vmul(m, m);
+    F dot = vadd(vadd(vmul(vmul(gx, norm), px), vmul(vmul(gy, norm), py)), vmul(vmul(gz, norm), pz));
+    return vmul(vmul(m, m), dot);
+}
+
+/**
+ * @brief snoise() from noise.vert for one point per lane
+ * 3D simplex noise (Gustavson and McEwan's, as in noise.vert), times SIMPLEX_SCALE.
+ * @param x The x coordinates
+ * @param y The y coordinates
+ * @param z The z coordinates
+ * @return Noise in about [-1,1]
+ */
+template <typename F>
+static F snoiseT(F x, F y, F z) {
+    // First corner, on the skewed grid
+    F third = vconst<F>(1.0f / 3.0f), sixth = vconst<F>(1.0f / 6.0f);
+    F skew = vadd(vadd(vmul(x, third), vmul(y, third)), vmul(z, third));
+    F ix = vfloor(vadd(x, skew)), iy = vfloor(vadd(y, skew)), iz = vfloor(vadd(z, skew));
+    F unskew = vadd(vadd(vmul(ix, sixth), vmul(iy, sixth)), vmul(iz, sixth));
+    F x0 = vadd(vsub(x, ix), unskew), y0 = vadd(vsub(y, iy), unskew), z0 = vadd(vsub(z, iz), unskew);
+
+    // The other corners, by which way the point leans
+    F gx = vstep(y0, x0), gy = vstep(z0, y0), gz = vstep(x0, z0);
+    F one = vconst<F>(1.0f);
+    F lx = vsub(one, gx), ly = vsub(one, gy), lz = vsub(one, gz);
+    F i1x = vmin(gx, lz), i1y = vmin(gy, lx), i1z = vmin(gz, ly);
+    F i2x = vmax(gx, lz), i2y = vmax(gy, lx), i2z = vmax(gz, ly);
+    F x1 = vadd(vsub(x0, i1x), sixth), y1 = vadd(vsub(y0, i1y), sixth), z1 = vadd(vsub(z0, i1z), sixth);
+    F x2 = vadd(vsub(x0, i2x), third), y2 = vadd(vsub(y0, i2y), third), z2 = vadd(vsub(z0, i2z), third);
+    F half = vconst<F>(0.5f);
+    F x3 = vsub(x0, half), y3 = vsub(y0, half), z3 = vsub(z0, half);
+
+    // Hash each corner, z first like noise.vert
+    ix = mod289(ix);
+    iy = mod289(iy);
+    iz = mod289(iz);
+    F zero = vconst<F>(0.0f);
+    F h0 = permute(vadd(vadd(permute(vadd(vadd(permute(vadd(iz, zero)), iy), zero)), ix), zero));
+    F h1 = permute(vadd(vadd(permute(vadd(vadd(permute(vadd(iz, i1z)), iy), i1y)), ix), i1x));
+    F h2 = permute(vadd(vadd(permute(vadd(vadd(permute(vadd(iz, i2z)), iy), i2y)), ix), i2x));
+    F h3 = permute(vadd(vadd(permute(vadd(vadd(permute(vadd(iz, one)), iy), one)), ix), one));
+
+    F sum = vadd(vadd(simplexCorner(h0, x0, y0, z0), simplexCorner(h1, x1, y1, z1)),
+                 vadd(simplexCorner(h2, x2, y2, z2), simplexCorner(h3, x3, y3, z3)));
+    return vmul(vconst<F>(42.0f * SIMPLEX_SCALE), sum);
+}
+
+/**
+ * @brief The noise basis in options, at one point per lane
+ * @param x The x coordinates
+ * @param y The y coordinates
+ * @param z The z coordinates
+ * @param rep The period on each axis, only used by Perlin
+ * @param options Which basis to use
+ * @return Noise in about [-1,1]
+ */
+template <typename F>
+static inline F basisT(F x, F y, F z, glm::vec3 rep, NoiseOptions options) {
+    return options.basis == NOISE_SIMPLEX ? snoiseT(x, y, z) : pnoiseT(x, y, z, rep);
+}
+
+/**
+ * @brief turbulence() from noise.vert for one point per lane
+ * Each octave doubles the last one's frequency with a multiply, like the shader.
+ * @param x The x coordinates
+ * @param y The y coordinates
+ * @param z The z coordinates
+ * @param options How many octaves to sum, and of which basis
+ * @return Summed absolute noise over every octave
+ */
+template <typename F>
+static F turbulenceT(F x, F y, F z, NoiseOptions options) {
+    glm::vec3 period(TURBULENCE_PERIOD);
+    F t = vconst<F>(-0.5f);
+    float power = 1.0f;
+    for (int f = 1; f <= options.octaves; f++) {
+        power *= 2.0f;
+        F p = vconst<F>(power);
+        F n = basisT(vmul(p, x), vmul(p, y), vmul(p, z), period, options);
+        t = vadd(t, vabs(vdiv(n, p)));
+    }
+    return t;
+}
+
+/**
+ * @brief noise.vert's main() for one vertex per lane
+ * @param px Position x, replaced with the displaced position
+ * @param py Position y, replaced with the displaced position
+ * @param pz Position z, replaced with the displaced position
+ * @param nx Normal x
+ * @param ny Normal y
+ * @param nz Normal z
+ * @param seed The planet seed
+ * @param options How many octaves to sum, and of which basis
+ * @return The noise value
+ */
+template <typename F>
+static F bakeVertexT(F &px, F &py, F &pz, F nx, F ny, F nz, float seed, NoiseOptions options) {
+    F scale = vconst<F>(NOISE_NORMAL_SCALE), offset = vconst<F>(seed);
+    F noise = vmul(vconst<F>(NOISE_SCALE), turbulenceT(vadd(vmul(scale, nx), offset), vadd(vmul(scale, ny), offset),
+                                                       vadd(vmul(scale, nz), offset), options));
+    F disturbanceScale = vconst<F>(DISTURBANCE_SCALE);
+    F disturbance = basisT(vmul(disturbanceScale, px), vmul(disturbanceScale, py), vmul(disturbanceScale, pz),
+                           glm::vec3(DISTURBANCE_PERIOD), options);
+    F displacement = vadd(vmul(vconst<F>(DISPLACEMENT_SCALE), noise), disturbance);
+
+    px = vadd(px, vmul(nx, displacement));
+    py = vadd(py, vmul(ny, displacement));
+    pz = vadd(pz, vmul(nz, displacement));
+    return noise;
+}
+
+/**
+ * @brief Bakes one vertex on its own
+ * @param vertex NOISE_VERTEX_FLOATS floats: position, then normal
+ * @param seed The planet seed
+ * @param out Room for NOISE_BAKED_FLOATS floats
+ * @param options How many octaves to sum, and of which basis
+ */
+static inline void bakeVertex(const float *vertex, float seed, float *out, NoiseOptions options) {
+    float x = vertex[0], y = vertex[1], z = vertex[2];
+    out[3] = bakeVertexT(x, y, z, vertex[3], vertex[4], vertex[5], seed, options);
+    out[0] = x;
+    out[1] = y;
+    out[2] = z;
+}
+
+/**
+ * @brief Classic Perlin noise that repeats, exactly as pnoise() in noise.vert
+ * @param p Where to sample
+ * @param rep The period on each axis
+ * @return Noise in about [-1,1]
+ */
+float Noise::pnoise(glm::vec3 p, glm::vec3 rep) {
+    return pnoiseT(p.x, p.y, p.z, rep);
+}
+
+/**
+ * @brief Simplex noise, exactly as snoise() in noise.vert
+ * @param p Where to sample
+ * @return Noise in about [-1,1]
+ */
+float Noise::snoise(glm::vec3 p) {
+    return snoiseT(p.x, p.y, p.z);
+}
+
+/**
+ * @brief Octaves of absolute noise, exactly as turbulence() in noise.vert
+ * @param p Where to sample
+ * @param options How many octaves to sum, and of which basis
+ * @return The summed noise
+ */
+float Noise::turbulence(glm::vec3 p, NoiseOptions options) {
+    return turbulenceT(p.x, p.y, p.z, options);
+}
+
+/**
+ * @brief turbulence() for many points, SIMD_WIDTH at a time on every core
+ * @param x The x coordinates
+ * @param y The y coordinates
+ * @param z The z coordinates
+ * @param count The number of points
+ * @param out Room for count floats
+ * @param threads How many threads to use, 0 for all of them
+ * @param options How many octaves to sum, and of which basis
+ */
+void Noise::turbulence(const float *x, const float *y, const float *z, int count, float *out, int threads,
+                       NoiseOptions options) {
+    parallelFor(count, [=](int begin, int end) {
+        int i = begin;
+#ifdef SIMD_WIDTH
+        for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+            vfloat result = turbulenceT(vloadu(x + i), vloadu(y + i), vloadu(z + i), options);
+            vstoreu(out + i, result);
+        }
+#endif
+        for (; i < end; i++) out[i] = turbulenceT(x[i], y[i], z[i], options);
+    }, threads);
+}
+
+/**
+ * @brief Does everything noise.vert does, SIMD_WIDTH vertices at a time on every core
+ * @param vertices NOISE_VERTEX_FLOATS floats per vertex: position, then normal
+ * @param count The number of vertices
+ * @param seed The planet seed
+ * @param out Room for NOISE_BAKED_FLOATS floats per vertex: displaced position, then noise
+ * @param threads How many threads to use, 0 for all of them
+ * @param options How many octaves to sum, and of which basis
+ */
+void Noise::bakePlanet(const float *vertices, int count, float seed, float *out, int threads, NoiseOptions options) {
+    parallelFor(count, [=](int begin, int end) {
+        int i = begin;
+#ifdef SIMD_WIDTH
+        // Vertices are interleaved, so gather them into lanes first
+        float lanes[NOISE_VERTEX_FLOATS][SIMD_WIDTH];
+        float noise[SIMD_WIDTH];
+        for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+            for (int lane = 0; lane < SIMD_WIDTH; lane++) {
+                const float *vertex = vertices + (i + lane) * NOISE_VERTEX_FLOATS;
+                for (int f = 0; f < NOISE_VERTEX_FLOATS; f++) lanes[f][lane] = vertex[f];
+            }
+            vfloat px = vloadu(lanes[0]), py = vloadu(lanes[1]), pz = vloadu(lanes[2]);
+            vstoreu(noise, bakeVertexT(px, py, pz, vloadu(lanes[3]), vloadu(lanes[4]), vloadu(lanes[5]), seed,
+                                       options));
+            vstoreu(lanes[0], px);
+            vstoreu(lanes[1], py);
+            vstoreu(lanes[2], pz);
+            for (int lane = 0; lane < SIMD_WIDTH; lane++) {
+                float *baked = out + (i + lane) * NOISE_BAKED_FLOATS;
+                baked[0] = lanes[0][lane];
+                baked[1] = lanes[1][lane];
+                baked[2] = lanes[2][lane];
+                baked[3] = noise[lane];
+            }
+        }
+#endif
+        for (; i < end; i++) {
+            bakeVertex(vertices + i * NOISE_VERTEX_FLOATS, seed, out + i * NOISE_BAKED_FLOATS, options);
+        }
+    }, threads);
+}
+
+/**
+ * @brief The one vertex at a time, one thread reference for bakePlanet
+ * @param vertices NOISE_VERTEX_FLOATS floats per vertex: position, then normal
+ * @param count The number of vertices
+ * @param seed The planet seed
+ * @param out Room for NOISE_BAKED_FLOATS floats per vertex: displaced position, then noise
+ * @param options How many octaves to sum, and of which basis
+ */
+void Noise::bakePlanetScalar(const float *vertices, int count, float seed, float *out, NoiseOptions options) {
+    for (int i = 0; i < count; i++) {
+        bakeVertex(vertices + i * NOISE_VERTEX_FLOATS, seed, out + i * NOISE_BAKED_FLOATS, options);
+    }
+}
+
+/**
+ * @brief Picks how many octaves vertices this far apart can show without aliasing
+ * Octave f has about NOISE_NORMAL_SCALE * 2^f cells per unit on the sphere,
+ * and a cell needs at least two vertices across it, so anything finer only
+ * adds noise that depends on where the vertices happen to land.
+ * @param spacing Distance between neighboring vertices on the unit sphere
+ * @param minOctaves Fewest octaves to sum, for the planet's character
+ * @param maxOctaves Most octaves to sum, at most NOISE_MAX_OCTAVES
+ * @return The octave count
+ */
+int Noise::octavesFor(float spacing, int minOctaves, int maxOctaves) {
+    int octaves = (int)floorf(log2f(1.0f / (2.0f * NOISE_NORMAL_SCALE * spacing)));
+    return glm::clamp(octaves, glm::max(1, minOctaves), glm::min(maxOctaves, NOISE_MAX_OCTAVES));
+}
+
+/**
+ * @brief Returns how many points each SIMD iteration handles
+ * @return 8 with AVX2, 4 with SSE2, 1 otherwise
+ */
+int Noise::width() {
+#ifdef SIMD_WIDTH
+    return SIMD_WIDTH;
+#else
+    return 1;
+#endif
+}
@@ -0,0 +1,69 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <glm/glm.hpp>
+
+// Floats per vertex read by bakePlanet (position, normal) and written by it (position, noise)
+#define NOISE_VERTEX_FLOATS 6
+#define NOISE_BAKED_FLOATS 4
+
+// Octaves turbulence() sums at most - what noise.vert always did before octaves could be chosen
+#define NOISE_MAX_OCTAVES 10
+
+/**
+ * @brief Which gradient noise turbulence and the disturbance are built from
+ */
+enum NoiseBasis {
+    NOISE_PERLIN, // Classic Perlin that repeats, the original look
+    NOISE_SIMPLEX // Simplex, 4 corners instead of 8, scaled to about the same spread
+};
+
+/**
+ * @brief How a planet's noise is made, the same as noise.vert's octaves and simplex uniforms
+ */
+struct NoiseOptions {
+    /**
+     * @brief Sets up default arguments - the original 10 Perlin octaves
+     */
+    explicit NoiseOptions(int octaves = NOISE_MAX_OCTAVES, NoiseBasis basis = NOISE_PERLIN)
+        : octaves(octaves), basis(basis) {}
+
+    int octaves;
+    NoiseBasis basis;
+};
+
+/**
+ * @brief CPU port of the classic Perlin noise in noise.vert
+ * Every function does exactly what the shader does, step for step, so
+ * planets can be made, queried, and previewed without a GL context, and
+ * shader changes have something to be checked against. The batch
+ * functions work on 8 (AVX2) or 4 (SSE2) points at a time on every core,
+ * and give bit-identical results to the one point versions. Octaves past
+ * what a mesh's vertices can sample only add aliasing, so octavesFor()
+ * picks how many are worth working out.
+ */
+class Noise {
+public:
+    // pnoise(), snoise() and turbulence() from noise.vert, one point at a time
+    static float pnoise(glm::vec3 p, glm::vec3 rep);
+    static float snoise(glm::vec3 p);
+    static float turbulence(glm::vec3 p, NoiseOptions options = NoiseOptions());
+
+    // turbulence() for count points stored as separate x, y, z arrays
+    static void turbulence(const float *x, const float *y, const float *z, int count, float *out, int threads = 0,
+                           NoiseOptions options = NoiseOptions());
+
+    // noise.vert's main() for count vertices laid out like Shape's
+    static void bakePlanet(const float *vertices, int count, float seed, float *out, int threads = 0,
+                           NoiseOptions options = NoiseOptions());
+    static void bakePlanetScalar(const float *vertices, int count, float seed, float *out,
+                                 NoiseOptions options = NoiseOptions());
+
+    // Octaves worth summing for vertices this far apart on the unit sphere
+    static int octavesFor(float spacing, int minOctaves, int maxOctaves);
+
+    // Number of points handled per SIMD iteration
+    static int width();
+};
+
+#endif // NOISE_H
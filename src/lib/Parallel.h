@@ -0,0 +1,48 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Loops shorter than this aren't worth starting threads for
+#define PARALLEL_MIN_ITEMS 4096
+
+/**
+ * @brief Returns how many threads parallelFor uses by default
+ * @return The number of hardware threads, at least 1
+ */
+inline int parallelThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Splits [0, count) into contiguous chunks and runs body on each on its own thread
+ * Returns once every chunk is done. The calling thread does the first chunk
+ * itself. body must only write to what its own range owns.
+ * @param count The number of items
+ * @param body Called as body(begin, end) for each chunk
+ * @param threads How many threads to use, 0 for parallelThreadCount()
+ * @param minItems Fewest items worth a thread - lower for items that are each a lot of work
+ */
+template <typename Body>
+void parallelFor(int count, Body body, int threads = 0, int minItems = PARALLEL_MIN_ITEMS) {
+    if (threads <= 0) threads = parallelThreadCount();
+    threads = std::min(threads, std::max(1, count / minItems));
+    if (threads <= 1) {
+        if (count > 0) body(0, count);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    int chunk = (count + threads - 1) / threads;
+    for (int t = 1; t < threads; t++) {
+        int begin = t * chunk;
+        int end = std::min(count, begin + chunk);
+        if (begin < end) workers.push_back(std::thread(body, begin, end));
+    }
+    body(0, std::min(count, chunk));
+    for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,62 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+/**
+ * @brief Counter based random numbers (Philox4x32-10)
+ * There's no state to advance: the same key and counter always give the
+ * same four numbers. Anything random about item i can come from the
+ * counter (i, n, ...), so items can be made in any order, on any number
+ * of threads, and still come out bit for bit the same.
+ */
+class Philox {
+public:
+    /**
+     * @brief Sets up a stream of numbers for a seed
+     * @param seed Picks the stream
+     * @param stream A second seed, so different uses of one seed don't overlap
+     */
+    Philox(uint32_t seed, uint32_t stream = 0) {
+        m_key[0] = seed;
+        m_key[1] = stream;
+    }
+
+    /**
+     * @brief Gives the four numbers at a counter
+     * @param c0 Usually an index
+     * @param c1 Usually which set of numbers for that index
+     * @param out Filled in with four well mixed unsigned ints
+     */
+    void generate(uint32_t c0, uint32_t c1, uint32_t out[4]) const {
+        uint32_t c[4] = { c0, c1, 0, 0 };
+        uint32_t k0 = m_key[0], k1 = m_key[1];
+        for (int round = 0; round < 10; round++) {
+            uint64_t p0 = (uint64_t)0xD2511F53U * c[0];
+            uint64_t p1 = (uint64_t)0xCD9E8D57U * c[2];
+            uint32_t next[4] = { (uint32_t)(p1 >> 32) ^ c[1] ^ k0, (uint32_t)p1,
+                                 (uint32_t)(p0 >> 32) ^ c[3] ^ k1, (uint32_t)p0 };
+            c[0] = next[0]; c[1] = next[1]; c[2] = next[2]; c[3] = next[3];
+            k0 += 0x9E3779B9U;
+            k1 += 0xBB67AE85U;
+        }
+        out[0] = c[0]; out[1] = c[1]; out[2] = c[2]; out[3] = c[3];
+    }
+
+    /**
+     * @brief Gives four floats at a counter
+     * @param c0 Usually an index
+     * @param c1 Usually which set of numbers for that index
+     * @param out Filled in with four floats in [0,1)
+     */
+    void uniform(uint32_t c0, uint32_t c1, float out[4]) const {
+        uint32_t bits[4];
+        generate(c0, c1, bits);
+        for (int i = 0; i < 4; i++) out[i] = (bits[i] >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    uint32_t m_key[2];
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,99 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Thin wrappers so kernels are written once for every instruction set.
+// SIMD_WIDTH is 8 with AVX2, 4 with SSE2, and left undefined otherwise.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_WIDTH 8
+typedef __m256 vfloat;
+typedef __m256i vint;
+static inline vfloat vload(const float *p) { return _mm256_load_ps(p); }
+static inline void vstore(float *p, vfloat v) { _mm256_store_ps(p, v); }
+static inline vfloat vloadu(const float *p) { return _mm256_loadu_ps(p); }
+static inline void vstoreu(float *p, vfloat v) { _mm256_storeu_ps(p, v); }
+static inline vfloat vset1(float f) { return _mm256_set1_ps(f); }
+static inline vfloat vadd(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+static inline vfloat vmul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+static inline vfloat vand(vfloat a, vfloat b) { return _mm256_and_ps(a, b); }
+static inline vfloat vor(vfloat a, vfloat b) { return _mm256_or_ps(a, b); }
+static inline vfloat vxor(vfloat a, vfloat b) { return _mm256_xor_ps(a, b); }
+static inline vfloat vle(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static inline vfloat vge(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+static inline vfloat vgt(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline vfloat vlt(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline vfloat vselect(vfloat mask, vfloat a, vfloat b) { return _mm256_blendv_ps(b, a, mask); }
+static inline int vmask(vfloat mask) { return _mm256_movemask_ps(mask); }
+static inline vint viset1(unsigned int x) { return _mm256_set1_epi32((int)x); }
+static inline vint viramp() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+static inline vint viadd(vint a, vint b) { return _mm256_add_epi32(a, b); }
+static inline vint vixor(vint a, vint b) { return _mm256_xor_si256(a, b); }
+static inline vint vimul(vint a, vint b) { return _mm256_mullo_epi32(a, b); }
+static inline vint vishift8(vint a) { return _mm256_srli_epi32(a, 8); }
+static inline vint vishift15(vint a) { return _mm256_srli_epi32(a, 15); }
+static inline vint vishift16(vint a) { return _mm256_srli_epi32(a, 16); }
+static inline vfloat vitof(vint a) { return _mm256_cvtepi32_ps(a); }
+static inline vfloat vsub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+static inline vfloat vdiv(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+static inline vfloat vsqrt(vfloat a) { return _mm256_sqrt_ps(a); }
+static inline vfloat vfloor(vfloat a) { return _mm256_floor_ps(a); }
+static inline vfloat vabs(vfloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+#define SIMD_WIDTH 4
+typedef __m128 vfloat;
+typedef __m128i vint;
+static inline vfloat vload(const float *p) { return _mm_load_ps(p); }
+static inline void vstore(float *p, vfloat v) { _mm_store_ps(p, v); }
+static inline vfloat vloadu(const float *p) { return _mm_loadu_ps(p); }
+static inline void vstoreu(float *p, vfloat v) { _mm_storeu_ps(p, v); }
+static inline vfloat vset1(float f) { return _mm_set1_ps(f); }
+static inline vfloat vadd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+static inline vfloat vmul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+static inline vfloat vand(vfloat a, vfloat b) { return _mm_and_ps(a, b); }
+static inline vfloat vor(vfloat a, vfloat b) { return _mm_or_ps(a, b); }
+static inline vfloat vxor(vfloat a, vfloat b) { return _mm_xor_ps(a, b); }
+static inline vfloat vle(vfloat a, vfloat b) { return _mm_cmple_ps(a, b); }
+static inline vfloat vge(vfloat a, vfloat b) { return _mm_cmpge_ps(a, b); }
+static inline vfloat vgt(vfloat a, vfloat b) { return _mm_cmpgt_ps(a, b); }
+static inline vfloat vlt(vfloat a, vfloat b) { return _mm_cmplt_ps(a, b); }
+static inline vfloat vselect(vfloat mask, vfloat a, vfloat b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline int vmask(vfloat mask) { return _mm_movemask_ps(mask); }
+static inline vint viset1(unsigned int x) { return _mm_set1_epi32((int)x); }
+static inline vint viramp() { return _mm_setr_epi32(0, 1, 2, 3); }
+static inline vint viadd(vint a, vint b) { return _mm_add_epi32(a, b); }
+static inline vint vixor(vint a, vint b) { return _mm_xor_si128(a, b); }
+static inline vint vimul(vint a, vint b) {
+#ifdef __SSE4_1__
+    return _mm_mullo_epi32(a, b);
+#else
+    // SSE2 only multiplies lanes 0 and 2, so do the odd lanes separately and interleave
+    vint even = _mm_mul_epu32(a, b);
+    vint odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+static inline vint vishift8(vint a) { return _mm_srli_epi32(a, 8); }
+static inline vint vishift15(vint a) { return _mm_srli_epi32(a, 15); }
+static inline vint vishift16(vint a) { return _mm_srli_epi32(a, 16); }
+static inline vfloat vitof(vint a) { return _mm_cvtepi32_ps(a); }
+static inline vfloat vsub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+static inline vfloat vdiv(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+static inline vfloat vsqrt(vfloat a) { return _mm_sqrt_ps(a); }
+static inline vfloat vfloor(vfloat a) {
+#ifdef __SSE4_1__
+    return _mm_floor_ps(a);
+#else
+    // Truncate, then step down where that rounded up - fine for anything that fits in an int
+    vfloat t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+#endif
+}
+static inline vfloat vabs(vfloat a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+#endif
+
+#endif // SIMD_H
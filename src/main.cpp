@@ -1,9 +1,84 @@
 #include <QApplication>
+#include <QCommandLineParser>
 #include "Window.h"
+#include "Benchmark.h"
+#include "MicroBenchmark.h"
+#include "Settings.h"
+
+/**
+ * @brief Reads benchmark options from the command line, keeping defaults for anything unset
+ * @param parser A parser that has already processed the arguments
+ * @return The options for the headless benchmark
+ */
+static BenchmarkOptions parseBenchmarkOptions(const QCommandLineParser &parser) {
+    BenchmarkOptions options;
+    if (parser.isSet("frames")) options.frames = parser.value("frames").toInt();
+    if (parser.isSet("warmup")) options.warmup = parser.value("warmup").toInt();
+    if (parser.isSet("step")) options.step = parser.value("step").toFloat();
+    if (parser.isSet("report")) options.report = parser.value("report");
+    if (parser.isSet("size")) {
+        QStringList dims = parser.value("size").split('x');
+        if (dims.size() == 2) options.size = glm::vec2(dims.at(0).toInt(), dims.at(1).toInt());
+    }
+    return options;
+}
 
 int main(int argc, char *argv[])
 {
+    // Headless runs default to the offscreen platform so no window is shown - it still needs X for GLX
+    for (int i = 1; i < argc; i++) {
+        bool headless = strcmp(argv[i], "--headless") == 0 || strcmp(argv[i], "--micro") == 0;
+        if (headless && qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+    }
+
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("The Little Prince");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"headless", "Render offscreen without a window and write a timing report."},
+        {"frames", "Number of timed frames (headless).", "n"},
+        {"warmup", "Number of untimed frames drawn first (headless).", "n"},
+        {"step", "Simulation milliseconds per frame (headless).", "ms"},
+        {"size", "Size of the offscreen framebuffer (headless).", "WxH"},
+        {"report", "Report file, .json or .csv (headless).", "file"},
+        {"micro", "Time CPU kernels against the code they replaced instead: stars, stargen, noise, octaves, nbody, or poisson.", "name"},
+        {"seed", "Seed for all generated scene data, so runs replay exactly.", "n"},
+        {"gpu-stars", "Simulate stars on the GPU with transform feedback."},
+        {"static-stars", "Number of stars that never move (millions are fine).", "n"},
+        {"sky-cubemap", "Draw stars that never move into a cubemap once per refresh."},
+        {"cpu-noise", "Bake planet noise on the CPU instead of the GPU."},
+        {"lod-fade", "Cross fade planets between resolutions instead of switching at once."},
+        {"terrain", "Draw planets as quadtree terrain that refines up close."},
+        {"nbody", "Orbit planets under each other's gravity with a Barnes-Hut N-body simulation."},
+        {"gardens", "Number of flower gardens on the moon, 16 flowers each (tens of thousands are fine).", "n"},
+        {"baked-garden", "Bake every flower into one mesh on the moon, drawn with one call."},
+    });
+    parser.process(a);
+    settings.seed = parser.value("seed").toUInt();
+    settings.gpuStarSimulation = parser.isSet("gpu-stars");
+    settings.staticStars = parser.value("static-stars").toInt();
+    settings.skyCubemap = parser.isSet("sky-cubemap");
+    settings.cpuPlanetNoise = parser.isSet("cpu-noise");
+    settings.planetLODFade = parser.isSet("lod-fade");
+    settings.planetTerrain = parser.isSet("terrain");
+    settings.nbodyOrbits = parser.isSet("nbody");
+    settings.flowerGardens = parser.value("gardens").toInt();
+    settings.bakedGarden = parser.isSet("baked-garden");
+
+    if (parser.isSet("micro")) {
+        MicroBenchmark micro(parser.isSet("report") ? parser.value("report") : QString("micro.json"));
+        return micro.run(parser.value("micro"));
+    }
+
+    if (parser.isSet("headless")) {
+        Benchmark benchmark(parseBenchmarkOptions(parser));
+        return benchmark.run();
+    }
+
     a.setOverrideCursor( QCursor( Qt::BlankCursor ) );
     MainWindow w;
     w.show();
@@ -0,0 +1,282 @@
+#include "Benchmark.h"
+#include "Settings.h"
+
+#include <QGuiApplication>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QSurfaceFormat>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+
+// Names of the timed passes, in the order they're drawn
+#define NUMPASSES 5
+static const char *PASSNAMES[NUMPASSES] = { "stars", "planets", "flowers", "finalPass", "total" };
+
+/**
+ * @brief Gives back one pass's time out of a frame timing by index
+ * @param t The timing for a frame
+ * @param pass An index into PASSNAMES
+ * @return The time in ms for that pass
+ */
+static float passTime(const FrameTiming &t, int pass) {
+    switch (pass) {
+    case 0: return t.stars;
+    case 1: return t.planets;
+    case 2: return t.flowers;
+    case 3: return t.finalPass;
+    default: return t.total;
+    }
+}
+
+/**
+ * @brief Saves the options - nothing is created until run()
+ * @param options What to run and where to report it
+ */
+Benchmark::Benchmark(BenchmarkOptions options)
+    : m_options(options), m_context(NULL), m_surface(NULL), m_FBO(0), m_colorAttachment(0), m_nodes(0) {}
+
+/**
+ * @brief Deletes the context and surface
+ */
+Benchmark::~Benchmark() {
+    delete m_context;
+    delete m_surface;
+}
+
+/**
+ * @brief Creates an OpenGL 4.1 core context on an offscreen surface and makes it current
+ * Qt 5's offscreen platform gets its contexts through GLX, so it still needs
+ * an X server - a virtual one like Xvfb is enough.
+ * @return If the context could be created
+ */
+bool Benchmark::createContext() {
+    QSurfaceFormat format;
+    format.setVersion(4,1);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+
+    m_surface = new QOffscreenSurface();
+    m_surface->setFormat(format);
+    m_surface->create();
+
+    m_context = new QOpenGLContext();
+    m_context->setFormat(format);
+    if (!m_context->create() || !m_context->makeCurrent(m_surface)) {
+        fprintf(stderr, "Error: couldn't create an offscreen OpenGL 4.1 context\n");
+        if (QGuiApplication::platformName() == "offscreen") {
+            fprintf(stderr, "The offscreen platform needs an X server for GLX: set DISPLAY, "
+                            "or run under xvfb-run on machines without one\n");
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Draws all warmup and timed frames and writes the report
+ * Each frame advances the simulation by exactly one step, so runs
+ * are comparable no matter how fast the host is.
+ * @return 0 on success, 1 on any failure
+ */
+int Benchmark::run() {
+    if (!createContext()) return 1;
+
+    Scene scene;
+    scene.initializeGL(m_options.size);
+
+    // Everything ends up in our own FBO instead of a window
+    Scene::createFBO(&m_FBO, &m_colorAttachment, settings.getAndIncrementTextureIndex(), m_options.size, true);
+    scene.setDefaultFramebuffer(m_FBO);
+    scene.resizeGL(m_options.size);
+    m_glRenderer = QString((const char *)glGetString(GL_RENDERER));
+
+    fprintf(stdout, "Benchmarking %d frames (%d warmup) at %dx%d on %s\n",
+            m_options.frames, m_options.warmup, (int)m_options.size.x, (int)m_options.size.y,
+            m_glRenderer.toStdString().c_str());
+
+    // Warm up caches and drivers without timing
+    for (int i = 0; i < m_options.warmup; i++) {
+        scene.update(m_options.step);
+        scene.render();
+    }
+    glFinish();
+
+    // Timed frames
+    scene.setProfiling(true);
+    for (int i = 0; i < m_options.frames; i++) {
+        scene.update(m_options.step);
+        scene.render();
+        m_timings += scene.getLastFrameTiming();
+        m_starStats += scene.getStarStats();
+        m_planetStats += scene.getPlanetStats();
+        m_flowerStats += scene.getFlowerStats();
+        m_nodesUpdated += scene.getSceneGraph()->getLastUpdated();
+        m_nodes = scene.getSceneGraph()->getNodeCount();
+    }
+    scene.setProfiling(false);
+
+    bool written = writeReport();
+
+    glDeleteFramebuffers(1, &m_FBO);
+    glDeleteTextures(1, &m_colorAttachment);
+    return written ? 0 : 1;
+}
+
+/**
+ * @brief Writes timings to the report file, as JSON if it ends in .json or CSV otherwise
+ * @return If the report could be written
+ */
+bool Benchmark::writeReport() {
+    QFile file(m_options.report);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        fprintf(stderr, "Couldn't open file for writing: %s\n", m_options.report.toStdString().c_str());
+        return false;
+    }
+
+    bool okay = m_options.report.endsWith(".json", Qt::CaseInsensitive) ? writeJSON(&file) : writeCSV(&file);
+    if (okay) fprintf(stdout, "Wrote benchmark report to %s\n", m_options.report.toStdString().c_str());
+    return okay;
+}
+
+/**
+ * @brief Writes run info, a per pass summary (mean/min/max/median/p95), and every frame as JSON
+ * @param out The open device to write to
+ * @return If everything was written
+ */
+bool Benchmark::writeJSON(QIODevice *out) {
+    QJsonObject root;
+    root["renderer"] = m_glRenderer;
+    root["width"] = (int)m_options.size.x;
+    root["height"] = (int)m_options.size.y;
+    root["step"] = m_options.step;
+    root["warmup"] = m_options.warmup;
+    root["seed"] = (qint64)settings.seed;
+
+    // Summary per pass
+    QJsonObject summary;
+    for (int pass = 0; pass < NUMPASSES; pass++) {
+        std::vector<float> times;
+        for (int i = 0; i < m_timings.size(); i++) times.push_back(passTime(m_timings.at(i), pass));
+        if (times.empty()) break;
+        std::sort(times.begin(), times.end());
+
+        float sum = 0;
+        for (size_t i = 0; i < times.size(); i++) sum += times[i];
+        QJsonObject stats;
+        stats["mean"] = sum / times.size();
+        stats["min"] = times.front();
+        stats["max"] = times.back();
+        stats["median"] = times[times.size() / 2];
+        stats["p95"] = times[std::min(times.size() - 1, (size_t)(times.size() * 0.95f))];
+        summary[PASSNAMES[pass]] = stats;
+    }
+    root["summary"] = summary;
+
+    // How much of the sky culling let through, on average
+    if (!m_starStats.isEmpty()) {
+        double tilesDrawn = 0, starsDrawn = 0;
+        for (int i = 0; i < m_starStats.size(); i++) {
+            tilesDrawn += m_starStats.at(i).tilesDrawn;
+            starsDrawn += m_starStats.at(i).starsDrawn;
+        }
+        StarStats last = m_starStats.last();
+        QJsonObject stars;
+        stars["tiles"] = last.tiles;
+        stars["staticStars"] = last.stars;
+        stars["meanTilesDrawn"] = tilesDrawn / m_starStats.size();
+        stars["meanStarsDrawn"] = starsDrawn / m_starStats.size();
+        stars["meanFractionDrawn"] = last.stars > 0 ? starsDrawn / m_starStats.size() / last.stars : 0.0;
+        root["stars"] = stars;
+    }
+
+    // How much planet geometry LOD let through, on average
+    if (!m_planetStats.isEmpty()) {
+        double verticesDrawn = 0, terrainChunks = 0, drawCalls = 0, substeps = 0;
+        for (int i = 0; i < m_planetStats.size(); i++) {
+            verticesDrawn += m_planetStats.at(i).verticesDrawn;
+            terrainChunks += m_planetStats.at(i).terrainChunks;
+            drawCalls += m_planetStats.at(i).drawCalls;
+            substeps += m_planetStats.at(i).substeps;
+        }
+        QJsonObject planets;
+        planets["planets"] = m_planetStats.last().planets;
+        planets["meanVerticesDrawn"] = verticesDrawn / m_planetStats.size();
+        planets["meanTerrainChunks"] = terrainChunks / m_planetStats.size();
+        planets["meanDrawCalls"] = drawCalls / m_planetStats.size();
+        planets["meanSubsteps"] = substeps / m_planetStats.size();
+        root["planets"] = planets;
+    }
+
+    // How much of the garden culling let through, on average
+    if (!m_flowerStats.isEmpty()) {
+        double clustersDrawn = 0, flowersDrawn = 0, partsDrawn = 0, partsCulled = 0, drawCalls = 0;
+        for (int i = 0; i < m_flowerStats.size(); i++) {
+            clustersDrawn += m_flowerStats.at(i).clustersDrawn;
+            flowersDrawn += m_flowerStats.at(i).flowersDrawn;
+            partsDrawn += m_flowerStats.at(i).partsDrawn;
+            partsCulled += m_flowerStats.at(i).partsCulled;
+            drawCalls += m_flowerStats.at(i).drawCalls;
+        }
+        FlowerStats last = m_flowerStats.last();
+        QJsonObject flowers;
+        flowers["clusters"] = last.clusters;
+        flowers["flowers"] = last.flowers;
+        flowers["parts"] = last.partsDrawn + last.partsCulled;
+        flowers["meanClustersDrawn"] = clustersDrawn / m_flowerStats.size();
+        flowers["meanFlowersDrawn"] = flowersDrawn / m_flowerStats.size();
+        flowers["meanPartsDrawn"] = partsDrawn / m_flowerStats.size();
+        flowers["meanPartsCulled"] = partsCulled / m_flowerStats.size();
+        flowers["meanDrawCalls"] = drawCalls / m_flowerStats.size();
+        root["flowers"] = flowers;
+    }
+
+    // How much of the scene graph moved, on average
+    if (!m_nodesUpdated.isEmpty()) {
+        double nodesUpdated = 0;
+        foreach(int updated, m_nodesUpdated) nodesUpdated += updated;
+        QJsonObject graph;
+        graph["nodes"] = m_nodes;
+        graph["meanNodesUpdated"] = nodesUpdated / m_nodesUpdated.size();
+        root["sceneGraph"] = graph;
+    }
+
+    // Every frame
+    QJsonArray frames;
+    for (int i = 0; i < m_timings.size(); i++) {
+        QJsonObject frame;
+        for (int pass = 0; pass < NUMPASSES; pass++) {
+            frame[PASSNAMES[pass]] = passTime(m_timings.at(i), pass);
+        }
+        frame["starsDrawn"] = m_starStats.at(i).starsDrawn;
+        frame["planetVerticesDrawn"] = m_planetStats.at(i).verticesDrawn;
+        frame["flowerPartsDrawn"] = m_flowerStats.at(i).partsDrawn;
+        frames.append(frame);
+    }
+    root["frames"] = frames;
+
+    return out->write(QJsonDocument(root).toJson()) > 0;
+}
+
+/**
+ * @brief Writes one row per frame with a column per pass
+ * @param out The open device to write to
+ * @return If everything was written
+ */
+bool Benchmark::writeCSV(QIODevice *out) {
+    QTextStream stream(out);
+    stream << "frame";
+    for (int pass = 0; pass < NUMPASSES; pass++) stream << "," << PASSNAMES[pass];
+    stream << ",starsDrawn,planetVerticesDrawn,flowerPartsDrawn\n";
+
+    for (int i = 0; i < m_timings.size(); i++) {
+        stream << i;
+        for (int pass = 0; pass < NUMPASSES; pass++) stream << "," << passTime(m_timings.at(i), pass);
+        stream << "," << m_starStats.at(i).starsDrawn << "," << m_planetStats.at(i).verticesDrawn;
+        stream << "," << m_flowerStats.at(i).partsDrawn << "\n";
+    }
+    stream.flush();
+    return stream.status() == QTextStream::Ok;
+}
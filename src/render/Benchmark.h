@@ -0,0 +1,66 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "GLCommon.h"
+#include "Scene.h"
+#include <QList>
+#include <QString>
+
+class QOpenGLContext;
+class QOffscreenSurface;
+
+/**
+ * @brief Everything the headless benchmark can be told from the command line
+ */
+struct BenchmarkOptions {
+    /**
+     * @brief Sets up default arguments
+     */
+    BenchmarkOptions() : frames(600), warmup(30), size(glm::vec2(1280, 720)),
+        step(1000.0f / 60.0f), report("benchmark.json") {}
+
+    int frames; // Frames that get timed
+    int warmup; // Frames drawn first and thrown away
+    glm::vec2 size; // Size of the offscreen framebuffer
+    float step; // Simulation ms advanced per frame
+    QString report; // Where to write results - .json or .csv
+};
+
+/**
+ * @brief Renders the scene without a window or display
+ * Creates an offscreen GL context and FBO, draws a fixed number of
+ * frames at a fixed simulation step, and writes per frame and per
+ * pass wall times to a JSON or CSV report.
+ */
+class Benchmark {
+public:
+    Benchmark(BenchmarkOptions options);
+    ~Benchmark();
+
+    // Returns a process exit code
+    int run();
+
+private:
+    bool createContext();
+    bool writeReport();
+    bool writeJSON(QIODevice *out);
+    bool writeCSV(QIODevice *out);
+
+    BenchmarkOptions m_options;
+    QOpenGLContext *m_context;
+    QOffscreenSurface *m_surface;
+
+    // Target for the final pass
+    GLuint m_FBO;
+    GLuint m_colorAttachment;
+
+    QString m_glRenderer;
+    QList<FrameTiming> m_timings;
+    QList<StarStats> m_starStats;
+    QList<PlanetStats> m_planetStats;
+    QList<FlowerStats> m_flowerStats;
+    QList<int> m_nodesUpdated; // Scene graph nodes worked out again each frame
+    int m_nodes; // Scene graph nodes in the last frame
+};
+
+#endif // BENCHMARK_H
@@ -1,45 +1,70 @@
+#include "FlowersRenderer.h"
 #include "StarsRenderer.h"
 #include "ResourceLoader.h"
-#include "GLRenderWidget.h"
+#include "Scene.h"
 #include "PlanetsRenderer.h"
+#include "Settings.h"
 
-#include "Flower.h"
+#include "GardenMesh.h"
 #include "Cylinder.h"
 #include "Sphere.h"
+#include "Random.h"
 
-#define VARIETY 10 // Types of flowers
+#include <algorithm>
+
+#define VARIETY 10 // Types of flowers, unless settings.flowerGardens says otherwise
 #define GARDENSIZE 15 // Num similar flowers per garden
 #define RESOLUTION 5 // How many vertices per sphere dimension
+#define LOOKS_STREAM 0x6c6f6f6b // Random stream for each garden's flower looks
 
 /**
  * @brief Just sets up the renderers
  * @param planets The planet renderer
- * @param renderer The GLRenderWidget
+ * @param scene The Scene
  */
-FlowersRenderer::FlowersRenderer(PlanetsRenderer *planets, GLRenderWidget *renderer) {
+FlowersRenderer::FlowersRenderer(PlanetsRenderer *planets, Scene *scene) {
     m_textureID = -1;
-    m_renderer = renderer;
+    m_scene = scene;
     m_planets = planets;
+    m_flowerSphere = NULL;
+    m_flowerCylinder = NULL;
+    m_instanceBuffer = 0;
+    m_visibleBuffer = 0;
+    m_stemsDrawn = 0;
+    m_stems = 0;
+    m_uniformMVP = -1;
+    m_garden = settings.bakedGarden ? new GardenMesh() : NULL;
 }
 
 /**
  * @brief Deletes all flower data and the sphere and cylinder used to draw it
  */
 FlowersRenderer::~FlowersRenderer() {
-    for (int i=0; i<m_flowers.size(); i++) {
-        delete m_flowers.at(i);
-    }
     delete m_flowerSphere;
     delete m_flowerCylinder;
+    delete m_garden;
+    if (m_instanceBuffer != 0) glDeleteBuffers(1, &m_instanceBuffer);
+    if (m_visibleBuffer != 0) glDeleteBuffers(1, &m_visibleBuffer);
 }
 
 /**
- * @brief Loads flower shaders (vert and frag)
+ * @brief Loads flower shaders (vert and frag), and points both shapes at the instance attributes
  */
 void FlowersRenderer::createShaderProgram() {
     m_shader = ResourceLoader::loadShaders(":/shaders/flower.vert", ":/shaders/flower.frag");
     m_flowerCylinder = new Cylinder(m_shader, RESOLUTION, RESOLUTION);
     m_flowerSphere = new Sphere(m_shader, RESOLUTION, RESOLUTION);
+    m_uniformMVP = glGetUniformLocation(m_shader, "mvp");
+
+    // The model matrix takes four locations in a row, one per column
+    GLint model = glGetAttribLocation(m_shader, "model");
+    std::vector<GLint> locations;
+    for (int i = 0; i < 4; i++) locations.push_back(model < 0 ? -1 : model + i);
+    locations.push_back(glGetAttribLocation(m_shader, "instanceColor"));
+    m_flowerCylinder->setInstanceAttributes(locations);
+    m_flowerSphere->setInstanceAttributes(locations);
+    glGenBuffers(1, &m_instanceBuffer);
+    glGenBuffers(1, &m_visibleBuffer);
 }
 
 /**
@@ -70,21 +95,76 @@ void FlowersRenderer::render() {
 }
 
 /**
- * @brief Creates new shapes and recreates all flowers using gardens
+ * @brief Recreates all flowers using gardens, in the same field as last time
+ * Gardens are placed by the Poisson-disk sampler, seeded with one draw
+ * from rand() - Scene seeds that from the settings seed - so a seed always
+ * grows the same gardens, and each refresh grows new ones. Each garden's
+ * center gets a random template, and the rest of its spots copies of it.
+ * Every part's instance is then packed and uploaded once - stems, then
+ * each flower's center and petals, which share the sphere. With
+ * --baked-garden, they're baked into the garden mesh instead. Either way,
+ * every cluster and flower is bounded for culling.
  */
 void FlowersRenderer::refresh() {
-    m_flowers.clear();
+    int gardens = settings.flowerGardens > 0 ? settings.flowerGardens : VARIETY;
+    unsigned int seed = rand();
+    int flowers = m_sampler.sample(seed, gardens, GARDENSIZE + 1);
+    Philox looks(seed, LOOKS_STREAM);
+    m_field.clear();
+    m_field.reserve(flowers, flowers * FLOWER_MAX_PETALS);
+    for (int i = 0; i < m_sampler.getGardenCount(); i++) {
+        // our template flower, then other similar flowers
+        int around = m_field.addTemplate(m_sampler.getDirection(m_sampler.getGardenBegin(i)), looks, i);
+        for (int j = m_sampler.getGardenBegin(i) + 1; j < m_sampler.getGardenEnd(i); j++) {
+            m_field.addNeighbour(around, m_sampler.getDirection(j));
+        }
+    }
+
+    m_culler.build(m_field, FLOWER_GROUND);
 
-    for (int i = 0; i < VARIETY; i++) {
-        // our template flower
-        Flower *f = new Flower();
-        m_flowers += f;
+    if (m_garden != NULL) {
+        m_garden->bake(m_shader, m_field, m_flowerCylinder, m_flowerSphere, STEMCOLOR);
+        return;
+    }
 
-        // other similar flowers
-        for (int j = 0; j < GARDENSIZE; j++) {
-            m_flowers += new Flower(f);
+    m_instanceData.clear();
+    m_instanceData.reserve((flowers*2 + m_field.getPetalCount()) * FLOWER_INSTANCE_FLOATS);
+    for (int i = 0; i < flowers; i++) addInstance(m_field.getStemModel(i), STEMCOLOR);
+    for (int i = 0; i < flowers; i++) {
+        addInstance(m_field.getCenterModel(i), m_field.getCenterColor(i));
+        glm::vec3 petalColor = m_field.getPetalColor(i);
+        for (int j = m_field.getPetalBegin(i); j < m_field.getPetalEnd(i); j++) {
+            addInstance(m_field.getPetalModel(j), petalColor);
         }
     }
+    m_stems = flowers;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_instanceData.size()*sizeof(GLfloat),
+                 m_instanceData.empty() ? NULL : &m_instanceData[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * @brief Returns how much of the garden was drawn in the last frame
+ * @return The culling counters, with totals for the whole field
+ */
+FlowerStats FlowersRenderer::getStats() {
+    m_stats.clusters = m_field.getClusterCount();
+    m_stats.flowers = m_field.getFlowerCount();
+    return m_stats;
+}
+
+/**
+ * @brief Packs one flower part for the instance buffer
+ * @param model The part's moon-local model matrix
+ * @param color The part's color
+ */
+void FlowersRenderer::addInstance(const glm::mat4 &model, const glm::vec3 &color) {
+    const GLfloat *columns = glm::value_ptr(model);
+    m_instanceData.insert(m_instanceData.end(), columns, columns + 16);
+    GLfloat rest[4] = { color.r, color.g, color.b, 0.0f };
+    m_instanceData.insert(m_instanceData.end(), rest, rest + 4);
 }
 
 /**
@@ -114,39 +194,64 @@ GLuint *FlowersRenderer::getFBO() {
 }
 
 /**
- * @brief Draws all flowers using same shapes, but different colors and mvp/models
+ * @brief Draws the flowers that survive culling, one instanced draw per shape, or the baked garden's runs at once
+ * The moon's orbit is the only thing that changes, so it goes into the
+ * one matrix uniform set per frame, straight from the moon's node. The
+ * eye is taken into the moon's space, so the culler's bounds never move.
  */
 void FlowersRenderer::drawFlowers() {
-    float speed = m_renderer->getRotationalSpeed();
-    glm::mat4x4 orbit = m_planets->getMoonTransformation(speed);
-    Transforms trans = m_renderer->getTransformation();
-
-    // iterate through each of the flowers and render the components
-    for (int i=0; i<m_flowers.size(); i++) {
-        Flower *f = m_flowers.at(i);
-
-        // Stem
-        trans.model = orbit * f->cylModel;
-        glUniform3fv(glGetUniformLocation(m_shader, "color"), 1, glm::value_ptr(STEMCOLOR));
-        glUniformMatrix4fv(glGetUniformLocation(m_shader, "mvp"), 1, GL_FALSE, &trans.getTransform()[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(m_shader, "m"), 1, GL_FALSE, &trans.model[0][0]);
-        m_flowerCylinder->renderGeometry();
-
-        // Center sphere
-        trans.model = orbit * f->centerModel;
-        glUniform3fv(glGetUniformLocation(m_shader, "color"), 1, glm::value_ptr(f->centerColor));
-        glUniformMatrix4fv(glGetUniformLocation(m_shader, "mvp"), 1, GL_FALSE, &trans.getTransform()[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(m_shader, "m"), 1, GL_FALSE, &trans.model[0][0]);
-        m_flowerSphere->renderGeometry();
-
-        // All petals
-        for (int i = 0; i < f->petalCount; i++) {
-            trans.model = orbit * f->petalModels[i];
-            glUniform3fv(glGetUniformLocation(m_shader, "color"), 1, glm::value_ptr(f->petalColor));
-            glUniformMatrix4fv(glGetUniformLocation(m_shader, "mvp"), 1, GL_FALSE, &trans.getTransform()[0][0]);
-            glUniformMatrix4fv(glGetUniformLocation(m_shader, "m"), 1, GL_FALSE, &trans.model[0][0]);
-            m_flowerSphere->renderGeometry();
-        }
+    Transforms trans = m_scene->getTransformation();
+    glm::mat4x4 orbit = m_scene->getSceneGraph()->getWorld(m_planets->getMoonNode());
+    glm::mat4x4 mvp = trans.projection * trans.view * orbit;
+    glUniformMatrix4fv(m_uniformMVP, 1, GL_FALSE, &mvp[0][0]);
+
+    glm::vec3 eye = glm::vec3(glm::inverse(orbit) * glm::vec4(m_scene->getCamera().getData().eye, 1.0f));
+    m_stats.flowersDrawn = m_culler.cull(mvp, eye, &m_visibleRuns);
+    m_stats.clustersDrawn = m_culler.getClustersDrawn();
+    m_stats.partsDrawn = m_culler.getPartsDrawn();
+    m_stats.partsCulled = m_culler.getPartsCulled();
+
+    if (m_garden != NULL) {
+        m_garden->draw(m_field, m_visibleRuns);
+        m_stats.drawCalls = m_visibleRuns.empty() ? 0 : 1;
+        return;
+    }
+
+    // Nothing culled draws straight from the static buffer
+    GLuint buffer = m_instanceBuffer;
+    int stems = m_stems;
+    if (m_stats.flowersDrawn < m_stems) {
+        packVisible();
+        buffer = m_visibleBuffer;
+        stems = m_stemsDrawn;
     }
+    m_flowerCylinder->renderInstanced(buffer, 0, stems);
+    m_flowerSphere->renderInstanced(buffer, stems, m_stats.partsDrawn - stems);
+    m_stats.drawCalls = stems > 0 ? 2 : 0;
 }
 
+/**
+ * @brief Copies the visible runs' instances into the visible buffer and uploads it
+ * A run's stems are in a row in the instance data, and so are its centers
+ * and petals, so every run is two copies: stems first, then spheres.
+ */
+void FlowersRenderer::packVisible() {
+    m_visibleData.resize(m_stats.partsDrawn * FLOWER_INSTANCE_FLOATS);
+    GLfloat *out = m_visibleData.empty() ? NULL : &m_visibleData[0];
+    for (size_t r = 0; r < m_visibleRuns.size(); r++) {
+        const GLfloat *in = &m_instanceData[m_visibleRuns[r].x * FLOWER_INSTANCE_FLOATS];
+        out = std::copy(in, in + m_visibleRuns[r].y * FLOWER_INSTANCE_FLOATS, out);
+    }
+    m_stemsDrawn = m_stats.flowersDrawn;
+    for (size_t r = 0; r < m_visibleRuns.size(); r++) {
+        int first = m_visibleRuns[r].x, end = first + m_visibleRuns[r].y;
+        const GLfloat *in = &m_instanceData[(m_stems + first + m_field.getPetalBegin(first)) * FLOWER_INSTANCE_FLOATS];
+        out = std::copy(in, in + (end - first + m_field.getPetalBegin(end) - m_field.getPetalBegin(first)) * FLOWER_INSTANCE_FLOATS, out);
+    }
+
+    // Orphaned each frame, like the planet positions
+    glBindBuffer(GL_ARRAY_BUFFER, m_visibleBuffer);
+    glBufferData(GL_ARRAY_BUFFER, m_visibleData.size()*sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+    if (!m_visibleData.empty()) glBufferSubData(GL_ARRAY_BUFFER, 0, m_visibleData.size()*sizeof(GLfloat), &m_visibleData[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
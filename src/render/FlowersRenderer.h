@@ -3,26 +3,42 @@
 
 #include "GLCommon.h"
 #include "Renderer.h"
+#include "FlowerField.h"
+#include "GardenCuller.h"
+#include "GardenSampler.h"
+#include "Scene.h"
+#include <vector>
 
-class GLRenderWidget;
 class PlanetsRenderer;
-class Flower;
 class Sphere;
 class Cylinder;
+class GardenMesh;
+
+// Floats per flower part instance: the model's four columns, then color and one unused
+#define FLOWER_INSTANCE_FLOATS 20
 
 /**
  * @brief Class to support rendering of arbitrary numbers of
- * flowers, using the flowers shader to actually draw them
+ * flowers, using the flowers shader to actually draw them. Flowers
+ * never move on the moon, so every part's moon-local model and color go
+ * into one instance buffer on refresh: stems first, then each flower's
+ * center and petals. Each frame, the moon's node gives one orbit matrix,
+ * and gardens behind the moon or off screen are culled, whole clusters
+ * first. The runs of flowers left are copied into a stream buffer, so
+ * stems and spheres are still each one instanced call, however scattered
+ * the survivors are. With --baked-garden, every part is merged into one
+ * GardenMesh instead, and the runs left are one multi-draw.
  */
 class FlowersRenderer : public Renderer {
 public:
-    FlowersRenderer(PlanetsRenderer *planets, GLRenderWidget *renderer);
+    FlowersRenderer(PlanetsRenderer *planets, Scene *scene);
     ~FlowersRenderer();
 
     void createShaderProgram();
     void createFBO(glm::vec2 size);
     void render();
     void refresh();
+    FlowerStats getStats();
 
     int getTextureID();
     GLuint *getColorAttach();
@@ -30,13 +46,31 @@ public:
 
 private:
     void drawFlowers();
+    void addInstance(const glm::mat4 &model, const glm::vec3 &color);
+    void packVisible();
 
     PlanetsRenderer *m_planets;
 
     // Objects
-    QList<Flower *> m_flowers;
+    GardenSampler m_sampler; // Where every flower stands, kept between refreshes like the field
+    FlowerField m_field; // Every flower, kept between refreshes so its memory is reused
     Sphere *m_flowerSphere;
     Cylinder *m_flowerCylinder;
+
+    // Instances, built once per refresh
+    std::vector<GLfloat> m_instanceData; // FLOWER_INSTANCE_FLOATS floats per part
+    GLuint m_instanceBuffer;
+    int m_stems; // Stem instances, first in the buffer, with centers and petals after
+    GLint m_uniformMVP;
+    GardenMesh *m_garden; // Every flower in one mesh, NULL unless --baked-garden
+
+    // Culling, redone every frame
+    GardenCuller m_culler;
+    std::vector<glm::ivec2> m_visibleRuns; // (first flower, count) that might be seen
+    std::vector<GLfloat> m_visibleData; // Instances of the visible runs: stems, then spheres
+    GLuint m_visibleBuffer;
+    int m_stemsDrawn; // Stem instances in the visible buffer, with centers and petals after
+    FlowerStats m_stats;
 };
 
 #endif // FLOWERSRENDERER_H
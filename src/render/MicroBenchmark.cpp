@@ -0,0 +1,815 @@
+#include "MicroBenchmark.h"
+#include "GLCommon.h"
+#include "GLMath.h"
+#include "Settings.h"
+#include "StarField.h"
+#include "StarGenerator.h"
+#include "Parallel.h"
+#include "Noise.h"
+#include "PlanetMesh.h"
+#include "NBodySystem.h"
+#include "FlowerField.h"
+#include "GardenSampler.h"
+#include "Random.h"
+#include "ResourceLoader.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+#include <algorithm>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <string.h>
+
+// Star constants, the same as StarsRenderer's
+#define STARS_MAXLIFE 150.0f
+#define STARS_SPREAD 450.0f
+#define STARS_SHOOTINGTHRESHOLD 0.97f
+#define STARS_MINRADIUS 125.0f
+
+// Static stars made per stargen iteration
+#define STARGEN_COUNT 1000000
+
+// Sphere points run through the noise per iteration, and how many may disagree with the shader
+#define NOISE_POINTS 100000
+#define NOISE_TOLERANCE 1e-3
+#define NOISE_MAX_OUTLIERS 0.001
+
+// Mesh details the octave budgets are compared at - the baked resolutions, then terrain levels
+#define OCTAVES_DETAILS { 36, 64, 256, 1024 }
+#define OCTAVES_THRESHOLD 1.72f // Earth's land threshold, for counting pixels that change color
+
+// Body counts the N-body step is timed at, the disk they're in, and how far the checks may drift
+#define NBODY_COUNTS { 1000, 10000, 100000 }
+#define NBODY_DISK_STREAM 0x6e626479
+#define NBODY_DISK_RADIUS glm::vec2(20, 100)
+#define NBODY_DISK_MASS 0.1f // All of the disk together, as a fraction of the mass at the center
+#define NBODY_STEP 0.25f
+#define NBODY_FORCE_SAMPLES 256
+#define NBODY_FORCE_TOLERANCE 0.01
+#define NBODY_ENERGY_STEPS 400
+#define NBODY_ENERGY_TOLERANCE 1e-4
+#define NBODY_CHECK_STEPS 10
+
+// Flower counts the garden sampler is timed at, 16 to a garden, and how short of its spacing it may fall
+#define POISSON_COUNTS { 16000, 100000, 1000000 }
+#define POISSON_MEMBERS 16
+#define POISSON_SPACING_TOLERANCE 1e-3
+#define POISSON_MISSING_TOLERANCE 0.01
+
+// Templates' spins around their stems are counted in sectors, and the emptiest may hold this much less than its share
+#define POISSON_LOOKS_STREAM 0x6c6f6f6b // FlowersRenderer's looks stream
+#define POISSON_SPIN_SECTORS 8
+#define POISSON_SPIN_TOLERANCE 0.5
+#define POISSON_UPRIGHT_TOLERANCE 1e-3
+
+// Roughly how many items each timed kernel processes in total
+#define ITEMS_PER_KERNEL 20000000
+#define MIN_ITERATIONS 5
+
+// Steps taken before comparing variants
+#define CHECK_STEPS 300
+
+/**
+ * @brief The array of structures stars were stored in before StarField
+ * Kept only as the baseline to compare against
+ */
+struct __attribute__ ((aligned (16))) LegacyStar {
+    float life;
+    float decay;
+    glm::vec3 color;
+    glm::vec3 pos;
+    glm::vec3 dir;
+    glm::vec3 force;
+};
+
+/**
+ * @brief The scalar step StarsRenderer used with LegacyStar
+ * @param stars The stars to step
+ * @param count The number of stars
+ * @param seed Seed for respawning
+ * @param stepCount Steps taken so far
+ */
+static void stepLegacy(LegacyStar *stars, int count, unsigned int seed, unsigned int stepCount) {
+    unsigned int n = stepCount * 3;
+    for (int i = 0; i < count; i++) {
+        stars[i].pos = stars[i].pos + stars[i].dir;
+        stars[i].life += stars[i].decay;
+        if (stars[i].life <= 0 || stars[i].life >= STARS_MAXLIFE) {
+            stars[i].decay *= -1.0f;
+            if (glm::length(stars[i].dir) > 0 && stars[i].life <= 0) {
+                stars[i].pos.x = -STARS_SPREAD + 2.0f * STARS_SPREAD * hashRandN(seed, i, n);
+                stars[i].pos.y = -STARS_SPREAD + 2.0f * STARS_SPREAD * hashRandN(seed, i, n + 1);
+                stars[i].pos.z = -STARS_SPREAD + 2.0f * STARS_SPREAD * hashRandN(seed, i, n + 2);
+            }
+        }
+    }
+}
+
+/**
+ * @brief The scalar backface test and packing drawStars used with LegacyStar
+ * @param stars The stars to test
+ * @param count The number of stars
+ * @param eye The normalized eye position
+ * @param rotation The rotation applied to the whole sky
+ * @param out Room for count * STARFIELD_PACKED_FLOATS floats
+ * @return The number of stars written
+ */
+static int packVisibleLegacy(const LegacyStar *stars, int count, glm::vec3 eye, glm::mat3 rotation, float *out) {
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        if (glm::dot(eye, rotation * glm::normalize(-stars[i].pos)) <= 0) continue;
+        float *instance = out + written * STARFIELD_PACKED_FLOATS;
+        instance[0] = stars[i].pos.x;
+        instance[1] = stars[i].pos.y;
+        instance[2] = stars[i].pos.z;
+        instance[3] = stars[i].life;
+        instance[4] = stars[i].dir.x;
+        instance[5] = stars[i].dir.y;
+        instance[6] = stars[i].dir.z;
+        instance[7] = stars[i].decay;
+        written++;
+    }
+    return written;
+}
+
+/**
+ * @brief The random turns the original Flower class placed gardens with
+ * Each template turned rand() % 360 radians around one of seven axes, and
+ * each neighbour turned up to 289 radians more around a random axis. Kept
+ * only as the baseline to compare against.
+ * @param gardens How many gardens
+ * @param members Flowers per garden, counting the template
+ * @param directions Filled with each flower's direction out of the moon's center
+ */
+static void placeLegacy(int gardens, int members, std::vector<glm::vec3> *directions) {
+    directions->clear();
+    for (int i = 0; i < gardens; i++) {
+        glm::vec3 dims;
+        do {
+            dims.x = rand() % 2;
+            dims.y = rand() % 2;
+            dims.z = rand() % 2;
+        } while (!(dims.x || dims.y || dims.z));
+        glm::vec3 up = glm::angleAxis((float)(rand() % 360), glm::normalize(dims)) * glm::vec3(0, 1, 0);
+        directions->push_back(up);
+        for (int j = 1; j < members; j++) {
+            float angle = pow(rand() % 18, 2.f);
+            dims = glm::vec3(urand(), urand(), urand());
+            glm::quat turn = glm::length(dims) > 0.0f ? glm::angleAxis(angle, glm::normalize(dims)) : glm::quat();
+            directions->push_back(turn * up);
+        }
+    }
+}
+
+/**
+ * @brief Runs a kernel enough times to time it and gives back the mean
+ * @param kernel Called once per iteration
+ * @param iterations How many times to call it
+ * @return Mean ns per call
+ */
+template <typename Kernel>
+static double timeKernel(Kernel kernel, int iterations) {
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; i++) kernel();
+    return timer.nsecsElapsed() / (double)iterations;
+}
+
+/**
+ * @brief Makes random points on the planet, laid out like Sphere's vertices
+ * Seeded from settings.seed, so every benchmark sees the same points.
+ * @param count How many points
+ * @param vertices Filled with NOISE_VERTEX_FLOATS floats per point: position, then normal
+ */
+static void spherePoints(int count, std::vector<float> *vertices) {
+    srand(settings.seed);
+    vertices->resize(count * NOISE_VERTEX_FLOATS);
+    for (int i = 0; i < count; i++) {
+        glm::vec3 normal;
+        do {
+            normal = glm::vec3(urand(-1, 1), urand(-1, 1), urand(-1, 1));
+        } while (glm::length(normal) < 0.01f);
+        normal = glm::normalize(normal);
+        float *vertex = &(*vertices)[i * NOISE_VERTEX_FLOATS];
+        for (int c = 0; c < 3; c++) {
+            vertex[c] = normal[c] * 0.5f;
+            vertex[3 + c] = normal[c];
+        }
+    }
+}
+
+/**
+ * @brief Makes a thin disk of bodies on circular orbits around a unit mass
+ * Seeded from settings.seed, so every benchmark sees the same disk.
+ * @param count How many bodies
+ * @param bodies Filled with count bodies, sharing NBODY_DISK_MASS between them
+ */
+static void diskBodies(int count, QList<PlanetData> *bodies) {
+    Philox random(settings.seed, NBODY_DISK_STREAM);
+    glm::vec2 radii = NBODY_DISK_RADIUS;
+    bodies->clear();
+    for (int i = 0; i < count; i++) {
+        float u[4];
+        random.uniform(i, 0, u);
+        float radius = sqrt(glm::mix(radii.x * radii.x, radii.y * radii.y, u[0]));
+        float angle = u[1] * 2.0f * (float)M_PI;
+        PlanetData data = PlanetData();
+        data.position = glm::vec3(radius * cos(angle), u[2] * 2.0f - 1.0f, radius * sin(angle));
+        data.year = sqrt(radius * radius * radius);
+        data.mass = NBODY_DISK_MASS / count;
+        bodies->append(data);
+    }
+}
+
+/**
+ * @brief Saves where to write results
+ * @param report The JSON file to write
+ */
+MicroBenchmark::MicroBenchmark(QString report) : m_report(report) {}
+
+/**
+ * @brief Runs one benchmark by name and writes the report
+ * @param name Which benchmark to run: stars, stargen, noise, octaves, nbody, or poisson
+ * @return 0 on success, 1 on any failure
+ */
+int MicroBenchmark::run(QString name) {
+    bool okay;
+    if (name == "stars") okay = benchStars();
+    else if (name == "stargen") okay = benchStarGeneration();
+    else if (name == "noise") okay = benchNoise();
+    else if (name == "octaves") okay = benchOctaves();
+    else if (name == "nbody") okay = benchNBody();
+    else if (name == "poisson") okay = benchPoisson();
+    else {
+        fprintf(stderr, "Unknown micro-benchmark: %s\n", name.toStdString().c_str());
+        return 1;
+    }
+    return okay && writeReport() ? 0 : 1;
+}
+
+/**
+ * @brief Times stepping and the backface test for LegacyStar against StarField
+ * Both start from the same stars at 4k, 100k, and 1M, and are checked to
+ * still match after CHECK_STEPS steps.
+ * @return If the variants agreed
+ */
+bool MicroBenchmark::benchStars() {
+    const int counts[] = { 4000, 100000, 1000000 };
+    const glm::vec3 eye = glm::normalize(glm::vec3(0.3f, 0.4f, 1.0f));
+    const glm::mat3 rotation = glm::mat3(glm::rotate(0.2f, glm::vec3(0, 1, -0.75f)));
+    bool okay = true;
+
+    for (int c = 0; c < 3; c++) {
+        int count = counts[c];
+        int iterations = std::max(MIN_ITERATIONS, ITEMS_PER_KERNEL / count);
+
+        // The same stars in both layouts
+        srand(settings.seed);
+        std::vector<LegacyStar> legacy(count);
+        StarField field;
+        field.resize(count);
+        for (int i = 0; i < count; i++) {
+            Star star;
+            star.pos = glm::vec3(urand(-STARS_SPREAD, STARS_SPREAD), urand(-STARS_SPREAD, STARS_SPREAD),
+                                 urand(-STARS_SPREAD, STARS_SPREAD));
+            star.life = urand(0, STARS_MAXLIFE);
+            star.dir = glm::vec3(0);
+            star.decay = urand(0.0f, 1.0f) > 0.5f ? 1 : -1;
+            if (urand(0.0f, 1.0f) > STARS_SHOOTINGTHRESHOLD)
+                star.dir = glm::vec3(urand(-M_PI, M_PI), urand(-M_PI, M_PI), urand(-M_PI, M_PI));
+            field.set(i, star);
+            legacy[i].pos = star.pos;
+            legacy[i].life = star.life;
+            legacy[i].dir = star.dir;
+            legacy[i].decay = star.decay;
+        }
+
+        // Both should step to the same place
+        for (unsigned int s = 0; s < CHECK_STEPS; s++) {
+            stepLegacy(&legacy[0], count, settings.seed, s);
+            field.step(STARS_MAXLIFE, STARS_SPREAD, settings.seed, s);
+        }
+        double maxError = 0;
+        for (int i = 0; i < count; i++) {
+            Star star = field.get(i);
+            maxError = std::max(maxError, (double)glm::length(star.pos - legacy[i].pos));
+            maxError = std::max(maxError, (double)fabs(star.life - legacy[i].life));
+        }
+        addCheck(QString("stars.step.%1").arg(count), maxError);
+        if (maxError > 1e-3) okay = false;
+
+        // Timings
+        unsigned int stepCount = CHECK_STEPS;
+        double ns = timeKernel([&]() { stepLegacy(&legacy[0], count, settings.seed, stepCount++); }, iterations);
+        addResult("stars.step", "aos-scalar", count, ns / count);
+        stepCount = CHECK_STEPS;
+        ns = timeKernel([&]() { field.step(STARS_MAXLIFE, STARS_SPREAD, settings.seed, stepCount++); }, iterations);
+        addResult("stars.step", QString("soa-simd%1").arg(StarField::width()), count, ns / count);
+
+        std::vector<float> packed(count * STARFIELD_PACKED_FLOATS);
+        int legacyVisible = 0, fieldVisible = 0, shooting = 0;
+        ns = timeKernel([&]() { legacyVisible = packVisibleLegacy(&legacy[0], count, eye, rotation, &packed[0]); }, iterations);
+        addResult("stars.visible", "aos-scalar", count, ns / count);
+        ns = timeKernel([&]() { fieldVisible = field.packVisible(eye, rotation, 0, &packed[0], &shooting); }, iterations);
+        addResult("stars.visible", QString("soa-simd%1").arg(StarField::width()), count, ns / count);
+
+        // Stars right on the horizon may round either way without normalizing
+        addCheck(QString("stars.visible.%1").arg(count), abs(legacyVisible - fieldVisible));
+    }
+    return okay;
+}
+
+/**
+ * @brief Times making STARGEN_COUNT static stars with rand() and rejection against StarGenerator
+ * The generator is run on one thread and on every core, and the two are
+ * checked to be bit-identical.
+ * @return If every thread count made the same stars
+ */
+bool MicroBenchmark::benchStarGeneration() {
+    int count = STARGEN_COUNT;
+    int threads = parallelThreadCount();
+    std::vector<float> legacy(count * 4), single(count * 4), parallel(count * 4);
+
+    // What refresh() did before: one shared rand() and rejection from the cube
+    srand(settings.seed);
+    double ns = timeKernel([&]() {
+        for (int i = 0; i < count; i++) {
+            glm::vec3 pos;
+            do {
+                pos = glm::vec3(urand(-STARS_SPREAD, STARS_SPREAD), urand(-STARS_SPREAD, STARS_SPREAD),
+                                urand(-STARS_SPREAD, STARS_SPREAD));
+            } while (glm::length(pos) < STARS_MINRADIUS);
+            legacy[i*4] = pos.x;
+            legacy[i*4 + 1] = pos.y;
+            legacy[i*4 + 2] = pos.z;
+            legacy[i*4 + 3] = urand(0, 2*STARS_MAXLIFE);
+        }
+    }, MIN_ITERATIONS);
+    addResult("stars.generate", "rand-reject", count, ns / count);
+
+    StarGenerator generator(settings.seed, STARS_MINRADIUS, STARS_SPREAD, STARS_MAXLIFE);
+    ns = timeKernel([&]() { generator.staticStars(count, &single[0], 1); }, MIN_ITERATIONS);
+    addResult("stars.generate", "philox-1", count, ns / count);
+    ns = timeKernel([&]() { generator.staticStars(count, &parallel[0], threads); }, MIN_ITERATIONS);
+    addResult("stars.generate", QString("philox-%1").arg(threads), count, ns / count);
+
+    int mismatched = memcmp(&single[0], &parallel[0], single.size() * sizeof(float)) != 0;
+    addCheck(QString("stars.generate.%1").arg(count), mismatched);
+    return mismatched == 0;
+}
+
+/**
+ * @brief Times the CPU planet noise one point at a time, with SIMD, and on every core
+ * Every variant is checked to be bit-identical to the one point version,
+ * and, if an OpenGL 4.1 context can be made, to match noise.vert itself
+ * within NOISE_TOLERANCE. The GPU can round differently right on a cell
+ * edge, so a few points (NOISE_MAX_OUTLIERS) are allowed to land in a
+ * different cell.
+ * @return If the CPU variants agreed with each other and the shader
+ */
+bool MicroBenchmark::benchNoise() {
+    int count = NOISE_POINTS;
+    int threads = parallelThreadCount();
+    float seed = (settings.seed % 1000) / 1000.0f;
+
+    // Points on the planet, and the turbulence input noise.vert makes from them
+    std::vector<float> vertices;
+    spherePoints(count, &vertices);
+    std::vector<float> x(count), y(count), z(count);
+    for (int i = 0; i < count; i++) {
+        const float *normal = &vertices[i * NOISE_VERTEX_FLOATS + 3];
+        x[i] = 0.73f * normal[0] + seed;
+        y[i] = 0.73f * normal[1] + seed;
+        z[i] = 0.73f * normal[2] + seed;
+    }
+
+    // Turbulence alone
+    std::vector<float> turbulence(count);
+    QString simd = QString("simd%1").arg(Noise::width());
+    double ns = timeKernel([&]() {
+        for (int i = 0; i < count; i++) turbulence[i] = Noise::turbulence(glm::vec3(x[i], y[i], z[i]));
+    }, MIN_ITERATIONS);
+    addResult("noise.turbulence", "scalar", count, ns / count);
+    ns = timeKernel([&]() { Noise::turbulence(&x[0], &y[0], &z[0], count, &turbulence[0], 1); }, MIN_ITERATIONS);
+    addResult("noise.turbulence", simd, count, ns / count);
+    ns = timeKernel([&]() { Noise::turbulence(&x[0], &y[0], &z[0], count, &turbulence[0], threads); }, MIN_ITERATIONS);
+    addResult("noise.turbulence", QString("%1-x%2").arg(simd).arg(threads), count, ns / count);
+
+    // Everything noise.vert does
+    std::vector<float> scalar(count * NOISE_BAKED_FLOATS), single(scalar.size()), parallel(scalar.size());
+    ns = timeKernel([&]() { Noise::bakePlanetScalar(&vertices[0], count, seed, &scalar[0]); }, MIN_ITERATIONS);
+    addResult("noise.bake", "scalar", count, ns / count);
+    ns = timeKernel([&]() { Noise::bakePlanet(&vertices[0], count, seed, &single[0], 1); }, MIN_ITERATIONS);
+    addResult("noise.bake", simd, count, ns / count);
+    ns = timeKernel([&]() { Noise::bakePlanet(&vertices[0], count, seed, &parallel[0], threads); }, MIN_ITERATIONS);
+    addResult("noise.bake", QString("%1-x%2").arg(simd).arg(threads), count, ns / count);
+
+    bool okay = true;
+    int mismatched = memcmp(&scalar[0], &single[0], scalar.size() * sizeof(float)) != 0;
+    addCheck("noise.bake.simd", mismatched);
+    okay = okay && mismatched == 0;
+    mismatched = memcmp(&single[0], &parallel[0], single.size() * sizeof(float)) != 0;
+    addCheck("noise.bake.threads", mismatched);
+    okay = okay && mismatched == 0;
+
+    // The shader itself, if there's a GPU to run it on
+    std::vector<float> shader;
+    if (shaderNoise(vertices, seed, NoiseOptions(), &shader)) {
+        okay = checkShader("noise.bake.glsl", scalar, shader) && okay;
+    }
+    return okay;
+}
+
+/**
+ * @brief Compares octave budgets and noise bases against the original 10 Perlin octaves
+ * At each mesh detail, times baking with 10 octaves and with the budget
+ * PlanetMesh would pick, for both Perlin and simplex, on one core and, if
+ * there's a GPU, in noise.vert. How far each strays from the original is
+ * the RMS difference in height (noise times 100, what noise.frag compares
+ * to thresholds) and the fraction of points that change between land and
+ * water at OCTAVES_THRESHOLD. Simplex makes a different surface, so for it
+ * only the fraction of land is comparable. Simplex is also checked against
+ * noise.vert.
+ * @return If the CPU and shader simplex agreed
+ */
+bool MicroBenchmark::benchOctaves() {
+    int count = NOISE_POINTS;
+    float seed = (settings.seed % 1000) / 1000.0f;
+    std::vector<float> vertices;
+    spherePoints(count, &vertices);
+
+    std::vector<float> reference(count * NOISE_BAKED_FLOATS), baked(reference.size()), shader;
+    Noise::bakePlanet(&vertices[0], count, seed, &reference[0]);
+
+    bool okay = true;
+    if (shaderNoise(vertices, seed, NoiseOptions(NOISE_MAX_OCTAVES, NOISE_SIMPLEX), &shader)) {
+        Noise::bakePlanet(&vertices[0], count, seed, &baked[0], 0, NoiseOptions(NOISE_MAX_OCTAVES, NOISE_SIMPLEX));
+        okay = checkShader("octaves.simplex.glsl", baked, shader);
+    }
+
+    const int details[] = OCTAVES_DETAILS;
+    const char *bases[] = { "perlin", "simplex" };
+    PlanetNoise budget = PlanetNoise();
+    for (unsigned int d = 0; d < sizeof(details) / sizeof(details[0]); d++) {
+        int octaves = PlanetMesh::noiseOptions(PlanetResolution(details[d]), budget).octaves;
+        QString kernel = QString("octaves.%1").arg(details[d]);
+        for (int b = 0; b < 2; b++) {
+            for (int o = 0; o < 2; o++) {
+                NoiseOptions options(o == 0 ? NOISE_MAX_OCTAVES : octaves, (NoiseBasis)b);
+                QString variant = QString("%1-%2").arg(bases[b]).arg(options.octaves);
+                if (o == 1 && options.octaves == NOISE_MAX_OCTAVES) continue;
+
+                double ns = timeKernel([&]() { Noise::bakePlanet(&vertices[0], count, seed, &baked[0], 1, options); },
+                                       MIN_ITERATIONS);
+                addResult(kernel + ".cpu", variant, count, ns / count);
+                double gpu;
+                if (shaderNoise(vertices, seed, options, &shader, &gpu)) {
+                    addResult(kernel + ".glsl", variant, count, gpu);
+                }
+
+                // Error in what noise.frag sees
+                double squared = 0;
+                int flipped = 0, land = 0;
+                for (int i = 0; i < count; i++) {
+                    float height = baked[i * NOISE_BAKED_FLOATS + 3] * 100.0f;
+                    float original = reference[i * NOISE_BAKED_FLOATS + 3] * 100.0f;
+                    squared += (height - original) * (height - original);
+                    flipped += (height < OCTAVES_THRESHOLD) != (original < OCTAVES_THRESHOLD);
+                    land += height >= OCTAVES_THRESHOLD;
+                }
+                addCheck(kernel + "." + variant + ".rms", sqrt(squared / count));
+                addCheck(kernel + "." + variant + ".flipped", flipped / (double)count);
+                addCheck(kernel + "." + variant + ".land", land / (double)count);
+            }
+        }
+    }
+    return okay;
+}
+
+/**
+ * @brief Checks what noise.vert baked against the CPU, allowing a few points in a different cell
+ * The GPU can round differently right on a cell edge, so up to
+ * NOISE_MAX_OUTLIERS of the points may be off by more than NOISE_TOLERANCE.
+ * @param name What the checks are saved as
+ * @param cpu What Noise baked
+ * @param shader What noise.vert baked from the same vertices
+ * @return If few enough points disagreed
+ */
+bool MicroBenchmark::checkShader(QString name, const std::vector<float> &cpu, const std::vector<float> &shader) {
+    int count = cpu.size() / NOISE_BAKED_FLOATS;
+    double maxError = 0;
+    int outliers = 0;
+    for (int i = 0; i < count; i++) {
+        double error = 0;
+        for (int f = 0; f < NOISE_BAKED_FLOATS; f++) {
+            int j = i * NOISE_BAKED_FLOATS + f;
+            error = std::max(error, (double)fabs(cpu[j] - shader[j]));
+        }
+        if (error > NOISE_TOLERANCE) outliers++;
+        else maxError = std::max(maxError, error);
+    }
+    addCheck(name, maxError);
+    addCheck(name + "Outliers", outliers / (double)count);
+    return outliers <= count * NOISE_MAX_OUTLIERS;
+}
+
+/**
+ * @brief Runs noise.vert over vertices with transform feedback on an offscreen context
+ * When timed, the pass is run once to warm up, then MIN_ITERATIONS more
+ * times inside a GL_TIME_ELAPSED query.
+ * @param vertices NOISE_VERTEX_FLOATS floats per vertex: position, then normal
+ * @param seed The planet seed
+ * @param options The octaves and basis to bake with
+ * @param out Filled in with NOISE_BAKED_FLOATS floats per vertex
+ * @param nsPerVertex If not NULL, set to the mean GPU time per vertex
+ * @return If there was a context and the shader ran
+ */
+bool MicroBenchmark::shaderNoise(const std::vector<float> &vertices, float seed, NoiseOptions options,
+                                 std::vector<float> *out, double *nsPerVertex) {
+    QSurfaceFormat format;
+    format.setVersion(4,1);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(format);
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        fprintf(stdout, "No OpenGL 4.1 context, skipping the comparison with noise.vert\n");
+        return false;
+    }
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        fprintf(stdout, "Couldn't start GLEW, skipping the comparison with noise.vert\n");
+        return false;
+    }
+
+    const char *varyings[] = { "bakedPosition", "bakedNoise" };
+    GLuint shader = ResourceLoader::loadTransformFeedbackShader(":/shaders/noise.vert", varyings, 2);
+    if (shader == 0) return false;
+
+    int count = vertices.size() / NOISE_VERTEX_FLOATS;
+    GLsizei stride = NOISE_VERTEX_FLOATS * sizeof(GLfloat);
+    GLuint position = glGetAttribLocation(shader, "position");
+    GLuint normal = glGetAttribLocation(shader, "normal");
+    GLuint vao, buffers[2];
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(2, buffers);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
+    glEnableVertexAttribArray(position);
+    glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(normal);
+    glVertexAttribPointer(normal, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(GLfloat)));
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+    glBufferData(GL_ARRAY_BUFFER, count * NOISE_BAKED_FLOATS * sizeof(GLfloat), NULL, GL_STATIC_READ);
+
+    glUseProgram(shader);
+    glUniform1f(glGetUniformLocation(shader, "seed"), seed);
+    glUniform1i(glGetUniformLocation(shader, "octaves"), options.octaves);
+    glUniform1i(glGetUniformLocation(shader, "simplex"), options.basis == NOISE_SIMPLEX);
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[1]);
+    int passes = nsPerVertex != NULL ? MIN_ITERATIONS + 1 : 1;
+    GLuint query;
+    glGenQueries(1, &query);
+    for (int pass = 0; pass < passes; pass++) {
+        if (pass == 1) glBeginQuery(GL_TIME_ELAPSED, query);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, count);
+        glEndTransformFeedback();
+    }
+    if (passes > 1) {
+        glEndQuery(GL_TIME_ELAPSED);
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        *nsPerVertex = elapsed / (double)(MIN_ITERATIONS * count);
+    }
+    glDeleteQueries(1, &query);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    out->resize(count * NOISE_BAKED_FLOATS);
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, out->size() * sizeof(GLfloat), &(*out)[0]);
+
+    // Clean up
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glDeleteBuffers(2, buffers);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(shader);
+    context.doneCurrent();
+    return true;
+}
+
+/**
+ * @brief Times Barnes-Hut steps for disks of bodies, on more and more threads
+ * Each disk is checked against summing every pair directly, and stepped on
+ * one thread and on every core, which have to end up bit-identical. A
+ * small disk is stepped NBODY_ENERGY_STEPS times to check its energy holds.
+ * @return If the forces were close enough, threads agreed, and energy held
+ */
+bool MicroBenchmark::benchNBody() {
+    const int counts[] = NBODY_COUNTS;
+    int most = parallelThreadCount();
+    std::vector<int> threads;
+    for (int t = 1; t < most; t *= 2) threads.push_back(t);
+    threads.push_back(most);
+    bool okay = true;
+
+    for (int c = 0; c < 3; c++) {
+        int count = counts[c];
+        QList<PlanetData> bodies;
+        diskBodies(count, &bodies);
+
+        NBodySystem system;
+        system.reset(bodies);
+        double error = system.forceError(NBODY_FORCE_SAMPLES);
+        addCheck(QString("nbody.force.%1").arg(count), error);
+        okay = okay && error <= NBODY_FORCE_TOLERANCE;
+
+        for (size_t t = 0; t < threads.size(); t++) {
+            double ns = timeKernel([&]() { system.step(NBODY_STEP, threads[t]); }, MIN_ITERATIONS);
+            addResult("nbody.step", QString("barnes-hut-x%1").arg(threads[t]), count, ns / count);
+        }
+        std::vector<float> positions(count * 3);
+        double ns = timeKernel([&]() { system.positionsAt(system.getTime(), &positions[0], 3, most); }, MIN_ITERATIONS);
+        addResult("nbody.ephemeris", QString("hermite-x%1").arg(most), count, ns / count);
+        fprintf(stdout, "nbody %d: %d nodes, %d groups, %.0f interactions per body\n", count,
+                system.getStats().nodes, system.getStats().groups, system.getStats().interactions);
+
+        // One thread and every core should step the same way
+        NBodySystem single, parallel;
+        single.reset(bodies);
+        parallel.reset(bodies);
+        for (int s = 0; s < NBODY_CHECK_STEPS; s++) {
+            single.step(NBODY_STEP, 1);
+            parallel.step(NBODY_STEP, most);
+        }
+        std::vector<float> expected(count * 3);
+        single.positionsAt(single.getTime(), &expected[0], 3, 1);
+        parallel.positionsAt(parallel.getTime(), &positions[0], 3, most);
+        int mismatched = memcmp(&expected[0], &positions[0], expected.size() * sizeof(float)) != 0;
+        addCheck(QString("nbody.threads.%1").arg(count), mismatched);
+        okay = okay && mismatched == 0;
+    }
+
+    // Leapfrog should hold energy steady, at the step the system picks for itself
+    QList<PlanetData> bodies;
+    diskBodies(counts[0], &bodies);
+    NBodySystem system;
+    system.reset(bodies);
+    double before = system.energy();
+    for (int s = 0; s < NBODY_ENERGY_STEPS; s++) system.step(system.getStableStep());
+    double drift = fabs(system.energy() - before) / fabs(before);
+    addCheck("nbody.energy", drift);
+    return okay && drift <= NBODY_ENERGY_TOLERANCE;
+}
+
+/**
+ * @brief Times the Poisson-disk garden sampler against the random turns it replaced, on more and more threads
+ * Every sampling is checked for flowers closer than the flower spacing,
+ * for flowers that didn't fit, and for giving the same flowers on one
+ * thread as on every core. Templates grown at the gardens' centers, and
+ * one standing straight down, are checked for standing where they were
+ * put and for spinning the whole way around their stems.
+ * @return If spacing held, almost every flower fit, threads agreed, and templates spun freely
+ */
+bool MicroBenchmark::benchPoisson() {
+    const int counts[] = POISSON_COUNTS;
+    int most = parallelThreadCount();
+    std::vector<int> threads;
+    for (int t = 1; t < most; t *= 2) threads.push_back(t);
+    threads.push_back(most);
+    bool okay = true;
+
+    for (int c = 0; c < 3; c++) {
+        int count = counts[c];
+        int gardens = count / POISSON_MEMBERS;
+        int iterations = std::max(MIN_ITERATIONS, ITEMS_PER_KERNEL / count / 10);
+
+        std::vector<glm::vec3> legacy;
+        srand(settings.seed);
+        double ns = timeKernel([&]() { placeLegacy(gardens, POISSON_MEMBERS, &legacy); }, iterations);
+        addResult("poisson.place", "rand-turns", count, ns / count);
+
+        GardenSampler single, parallel;
+        for (size_t t = 0; t < threads.size(); t++) {
+            ns = timeKernel([&]() { parallel.sample(settings.seed, gardens, POISSON_MEMBERS, threads[t]); }, iterations);
+            addResult("poisson.place", QString("dart-x%1").arg(threads[t]), count, ns / count);
+        }
+
+        // Spacing and how many fit
+        int placed = parallel.getFlowerCount();
+        double shortfall = std::max(0.0, 1.0 - parallel.findClosest() / parallel.getFlowerSpacing());
+        double missing = 1.0 - placed / (double)count;
+        addCheck(QString("poisson.spacing.%1").arg(count), shortfall);
+        addCheck(QString("poisson.missing.%1").arg(count), missing);
+        okay = okay && shortfall <= POISSON_SPACING_TOLERANCE && missing <= POISSON_MISSING_TOLERANCE;
+        float within = 2.0f * parallel.getFlowerSpacing();
+        fprintf(stdout, "poisson %d: %d gardens, closest flowers %.4f degrees apart, %.4f with random turns\n", count,
+                parallel.getGardenCount(), parallel.findClosest() * 180.0f / M_PI,
+                GardenSampler::findClosest(legacy, within) * 180.0f / M_PI);
+
+        // One thread and every core should place the same flowers
+        single.sample(settings.seed, gardens, POISSON_MEMBERS, 1);
+        int mismatched = single.getFlowerCount() != placed ||
+                         (placed > 0 && memcmp(&single.getDirection(0), &parallel.getDirection(0), placed * sizeof(glm::vec3)) != 0);
+        addCheck(QString("poisson.threads.%1").arg(count), mismatched);
+        okay = okay && mismatched == 0;
+    }
+
+    // Templates' spins, as the turn left over once standing them up is undone
+    GardenSampler sampler;
+    sampler.sample(settings.seed, counts[0] / POISSON_MEMBERS, POISSON_MEMBERS);
+    Philox looks(settings.seed, POISSON_LOOKS_STREAM);
+    FlowerField field;
+    int sectors[POISSON_SPIN_SECTORS] = {};
+    float upright = 1.0f;
+    int templates = sampler.getGardenCount() + 1;
+    for (int g = 0; g < templates; g++) {
+        glm::vec3 up = g + 1 < templates ? sampler.getDirection(sampler.getGardenBegin(g)) : glm::vec3(0, -1, 0);
+        int flower = field.addTemplate(up, looks, g);
+        upright = std::min(upright, glm::dot(glm::normalize(field.getStems().getTranslation(flower)), up));
+        glm::quat spin = glm::inverse(glm::rotation(glm::vec3(0, 1, 0), up)) * field.getStems().getRotation(flower);
+        float angle = fmod(2.0f * atan2(spin.y, spin.w) + 4.0f * (float)M_PI, 2.0f * (float)M_PI);
+        sectors[std::min(POISSON_SPIN_SECTORS - 1, (int)(angle / (2.0f * M_PI) * POISSON_SPIN_SECTORS))]++;
+    }
+    int emptiest = *std::min_element(sectors, sectors + POISSON_SPIN_SECTORS);
+    double spread = std::max(0.0, 1.0 - emptiest * POISSON_SPIN_SECTORS / (double)templates);
+    addCheck("poisson.spin", spread);
+    addCheck("poisson.upright", 1.0 - upright);
+    return okay && spread <= POISSON_SPIN_TOLERANCE && 1.0 - upright <= POISSON_UPRIGHT_TOLERANCE;
+}
+
+/**
+ * @brief Saves and prints one timing
+ * @param kernel What was timed
+ * @param variant Which implementation
+ * @param count Items per iteration
+ * @param nsPerItem Mean wall time per item
+ */
+void MicroBenchmark::addResult(QString kernel, QString variant, int count, double nsPerItem) {
+    MicroResult result;
+    result.kernel = kernel;
+    result.variant = variant;
+    result.count = count;
+    result.nsPerItem = nsPerItem;
+    m_results += result;
+    fprintf(stdout, "%-16s %-14s %8d %10.3f ns/item %12.0f items/s\n", kernel.toStdString().c_str(),
+            variant.toStdString().c_str(), count, nsPerItem, 1e9 / nsPerItem);
+}
+
+/**
+ * @brief Saves and prints how far two variants drifted apart
+ * @param name What was compared
+ * @param maxError The largest difference found
+ */
+void MicroBenchmark::addCheck(QString name, double maxError) {
+    m_checks += qMakePair(name, maxError);
+    fprintf(stdout, "check %-24s max difference %g\n", name.toStdString().c_str(), maxError);
+}
+
+/**
+ * @brief Writes every result and check to the report as JSON
+ * @return If the report could be written
+ */
+bool MicroBenchmark::writeReport() {
+    QFile file(m_report);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        fprintf(stderr, "Couldn't open file for writing: %s\n", m_report.toStdString().c_str());
+        return false;
+    }
+
+    QJsonObject root;
+    root["seed"] = (qint64)settings.seed;
+    root["simdWidth"] = StarField::width();
+
+    QJsonArray results;
+    for (int i = 0; i < m_results.size(); i++) {
+        QJsonObject result;
+        result["kernel"] = m_results.at(i).kernel;
+        result["variant"] = m_results.at(i).variant;
+        result["count"] = m_results.at(i).count;
+        result["nsPerItem"] = m_results.at(i).nsPerItem;
+        result["itemsPerSecond"] = 1e9 / m_results.at(i).nsPerItem;
+        results.append(result);
+    }
+    root["results"] = results;
+
+    QJsonObject checks;
+    for (int i = 0; i < m_checks.size(); i++) checks[m_checks.at(i).first] = m_checks.at(i).second;
+    root["checks"] = checks;
+
+    bool okay = file.write(QJsonDocument(root).toJson()) > 0;
+    if (okay) fprintf(stdout, "Wrote micro-benchmark report to %s\n", m_report.toStdString().c_str());
+    return okay;
+}
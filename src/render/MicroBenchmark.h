@@ -0,0 +1,53 @@
+#ifndef MICROBENCHMARK_H
+#define MICROBENCHMARK_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <vector>
+#include "Noise.h"
+
+/**
+ * @brief One timed kernel at one size
+ */
+struct MicroResult {
+    QString kernel; // What was timed, like "stars.step"
+    QString variant; // Which implementation, like "aos-scalar"
+    int count; // Items processed per iteration
+    double nsPerItem; // Mean wall time per item
+};
+
+/**
+ * @brief Times CPU kernels on their own, without a GL context
+ * Each benchmark runs its kernels at a few sizes against the code they
+ * replaced, checks that both give the same answer, and writes a JSON
+ * report with a row per kernel, variant, and size.
+ */
+class MicroBenchmark {
+public:
+    MicroBenchmark(QString report);
+
+    // Returns a process exit code
+    int run(QString name);
+
+private:
+    bool benchStars();
+    bool benchStarGeneration();
+    bool benchNoise();
+    bool benchOctaves();
+    bool benchNBody();
+    bool benchPoisson();
+    bool shaderNoise(const std::vector<float> &vertices, float seed, NoiseOptions options, std::vector<float> *out,
+                     double *nsPerVertex = NULL);
+    bool checkShader(QString name, const std::vector<float> &cpu, const std::vector<float> &shader);
+
+    void addResult(QString kernel, QString variant, int count, double nsPerItem);
+    void addCheck(QString name, double maxError);
+    bool writeReport();
+
+    QString m_report;
+    QList<MicroResult> m_results;
+    QList<QPair<QString, double> > m_checks; // Largest difference between variants, by name
+};
+
+#endif // MICROBENCHMARK_H
@@ -1,21 +1,55 @@
 #include "PlanetsRenderer.h"
 #include "ResourceLoader.h"
 #include "PlanetDataParser.h"
-#include "Sphere.h"
+#include "PlanetMesh.h"
+#include "PlanetLOD.h"
+#include "PlanetTerrain.h"
+#include "NBodySystem.h"
 #include "GLMath.h"
-#include "GLRenderWidget.h"
+#include "Scene.h"
 #include "Settings.h"
 
+#include <algorithm>
+
 #define DATA_STATIC ":/xml/planetData.xml"
+#define PLANETW 0.75f // The w planet.vert draws positions with
+#define PLANETRADIUS (0.5f/PLANETW)
+#define PLANET_BODY_TEXELS 4 // RGBA texels per body in the body buffer - BODY_TEXELS in planet.vert
+#define TERRAIN_MIN_PIXELS 48.0f // Screen radius a planet needs before it's drawn as terrain
 
 /**
  * @brief Creates the planet data for rendering later
- * @param renderer The GLRenderWidget owning this renderer
+ * @param scene The Scene owning this renderer
  */
-PlanetsRenderer::PlanetsRenderer(GLRenderWidget *renderer) {
+PlanetsRenderer::PlanetsRenderer(Scene *scene) {
     m_textureID = -1;
-    m_renderer = renderer;
+    m_bodyTextureID = -1;
+    m_positionTextureID = -1;
+    m_scene = scene;
     m_shader = 0;
+    m_bakeShader = 0;
+    m_cpuNoise = false;
+    m_seed = 0;
+    m_moon = -1;
+    m_instanceBuffer = 0;
+    m_instanceCapacity = 0;
+    m_instanceLocation = 0;
+    m_uniformViewProjection = -1;
+    m_uniformTime = -1;
+    m_uniformBodies = -1;
+    m_uniformPositions = -1;
+    m_bodyBuffer = 0;
+    m_bodyTexture = 0;
+    m_positionBuffer = 0;
+    m_positionTexture = 0;
+    m_positionsChanged = false;
+    m_substeps = 0;
+    m_planetCount = 0;
+    m_moonNode = SCENE_NO_PARENT;
+    m_nodeSpeed = 0;
+    m_lod = new PlanetLOD();
+    m_terrain = settings.planetTerrain ? new PlanetTerrain() : NULL;
+    m_nbody = settings.nbodyOrbits ? new NBodySystem() : NULL;
 
     // Parse the XML and save the data it creates (after copying to app local data)
     m_file = ResourceLoader::copyFileToLocalData(DATA_STATIC).toStdString();
@@ -26,59 +60,169 @@ PlanetsRenderer::PlanetsRenderer(GLRenderWidget *renderer) {
  * @brief Deletes all planet shape data
  */
 PlanetsRenderer::~PlanetsRenderer() {
-    deleteSpheres();
+    deleteMeshes();
+    delete m_lod;
+    delete m_terrain;
+    delete m_nbody;
+    if (m_instanceBuffer != 0) glDeleteBuffers(1, &m_instanceBuffer);
+    if (m_bodyTexture != 0) glDeleteTextures(1, &m_bodyTexture);
+    if (m_bodyBuffer != 0) glDeleteBuffers(1, &m_bodyBuffer);
+    if (m_positionTexture != 0) glDeleteTextures(1, &m_positionTexture);
+    if (m_positionBuffer != 0) glDeleteBuffers(1, &m_positionBuffer);
 }
 
 /**
  * @brief Assuming m_file is setup, parses all data in and creates resolutions as needed
+ * Belts are made into bodies from the scene seed, so they're the same every refresh.
+ * With --nbody, every body starts over from its place in the data.
  */
 void PlanetsRenderer::parseData() {
-    deleteSpheres();
+    deleteMeshes();
 
     PlanetDataParser parser = PlanetDataParser(m_file.c_str());
     m_resolutions = parser.getResolutions();
-    m_planetData = parser.getPlanets();
+    QList<PlanetData> bodies = parser.getBodies(settings.seed);
+    m_bodies.clear();
+    m_noises.clear();
+    m_moon = -1;
+    m_planetCount = parser.getPlanets().size();
+    for (int i = 0; i < bodies.size(); i++) {
+        PlanetBody body;
+        body.data = bodies.at(i);
+        body.noise = m_noises.indexOf(body.data.noise);
+        if (body.noise < 0) {
+            body.noise = m_noises.size();
+            m_noises.append(body.data.noise);
+        }
+        if (body.data.name == "Moon") m_moon = i;
+        m_bodies.push_back(body);
+    }
+    m_lod->setLevels(m_resolutions, m_bodies.size());
+    if (m_nbody != NULL) m_nbody->reset(bodies);
+
+    // Where every body starts, then size
+    m_positions.resize(m_bodies.size()*4);
+    for (size_t i = 0; i < m_bodies.size(); i++) {
+        const PlanetData &data = m_bodies[i].data;
+        GLfloat position[4] = { data.position.x, data.position.y, data.position.z, data.size };
+        std::copy(position, position + 4, m_positions.begin() + i*4);
+    }
+
+    createBodyBuffer();
+    createMeshes();
+}
+
+/**
+ * @brief Writes every body's orbit and colors to the body buffer planet.vert reads
+ * None of it changes until the bodies do, so it's written here once and
+ * planet.vert works out each body's transform from the time alone. Each
+ * body takes PLANET_BODY_TEXELS texels: unit tilt and 1/day, low color,
+ * high color, then 1/year and threshold. Positions and sizes go in their
+ * own buffer, which --nbody rewrites every frame instead of orbiting.
+ */
+void PlanetsRenderer::createBodyBuffer() {
+    if (m_shader == 0) return;
+    std::vector<GLfloat> texels;
+    texels.reserve(m_bodies.size()*PLANET_BODY_TEXELS*4);
+    for (size_t i = 0; i < m_bodies.size(); i++) {
+        const PlanetData &data = m_bodies[i].data;
+        float tilt = glm::length(data.tilt);
+        glm::vec3 axis = tilt > 0.0f ? data.tilt / tilt : glm::vec3(0,1,0);
+        float year = data.year != 0.0f && m_nbody == NULL ? 1.0f/data.year : 0.0f;
+        GLfloat body[PLANET_BODY_TEXELS*4] = {
+            axis.x, axis.y, axis.z, data.day != 0.0f ? 1.0f/data.day : 0.0f,
+            data.color.low.x, data.color.low.y, data.color.low.z, data.color.low.w,
+            data.color.high.x, data.color.high.y, data.color.high.z, data.color.high.w,
+            year, data.color.threshold, 0.0f, 0.0f
+        };
+        texels.insert(texels.end(), body, body + PLANET_BODY_TEXELS*4);
+    }
+    writeTextureBuffer(&m_bodyBuffer, &m_bodyTexture, texels, GL_STATIC_DRAW);
+    writeTextureBuffer(&m_positionBuffer, &m_positionTexture, m_positions,
+                       m_nbody != NULL ? GL_STREAM_DRAW : GL_STATIC_DRAW);
+    m_positionsChanged = false;
+}
 
-    createSpheres();
+/**
+ * @brief Replaces what's in an RGBA float texture buffer, making it first if need be
+ * @param buffer The buffer, 0 if it hasn't been made yet
+ * @param texture The texture reading the buffer, 0 if it hasn't been made yet
+ * @param texels 4 floats per texel
+ * @param usage How often the buffer will be written
+ */
+void PlanetsRenderer::writeTextureBuffer(GLuint *buffer, GLuint *texture, const std::vector<GLfloat> &texels,
+                                         GLenum usage) {
+    if (*buffer == 0) glGenBuffers(1, buffer);
+    if (*texture == 0) glGenTextures(1, texture);
+    glBindBuffer(GL_TEXTURE_BUFFER, *buffer);
+    glBufferData(GL_TEXTURE_BUFFER, texels.size()*sizeof(GLfloat), texels.empty() ? NULL : &texels[0], usage);
+    glBindTexture(GL_TEXTURE_BUFFER, *texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, *buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
 }
 
 /**
- * @brief Adds a new sphere for every resolution in m_resolutions to map to from PlanetData
+ * @brief Bakes a new mesh with the current seed for every LOD level and distinct noise
+ * Planets sharing their noise share the same meshes, so each resolution is baked
+ * once per distinct noise. Terrain chunks are thrown away too, and made again
+ * with the new seed.
  */
-void PlanetsRenderer::createSpheres() {
+void PlanetsRenderer::createMeshes() {
     if (m_shader == 0) return;
-    for (int i=0; i<m_resolutions.size(); i++) {
-        int res = m_resolutions.at(i);
-        m_planets.insert(res, new Sphere(m_shader, res, res));
+    if (m_terrain != NULL) m_terrain->reset(m_seed);
+    deleteMeshes();
+    for (int n=0; n<m_noises.size(); n++) {
+        for (int level=0; level<m_lod->getLevelCount(); level++) {
+            PlanetMesh *mesh = new PlanetMesh();
+            if (m_cpuNoise) mesh->bakeCPU(m_shader, m_lod->getLevel(level), m_noises.at(n), m_seed);
+            else mesh->bake(m_bakeShader, m_shader, m_lod->getLevel(level), m_noises.at(n), m_seed);
+            m_planets.push_back(mesh);
+        }
     }
+    m_batches.assign(m_planets.size(), std::vector<GLfloat>());
 }
 
 /**
  * @brief Deletes all memory used in m_planets and clears the list
  */
-void PlanetsRenderer::deleteSpheres() {
-    for (int i=0; i<m_planets.size(); i++) {
-        delete m_planets.values().at(i);
+void PlanetsRenderer::deleteMeshes() {
+    for (size_t i=0; i<m_planets.size(); i++) {
+        delete m_planets[i];
     }
     m_planets.clear();
+    m_batches.clear();
 }
 
 /**
- * @brief Loads the noise vertex and fragment shaders and creates two planet shapes
- * The first has low vertices, and the second has high vertices, making them suited
- * to different tasks as a result
+ * @brief Loads the planet shaders and the noise baking shader, then bakes every resolution
  */
 void PlanetsRenderer::createShaderProgram() {
-    m_shader = ResourceLoader::loadShaders(":/shaders/noise.vert", ":/shaders/noise.frag");
-    createSpheres();
+    m_shader = ResourceLoader::loadShaders(":/shaders/planet.vert", ":/shaders/noise.frag");
+    m_instanceLocation = glGetAttribLocation(m_shader, "instance");
+    m_uniformViewProjection = glGetUniformLocation(m_shader, "viewProjection");
+    m_uniformTime = glGetUniformLocation(m_shader, "time");
+    m_uniformBodies = glGetUniformLocation(m_shader, "bodies");
+    m_uniformPositions = glGetUniformLocation(m_shader, "positions");
+    if (m_instanceBuffer == 0) glGenBuffers(1, &m_instanceBuffer);
+    if (m_bodyTextureID < 0) m_bodyTextureID = settings.getAndIncrementTextureIndex();
+    if (m_positionTextureID < 0) m_positionTextureID = settings.getAndIncrementTextureIndex();
+    const char *varyings[] = { "bakedPosition", "bakedNoise" };
+    m_bakeShader = ResourceLoader::loadTransformFeedbackShader(":/shaders/noise.vert", varyings, 2);
+
+    // Baking on the CPU is the fallback if the noise shader won't link
+    m_cpuNoise = settings.cpuPlanetNoise || m_bakeShader == 0;
+    if (m_bakeShader == 0) fprintf(stderr, "Couldn't bake planet noise on the GPU, using the CPU instead\n");
+    createBodyBuffer();
+    createMeshes();
 }
 
 /**
- * @brief Calls on GLRenderWidget to create an FBO
+ * @brief Calls on Scene to create an FBO
  * @param size the size of the FBO
  */
 void PlanetsRenderer::createFBO(glm::vec2 size) {
-    GLRenderWidget::createFBO(&m_FBO, &m_colorAttachment, getTextureID(), size, true);
+    Scene::createFBO(&m_FBO, &m_colorAttachment, getTextureID(), size, true);
 }
 
 /**
@@ -87,6 +231,10 @@ void PlanetsRenderer::createFBO(glm::vec2 size) {
 void PlanetsRenderer::render() {
     glUseProgram(m_shader);
     glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    glActiveTexture(GL_TEXTURE0+m_bodyTextureID);
+    glBindTexture(GL_TEXTURE_BUFFER, m_bodyTexture);
+    glActiveTexture(GL_TEXTURE0+m_positionTextureID);
+    glBindTexture(GL_TEXTURE_BUFFER, m_positionTexture);
     glActiveTexture(GL_TEXTURE0+getTextureID());
     glBindTexture(GL_TEXTURE_2D, m_colorAttachment);
     glClearColor(0,0,0,0);
@@ -97,16 +245,60 @@ void PlanetsRenderer::render() {
 
     // Clear
     glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0+m_bodyTextureID);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0+m_positionTextureID);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glUseProgram(0);
 }
 
 /**
- * @brief Changes seed that the shader uses
+ * @brief Moves every body along its orbit to the current speed, with --nbody
+ * Closed form orbits don't need this - planet.vert works them out itself.
+ * Planet nodes are moved either way, unless the speed is the same as last time.
+ * @param speed The scene's rotational speed
+ */
+void PlanetsRenderer::advance(float speed) {
+    if (m_nbody != NULL && !m_positions.empty()) {
+        m_nbody->advanceTo(speed);
+        m_nbody->positionsAt(speed, &m_positions[0], 4);
+        m_substeps = m_nbody->getStats().substeps;
+        m_positionsChanged = true;
+    }
+    if (speed != m_nodeSpeed) placeNodes(speed);
+}
+
+/**
+ * @brief Changes the noise seed and rebakes every planet mesh with it
+ * Every planet gets a new node under the scene's, placed at the current speed.
  */
 void PlanetsRenderer::refresh() {
     randomizeSeed();
     parseData();
+
+    SceneGraph *graph = m_scene->getSceneGraph();
+    m_nodes.clear();
+    for (int i = 0; i < m_planetCount; i++) {
+        m_nodes.push_back(graph->add(m_scene->getRootNode()));
+    }
+    m_moonNode = m_moon < 0 ? graph->add(m_scene->getRootNode()) : m_nodes[m_moon];
+    placeNodes(m_scene->getRotationalSpeed());
+}
+
+/**
+ * @brief Sets every planet node's transform for a speed
+ * Without a moon, the moon's node follows a default PlanetData instead.
+ * @param speed The scene's rotational speed
+ */
+void PlanetsRenderer::placeNodes(float speed) {
+    SceneGraph *graph = m_scene->getSceneGraph();
+    glm::mat4 identity = glm::mat4(1.0f);
+    for (size_t i = 0; i < m_nodes.size(); i++) {
+        graph->setLocal(m_nodes[i], bodyTransformation(i, speed, identity));
+    }
+    if (m_moon < 0) graph->setLocal(m_moonNode, applyPlanetTrans(speed, PlanetData(), identity));
+    m_nodeSpeed = speed;
 }
 
 /**
@@ -135,42 +327,133 @@ GLuint *PlanetsRenderer::getFBO() {
 }
 
 /**
- * @brief Gets transformation of the moon
- * @param speed The speed of the simulation
- * @return The transformation of the moon as a glm::mat4x4 at speed
+ * @brief Gets the moon's scene graph node, for hanging things from the moon
+ * @return The moon's handle, valid until the next refresh
  */
-glm::mat4x4 PlanetsRenderer::getMoonTransformation(float speed) {
-    return applyPlanetTrans(speed, m_planetData.value("Moon"));
+SceneHandle PlanetsRenderer::getMoonNode() {
+    return m_moonNode;
 }
 
 /**
  * @brief Actually draws the planets
- * Passes the correct info to the shaders for everything in planetData.
- * Also calls render() on the shapes themselves
+ * Each planet is drawn with the mesh its size on screen needs, and while
+ * switching with --lod-fade, with both meshes dithered into each other.
+ * Planets become instances of their meshes, and each mesh is drawn once
+ * with all of them. planet.vert orbits and spins every body from the body
+ * buffer and the time, so the only matrices used here are for terrain.
+ * Each body's center still moves around its orbit here, for picking its
+ * level. With --nbody, the positions advance() found are uploaded first.
+ * With --terrain, planets are drawn as terrain once its faces are
+ * made, with their instance attribute set as a constant.
  */
 void PlanetsRenderer::drawPlanets() {
-    Transforms trans = m_renderer->getTransformation();
-    float speed = m_renderer->getRotationalSpeed();
-
-    // Pass shared info to shader first
-    glUniform1f(glGetUniformLocation(m_shader, "seed"), m_seed);
-
-    GLuint mvp = glGetUniformLocation(m_shader, "mvp");
-    GLuint colorLow = glGetUniformLocation(m_shader, "colorLow");
-    GLuint colorHigh = glGetUniformLocation(m_shader, "colorHigh");
-    GLuint threshold = glGetUniformLocation(m_shader, "threshold");
-
-    // Render all planets based off their size
-    for (int i = 0; i<m_planetData.size(); i++) {
-        PlanetData data = m_planetData.values().at(i);
-        PlanetColor c = data.color;
-        trans.model = applyPlanetTrans(speed, data);
-        glUniform4fv(colorLow, 1, &c.low[0]);
-        glUniform4fv(colorHigh, 1, &c.high[0]);
-        glUniform1f(threshold, c.threshold);
-        glUniformMatrix4fv(mvp, 1, GL_FALSE, &trans.getTransform()[0][0]);
-        m_planets.value(data.resolution)->renderGeometry();
+    Transforms trans = m_scene->getTransformation();
+    float speed = m_scene->getRotationalSpeed();
+    glm::mat4 viewProjection = trans.projection * trans.view;
+    glUniformMatrix4fv(m_uniformViewProjection, 1, GL_FALSE, &viewProjection[0][0]);
+    glUniform1f(m_uniformTime, speed);
+    glUniform1i(m_uniformBodies, m_bodyTextureID);
+    glUniform1i(m_uniformPositions, m_positionTextureID);
+    if (m_positionsChanged) {
+        glBindBuffer(GL_TEXTURE_BUFFER, m_positionBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, m_positions.size()*sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, m_positions.size()*sizeof(GLfloat), &m_positions[0]);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        m_positionsChanged = false;
     }
+    float height = m_scene->getSize().y;
+    const SceneGraph *graph = m_scene->getSceneGraph();
+    m_stats = PlanetStats();
+    m_stats.substeps = m_substeps;
+    if (m_terrain != NULL) m_terrain->beginFrame(m_shader);
+    for (size_t i = 0; i < m_batches.size(); i++) m_batches[i].clear();
+
+    // Sort every planet into the batch of the mesh its size on screen needs
+    int levels = m_lod->getLevelCount();
+    for (int i = 0; i < (int)m_bodies.size(); i++) {
+        const PlanetData &data = m_bodies[i].data;
+        m_stats.planets++;
+
+        glm::vec3 center = glm::vec3(trans.view * glm::vec4(bodyCenter(i, speed), 1.0f));
+        float radius = PlanetLOD::screenRadius(center, PLANETRADIUS*data.size, trans.projection, height);
+
+        // Only big planets on screen get terrain - the belts and specks stay instanced
+        // Terrain sees the sphere at the size planet.vert draws it, planets from their nodes
+        if (m_terrain != NULL && i < m_planetCount && radius >= TERRAIN_MIN_PIXELS) {
+            setTerrainInstance(i);
+            glm::mat4 world = i < (int)m_nodes.size() ? graph->getWorld(m_nodes[i]) :
+                                                       bodyTransformation(i, speed, trans.model);
+            glm::mat4 terrainView = trans.view * world * glm::scale(glm::vec3(1.0f/PLANETW));
+            if (m_terrain->draw(terrainView, trans.projection, height, data.noise)) continue;
+        }
+
+        // New mesh on the first part of the dither, old one on the rest
+        const PlanetLODState &state = m_lod->update(i, data.resolution, radius, settings.planetLODFade);
+        float fade = state.fadeFrames > 0 ? PlanetLOD::fadeAmount(state) : 1.0f;
+        int meshes = m_bodies[i].noise * levels;
+        addInstance(meshes + state.level, i, 0.0f, fade);
+        if (fade < 1.0f) addInstance(meshes + state.previous, i, fade, 1.0f);
+    }
+
+    // One upload for every batch, orphaning last frame's storage
+    m_instanceData.clear();
+    for (size_t i = 0; i < m_batches.size(); i++) {
+        m_instanceData.insert(m_instanceData.end(), m_batches[i].begin(), m_batches[i].end());
+    }
+    int instances = m_instanceData.size() / PLANET_INSTANCE_FLOATS;
+    if (instances > 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+        if (instances > m_instanceCapacity) m_instanceCapacity = instances;
+        glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity*PLANET_INSTANCE_FLOATS*sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, m_instanceData.size()*sizeof(GLfloat), &m_instanceData[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // One draw per mesh with anything in it
+    int first = 0;
+    for (size_t i = 0; i < m_batches.size(); i++) {
+        int count = m_batches[i].size() / PLANET_INSTANCE_FLOATS;
+        if (count == 0) continue;
+        m_planets[i]->drawInstanced(m_instanceBuffer, first, count);
+        m_stats.verticesDrawn += count * m_planets[i]->getVertexCount();
+        m_stats.drawCalls++;
+        first += count;
+    }
+
+    if (m_terrain != NULL) {
+        TerrainStats terrain = m_terrain->getStats();
+        m_stats.verticesDrawn += terrain.verticesDrawn;
+        m_stats.terrainChunks = terrain.chunksDrawn;
+        m_stats.drawCalls += terrain.chunksDrawn;
+    }
+}
+
+/**
+ * @brief Adds one planet to a mesh's batch for this frame
+ * @param mesh Index of the mesh in m_planets
+ * @param body The planet's index in m_bodies, and so in the body buffer
+ * @param ditherStart Start of the dither range drawn
+ * @param ditherEnd End of the dither range drawn
+ */
+void PlanetsRenderer::addInstance(int mesh, int body, float ditherStart, float ditherEnd) {
+    GLfloat instance[PLANET_INSTANCE_FLOATS] = { (GLfloat)body, ditherStart, ditherEnd, 0.0f };
+    m_batches[mesh].insert(m_batches[mesh].end(), instance, instance + PLANET_INSTANCE_FLOATS);
+}
+
+/**
+ * @brief Sets the instance attribute as a constant, for terrain chunks that don't have it
+ * @param body The planet's index in m_bodies, and so in the body buffer
+ */
+void PlanetsRenderer::setTerrainInstance(int body) {
+    glVertexAttrib4f(m_instanceLocation, (GLfloat)body, 0.0f, 1.0f, 0.0f);
+}
+
+/**
+ * @brief Returns what the last frame drew
+ * @return The planet counters
+ */
+PlanetStats PlanetsRenderer::getStats() {
+    return m_stats;
 }
 
 /**
@@ -180,14 +463,51 @@ void PlanetsRenderer::drawPlanets() {
  * rotation. All data except for year rotational axis comes from the PlanetData
  * @param speed The current simulation speed
  * @param trans The saved data to apply to the planet
+ * @param base The scene's model matrix, applied first
  * @return A glm::mat4x4 representing transformations for this planetData at the given speed
  */
-glm::mat4x4 PlanetsRenderer::applyPlanetTrans(float speed, PlanetData trans) {
+glm::mat4x4 PlanetsRenderer::applyPlanetTrans(float speed, const PlanetData &trans, const glm::mat4 &base) {
     return glm::rotate(speed/trans.year, glm::vec3(0,1,0)) *
            glm::translate(trans.position) *
            glm::rotate(speed/trans.day, trans.tilt) *
            glm::scale(glm::vec3(trans.size)) *
-           m_renderer->getTransformation().model;
+           base;
+}
+
+/**
+ * @brief Where a body's center is at a speed, without building its transform
+ * Only the year rotation moves the center - the rest happens around it. With
+ * --nbody, it's wherever advance() last put the body.
+ * @param body The body's index in m_bodies
+ * @param speed The current simulation speed
+ * @return The body's center in world space
+ */
+glm::vec3 PlanetsRenderer::bodyCenter(int body, float speed) {
+    if (m_nbody != NULL) return glm::vec3(m_positions[body*4], m_positions[body*4 + 1], m_positions[body*4 + 2]);
+    const PlanetData &data = m_bodies[body].data;
+    float angle = speed/data.year;
+    float c = cos(angle);
+    float s = sin(angle);
+    const glm::vec3 &p = data.position;
+    return glm::vec3(c*p.x + s*p.z, p.y, c*p.z - s*p.x);
+}
+
+/**
+ * @brief A body's whole transformation, for what has to be placed on the CPU
+ * With --nbody, the body spins and scales the same way but sits wherever
+ * advance() last put it, instead of orbiting.
+ * @param body The body's index in m_bodies
+ * @param speed The current simulation speed
+ * @param base The scene's model matrix, applied first
+ * @return A glm::mat4x4 like applyPlanetTrans gives
+ */
+glm::mat4x4 PlanetsRenderer::bodyTransformation(int body, float speed, const glm::mat4 &base) {
+    const PlanetData &data = m_bodies[body].data;
+    if (m_nbody == NULL) return applyPlanetTrans(speed, data, base);
+    return glm::translate(bodyCenter(body, speed)) *
+           glm::rotate(speed/data.day, data.tilt) *
+           glm::scale(glm::vec3(data.size)) *
+           base;
 }
 
 /**
@@ -4,50 +4,117 @@
 #include "GLCommon.h"
 #include "Renderer.h"
 #include "PlanetDataParser.h"
+#include "Scene.h"
+#include <vector>
 
 class Transforms;
-class Sphere;
-class GLRenderWidget;
+class PlanetMesh;
+class PlanetLOD;
+class PlanetTerrain;
+class NBodySystem;
+class Scene;
+
+/**
+ * @brief A planet or belt body in the flat body table
+ */
+struct PlanetBody {
+    PlanetData data;
+    int noise; // Index into the distinct noise settings - picks the body's meshes with its level
+};
 
 /**
  * @brief Class to support rendering of arbitrary numbers of
  * planets, using the Perlin noise shader to modulate and
- * color them. Relies on Sphere class to actually render
+ * color them. Noise is baked into one PlanetMesh per resolution and
+ * planet noise whenever the seed changes, so drawing is a plain transform. Every
+ * frame, PlanetLOD picks which resolution each planet is drawn with,
+ * unless PlanetTerrain draws it as a quadtree of chunks instead.
+ * Planets and belt bodies live in one flat table, and their orbits and
+ * colors are written once to a body buffer. planet.vert moves every body
+ * along its orbit from the time, so each frame only the body indices are
+ * packed into one instance buffer, grouped by mesh, and every mesh with
+ * planets to draw is drawn with one call. With --nbody, NBodySystem moves
+ * the bodies instead, and their positions are uploaded every frame.
+ * Planets, but not belt bodies, also get scene graph nodes, for whatever
+ * has to be placed on them on the CPU.
  */
 class PlanetsRenderer : public Renderer {
 public:
-    PlanetsRenderer(GLRenderWidget *renderer);
+    PlanetsRenderer(Scene *scene);
     ~PlanetsRenderer();
 
     void createShaderProgram();
     void createFBO(glm::vec2 size);
     void render();
     void refresh();
+    void advance(float speed);
 
     int getTextureID();
     GLuint *getColorAttach();
     GLuint *getFBO();
 
-    glm::mat4x4 getMoonTransformation(float speed);
+    SceneHandle getMoonNode();
+    PlanetStats getStats();
 
 private:
     void drawPlanets();
     void randomizeSeed();
     void parseData();
-    void createSpheres();
-    void deleteSpheres();
-    glm::mat4x4 applyPlanetTrans(float speed, PlanetData trans);
+    void createBodyBuffer();
+    void writeTextureBuffer(GLuint *buffer, GLuint *texture, const std::vector<GLfloat> &texels, GLenum usage);
+    void createMeshes();
+    void deleteMeshes();
+    void addInstance(int mesh, int body, float ditherStart, float ditherEnd);
+    void setTerrainInstance(int body);
+    void placeNodes(float speed);
+    glm::mat4x4 applyPlanetTrans(float speed, const PlanetData &trans, const glm::mat4 &base);
+    glm::vec3 bodyCenter(int body, float speed);
+    glm::mat4x4 bodyTransformation(int body, float speed, const glm::mat4 &base);
 
     // For shaders
     float m_seed;
+    GLuint m_bakeShader; // Captures noised vertices with transform feedback
+    bool m_cpuNoise; // If meshes are baked with Noise instead
 
     // File used for xml data
     std::string m_file;
 
     // Objects
-    QList<int> m_resolutions; // All possible resolutions
-    QHash<QString,PlanetData> m_planetData; // Name to planet
-    QHash<int, Sphere*> m_planets; // Spheres corresponding to resolutions
+    QList<PlanetResolution> m_resolutions; // All possible resolutions
+    std::vector<PlanetBody> m_bodies; // Every planet, then every belt body
+    int m_planetCount; // Bodies before the belts start
+    int m_moon; // The moon's index in m_bodies, -1 if there isn't one
+    std::vector<SceneHandle> m_nodes; // Each planet's node under the scene's, belts don't get one
+    SceneHandle m_moonNode; // The moon's node, or a default orbit's if there's no moon
+    float m_nodeSpeed; // Speed the nodes were last placed at
+    QList<PlanetNoise> m_noises; // Distinct noise settings over all bodies
+    std::vector<PlanetMesh*> m_planets; // Baked meshes, every LOD level for the first noise, then the next
+    GLuint m_bodyBuffer; // PLANET_BODY_TEXELS RGBA texels per body, written when the bodies change
+    GLuint m_bodyTexture; // Texture buffer planet.vert reads m_bodyBuffer through
+    int m_bodyTextureID; // Texture unit m_bodyTexture is bound to
+    std::vector<GLfloat> m_positions; // Every body's position, then size
+    GLuint m_positionBuffer; // m_positions, for planet.vert
+    GLuint m_positionTexture;
+    int m_positionTextureID;
+    bool m_positionsChanged; // If m_positions needs uploading before the next draw
+
+    // Instances, rebuilt every frame
+    std::vector<std::vector<GLfloat> > m_batches; // PLANET_INSTANCE_FLOATS floats per instance, one list per mesh
+    std::vector<GLfloat> m_instanceData; // Every batch one after another, for upload
+    GLuint m_instanceBuffer;
+    int m_instanceCapacity; // Instances the buffer currently has room for
+    GLuint m_instanceLocation; // Terrain sets this as a constant attribute
+    PlanetLOD *m_lod; // Which resolution each planet is drawn with
+    PlanetTerrain *m_terrain; // Chunked terrain for every planet, NULL unless --terrain
+    NBodySystem *m_nbody; // Moves every body under gravity, NULL unless --nbody
+    int m_substeps; // N-body steps the last advance took
+    PlanetStats m_stats; // What the last frame drew
+
+    // Uniform locations, looked up once
+    GLint m_uniformViewProjection;
+    GLint m_uniformTime;
+    GLint m_uniformBodies;
+    GLint m_uniformPositions;
 
 };
 
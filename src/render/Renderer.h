@@ -3,7 +3,7 @@
 
 #include "GLCommon.h"
 
-class GLRenderWidget;
+class Scene;
 
 /**
  * @brief The Renderer interface
@@ -23,7 +23,7 @@ public:
     virtual GLuint *getFBO() = 0;
 
 protected:
-    GLRenderWidget *m_renderer;
+    Scene *m_scene;
 
     // GL needs
     GLuint m_FBO;
@@ -0,0 +1,438 @@
+#include "Scene.h"
+#include "Settings.h"
+#include "GLMath.h"
+#include "ResourceLoader.h"
+
+#include "PlanetsRenderer.h"
+#include "FlowersRenderer.h"
+#include "StarsRenderer.h"
+
+#define MAXMULT 100.0f
+#define MINMULT 0.1f
+
+/**
+ * @brief Sets up default time values - nothing GL related happens until initializeGL
+ */
+Scene::Scene()
+    : m_defaultFBO(0), m_root(SCENE_NO_PARENT), m_stars(NULL), m_planets(NULL), m_flowers(NULL),
+      m_clock(1000.0f / 60.0f), m_fps(60.0f), m_rotationalSpeed(0), m_refreshes(0),
+      m_profiling(false) {}
+
+/**
+ * @brief Deletes the other renderers
+ */
+Scene::~Scene() {
+    delete m_stars;
+    delete m_planets;
+    delete m_flowers;
+}
+
+/**
+ * @brief Creates a GLEW instance, all data, the camera, and relevant GL info/calls
+ * Assumes a GL context is current
+ * @param size The size of the final framebuffer
+ */
+void Scene::initializeGL(glm::vec2 size) {
+    // Set up OpenGL
+    glewExperimental = GL_TRUE;
+    fprintf(stdout, "Using OpenGL Version %s\n", glGetString(GL_VERSION));
+    GLuint err = glewInit();
+    if (err != GLEW_OK) {
+      fprintf(stderr, "Error: %s\n", glewGetErrorString(err));
+    }
+    fprintf(stdout, "Status: Using GLEW %s\n", glewGetString(GLEW_VERSION));
+    m_size = size;
+
+    // Set up renderers
+    m_stars = new StarsRenderer(this);
+    m_planets = new PlanetsRenderer(this);
+    m_flowers  = new FlowersRenderer(m_planets, this);
+
+    // Set up the shader programs and FBOs
+    createShaderPrograms();
+    createFramebufferObjects(size);
+
+    // Create data
+    refresh();
+
+    // Occlusion based on depth, back-face culling, black when cleared
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glFrontFace(GL_CCW);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    // Set up camera
+    CameraData data = CAMERA_DATA_INITIALIZER;
+    data.zoom = M_PI * 2.0f;
+    data.zoomMin = 1.5f;
+    data.zoomMax = 300.0f;
+    data.theta = M_PI * 1.5f;
+    data.fovy = M_PI * 0.25f;
+    data.near = 0.1f;
+    data.far = 1000.0f;
+    m_camera.init(data);
+    updateCamera(); // sets eye
+}
+
+/**
+ * @brief Resizes all buffers and viewport itself
+ * The camera is updated when the size changes because the aspect ratio may change.
+ * @param size The new size
+ */
+void Scene::resizeGL(glm::vec2 size) {
+    m_size = size;
+
+    // Set the viewport to fill the screen
+    glViewport(0, 0, size.x, size.y);
+
+    // Update the camera
+    updateCamera();
+
+    // Resize all used textures
+    createFramebufferObjects(size);
+}
+
+/**
+ * @brief Refreshes all renders
+ * Reseeds rand() first from the settings seed and how many refreshes came
+ * before, so a given seed always replays the same sequence of scenes. The
+ * scene graph starts over too, and renderers add their nodes as they go -
+ * planets before flowers, since flowers hang from the moon.
+ */
+void Scene::refresh() {
+    srand(settings.seed + m_refreshes++);
+    m_graph.clear();
+    m_root = m_graph.add(SCENE_NO_PARENT, m_transform.model);
+    m_stars->refresh();
+    m_planets->refresh();
+    m_flowers->refresh();
+    m_graph.update();
+}
+
+/**
+ * @brief Creates all renderers' shader programs plus the composition one
+ */
+void Scene::createShaderPrograms() {
+    fprintf(stdout, "\nCompiling all shaders...\n");
+    m_stars->createShaderProgram();
+    m_planets->createShaderProgram();
+    m_flowers->createShaderProgram();
+
+    m_shaderTex = ResourceLoader::loadShaders(":/shaders/tex.vert", ":/shaders/tex.frag");
+    m_texquad.init(glGetAttribLocation(m_shaderTex, "position"),
+                   glGetAttribLocation(m_shaderTex, "texCoords"));
+    fprintf(stdout, "\n");
+}
+
+/**
+ * Allocates framebuffer objects for all renderers
+ * @param size The viewport size
+ **/
+void Scene::createFramebufferObjects(glm::vec2 size) {
+    m_stars->createFBO(size);
+    m_planets->createFBO(size);
+    m_flowers->createFBO(size);
+
+    // Clear
+    glBindFramebuffer(GL_FRAMEBUFFER, m_defaultFBO);
+}
+
+/**
+ * @brief Allows a subclass or renderer to create an FBO based on passed in data
+ * @param fbo The pointer to create the FBO at
+ * @param colorAttach The pointer to create the color attachment at
+ * @param texID The ID of the texture, 0 to GL_TEXTURE_MAX_AMOUNT
+ * @param size The size of the FBO
+ * @param depth If depth should also be generated
+ */
+void Scene::createFBO(GLuint *fbo, GLuint *colorAttach, int texID, glm::vec2 size, bool depth) {
+    int width = size.x;
+    int height = size.y;
+
+    glGenFramebuffers(1, fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, *fbo);
+    glActiveTexture(GL_TEXTURE0+texID); // Texture 1 is for planet
+    glGenTextures(1, colorAttach);
+    glBindTexture(GL_TEXTURE_2D, *colorAttach);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *colorAttach, 0);
+
+    // Setup depth if necessary
+    if (!depth) return;
+    GLuint depthI;
+    glGenRenderbuffers(1, &depthI);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthI);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthI);
+}
+
+/**
+ * @brief Assumes rendering of prepasses and blends together renders
+ * Uses output of other renderers to textures to pass those textures to
+ * a shader to blend together as a final output
+ */
+void Scene::renderFinalPass() {
+    // Draw to the screen
+    glBindFramebuffer(GL_FRAMEBUFFER, m_defaultFBO);
+    glClearColor(0,0,0,0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Get shader ready
+    int starID = m_stars->getTextureID();
+    int planetID = m_planets->getTextureID();
+    glUseProgram(m_shaderTex);
+    glUniform1i(glGetUniformLocation(m_shaderTex, "starTex"), starID);
+    glUniform1i(glGetUniformLocation(m_shaderTex, "planetTex"), planetID);
+
+    // Baked static stars, if there are any
+    m_stars->bindSky(m_shaderTex);
+
+    // Bind to the rendered stars texture
+    glActiveTexture(GL_TEXTURE0+starID);
+    glBindTexture(GL_TEXTURE_2D, *m_stars->getColorAttach());
+
+    // Bind to the rendered planet + flowers texture
+    glActiveTexture(GL_TEXTURE0+planetID);
+    glBindTexture(GL_TEXTURE_2D, *m_planets->getColorAttach());
+
+    // Draw
+    renderTexturedQuad();
+
+    // Clear
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_defaultFBO);
+}
+
+/**
+ * @brief Moves simulation time forward in fixed steps if not paused
+ * Stars only change once per step, so dropping or adding frames never changes
+ * where the simulation ends up. Orbits use the interpolated time to stay smooth,
+ * and with --nbody, step however far that needs. Renderers then move their
+ * nodes, and only what moved is worked out again in the scene graph.
+ * @param elapsedMs Real time (ms) since the last update
+ */
+void Scene::update(float elapsedMs) {
+    int steps = m_clock.advance(elapsedMs);
+    for (int i = 0; i < steps; i++) {
+        m_stars->step();
+    }
+    m_rotationalSpeed = m_clock.getInterpolatedTime()/((M_PI)*m_fps);
+    m_planets->advance(m_rotationalSpeed);
+    m_stars->advance(m_rotationalSpeed);
+    m_graph.update();
+}
+
+/**
+ * @brief Updates camera placement and renders all renderers
+ * If profiling, each pass is finished and timed before the next starts
+ */
+void Scene::render() {
+    if (m_profiling) m_passTimer.start();
+
+    m_stars->render();
+    if (m_profiling) m_timing.stars = lap();
+    m_planets->render();
+    if (m_profiling) m_timing.planets = lap();
+    m_flowers->render();
+    if (m_profiling) m_timing.flowers = lap();
+    renderFinalPass();
+    if (m_profiling) {
+        m_timing.finalPass = lap();
+        m_timing.total = m_timing.stars + m_timing.planets + m_timing.flowers + m_timing.finalPass;
+    }
+
+    updateCamera();
+}
+
+/**
+ * @brief Waits on the GPU and gives back time since the last lap
+ * @return Milliseconds since the pass timer was last started
+ */
+float Scene::lap() {
+    glFinish();
+    float ms = m_passTimer.nsecsElapsed() / 1000000.0f;
+    m_passTimer.restart();
+    return ms;
+}
+
+/**
+ * Draws a textured quad. The texture must be bound and unbound
+ * before and after calling this method - this method assumes that the texture
+ * has been bound beforehand using glBindTexture.
+ **/
+void Scene::renderTexturedQuad() {
+    // Clamp value to edge of texture when texture index is out of bounds
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    m_texquad.draw();
+}
+
+/**
+ * @brief Based on width and height, sets eye of camera to correct vector
+ * Also sets the projection of view of the scene based on the data
+ */
+void Scene::updateCamera() {
+    CameraData cData = m_camera.getData();
+
+    float ratio = 1.0f * m_size.x / m_size.y;
+    glm::vec3 dir(-fromAnglesN(cData.theta, cData.phi));
+    glm::vec3 eye(cData.center - dir * cData.zoom);
+
+    m_transform.projection = glm::perspective(cData.fovy, ratio, cData.near, cData.far);
+    m_transform.view = glm::lookAt(eye, cData.center, cData.up);
+
+    m_camera.setData(eye);
+}
+
+/**
+ * @brief Rotates the camera around the center of the scene
+ * @param delta The amount to rotate by in x and y
+ */
+void Scene::rotateCamera(glm::vec2 delta) {
+    m_camera.rotateAroundCenter(delta);
+}
+
+/**
+ * @brief Zooms the camera toward the center of the scene
+ * @param delta The amount to zoom (positive/negative)
+ */
+void Scene::zoomCamera(float delta) {
+    m_camera.zoom(delta);
+}
+
+/**
+ * @brief Makes time go faster, up to MAXMULT
+ */
+void Scene::speedUp() {
+    m_clock.setMultiplier(minN(m_clock.getMultiplier() * 1.1f, MAXMULT));
+}
+
+/**
+ * @brief Makes time go slower, down to MINMULT
+ */
+void Scene::slowDown() {
+    m_clock.setMultiplier(maxN(m_clock.getMultiplier() * 0.9f, MINMULT));
+}
+
+/**
+ * @brief Pauses or unpauses the simulation
+ */
+void Scene::togglePaused() {
+    m_clock.setPaused(!m_clock.isPaused());
+}
+
+/**
+ * @brief Sets the framebuffer the final pass draws into
+ * @param fbo 0 for a window, or any complete FBO
+ */
+void Scene::setDefaultFramebuffer(GLuint fbo) {
+    m_defaultFBO = fbo;
+}
+
+/**
+ * @brief Turns per pass timing on or off - slows rendering when on
+ * @param profiling If each pass should be timed
+ */
+void Scene::setProfiling(bool profiling) {
+    m_profiling = profiling;
+}
+
+/**
+ * @brief Returns the pass timings of the last rendered frame
+ * @return m_timing
+ */
+FrameTiming Scene::getLastFrameTiming() {
+    return m_timing;
+}
+
+/**
+ * @brief Returns how many stars were drawn in the last frame
+ * @return The star renderer's culling counters
+ */
+StarStats Scene::getStarStats() {
+    return m_stars->getStats();
+}
+
+/**
+ * @brief Returns how much planet geometry was drawn in the last frame
+ * @return The planet renderer's counters
+ */
+PlanetStats Scene::getPlanetStats() {
+    return m_planets->getStats();
+}
+
+/**
+ * @brief Returns how much of the garden was drawn in the last frame
+ * @return The flower renderer's culling counters
+ */
+FlowerStats Scene::getFlowerStats() {
+    return m_flowers->getStats();
+}
+
+/**
+ * @brief Returns the current camera
+ * @return m_camera
+ */
+Camera Scene::getCamera() {
+    return m_camera;
+}
+
+/**
+ * @brief Returns the current camera transformation
+ * @return m_transform
+ */
+Transforms Scene::getTransformation() {
+    return m_transform;
+}
+
+/**
+ * @brief Returns the size of the final framebuffer
+ * @return m_size
+ */
+glm::vec2 Scene::getSize() {
+    return m_size;
+}
+
+/**
+ * @brief Returns the rotational speed for simulation
+ * @return m_rotationalSpeed
+ */
+float Scene::getRotationalSpeed() {
+    return m_rotationalSpeed;
+}
+
+/**
+ * @brief Returns how far between the last two simulation steps we're drawing
+ * @return A float in [0,1)
+ */
+float Scene::getInterpolationAlpha() {
+    return m_clock.getAlpha();
+}
+
+/**
+ * @brief Returns if the simulation is paused
+ * @return If the clock is paused
+ */
+bool Scene::getPaused() {
+    return m_clock.isPaused();
+}
+
+/**
+ * @brief Returns the scene graph renderers place their nodes in
+ * @return A pointer to m_graph
+ */
+SceneGraph *Scene::getSceneGraph() {
+    return &m_graph;
+}
+
+/**
+ * @brief Returns the node for the scene's model transform
+ * @return m_root, valid from the start of each refresh
+ */
+SceneHandle Scene::getRootNode() {
+    return m_root;
+}
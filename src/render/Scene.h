@@ -0,0 +1,170 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "GLCommon.h"
+#include "Camera.h"
+#include "Transforms.h"
+#include "TexturedQuad.h"
+#include "SimulationClock.h"
+#include "SceneGraph.h"
+
+#include <QElapsedTimer>
+
+// Forward declared classes
+class StarsRenderer;
+class PlanetsRenderer;
+class FlowersRenderer;
+
+/**
+ * @brief Wall times (ms) for each pass of one frame
+ * Only filled in when profiling is turned on, since every pass
+ * has to be finished on the GPU before the next one is timed
+ */
+struct FrameTiming {
+    FrameTiming() : stars(0), planets(0), flowers(0), finalPass(0), total(0) {}
+
+    float stars;
+    float planets;
+    float flowers;
+    float finalPass;
+    float total;
+};
+
+/**
+ * @brief How much of the sky survived culling in one frame
+ * Only static stars are counted - shooting stars are culled one by one
+ */
+struct StarStats {
+    StarStats() : tiles(0), tilesDrawn(0), stars(0), starsDrawn(0) {}
+
+    int tiles; // Sky grid tiles
+    int tilesDrawn; // Tiles that passed the frustum and horizon tests
+    int stars; // Static stars
+    int starsDrawn; // Static stars submitted to draw
+};
+
+/**
+ * @brief How much planet geometry one frame drew
+ * Vertices only count each shared vertex once per draw
+ */
+struct PlanetStats {
+    PlanetStats() : planets(0), verticesDrawn(0), terrainChunks(0), drawCalls(0), substeps(0) {}
+
+    int planets; // Planets and belt bodies drawn
+    int verticesDrawn; // Vertices of every mesh drawn, both meshes while cross fading
+    int terrainChunks; // Terrain chunks drawn, over all planets
+    int drawCalls; // Instanced mesh draws plus terrain chunk draws
+    int substeps; // N-body steps taken to reach this frame, 0 without --nbody
+};
+
+/**
+ * @brief How much of the garden survived culling in one frame
+ * Parts are stems, centers, and petals, each one instance or baked shape
+ */
+struct FlowerStats {
+    FlowerStats() : clusters(0), clustersDrawn(0), flowers(0), flowersDrawn(0), partsDrawn(0), partsCulled(0), drawCalls(0) {}
+
+    int clusters; // Gardens, each a template and its neighbours
+    int clustersDrawn; // Clusters with any flower that passed the horizon and frustum tests
+    int flowers;
+    int flowersDrawn; // Flowers submitted to draw
+    int partsDrawn; // Parts submitted to draw
+    int partsCulled; // Parts left out
+    int drawCalls; // Instanced draws, or one multi-draw for a baked garden
+};
+
+/**
+ * @brief The Scene class
+ * Owns everything needed to draw a frame: the camera, the simulation
+ * time, the scene graph, and the star, planet, and flower renderers.
+ * Renderers add their nodes on refresh and move them on update, and the
+ * graph is brought up to date once before drawing. Doesn't know about
+ * windows at all, so it can be driven by GLRenderWidget or by the
+ * headless benchmark with any GL context current. Draws into
+ * whatever framebuffer is set as the default (0 for a widget).
+ */
+class Scene {
+public:
+    Scene();
+    ~Scene();
+
+    // Set up an FBO the right way
+    static void createFBO(GLuint *fbo, GLuint *colorAttach, int texId, glm::vec2 size, bool depth);
+
+    // Needs a current GL context
+    void initializeGL(glm::vec2 size);
+    void resizeGL(glm::vec2 size);
+
+    // Recreates all data, doesn't move camera or reset time
+    void refresh();
+
+    // Advances the simulation by some real time (ms) in fixed steps, and draws a frame
+    void update(float elapsedMs);
+    void render();
+
+    // User interaction
+    void rotateCamera(glm::vec2 delta);
+    void zoomCamera(float delta);
+    void speedUp();
+    void slowDown();
+    void togglePaused();
+
+    // Where the final pass ends up, and whether to time passes
+    void setDefaultFramebuffer(GLuint fbo);
+    void setProfiling(bool profiling);
+    FrameTiming getLastFrameTiming();
+    StarStats getStarStats();
+    PlanetStats getPlanetStats();
+    FlowerStats getFlowerStats();
+
+    // Getters for other renderers
+    Camera getCamera();
+    Transforms getTransformation();
+    glm::vec2 getSize();
+    float getRotationalSpeed();
+    float getInterpolationAlpha();
+    bool getPaused();
+    SceneGraph *getSceneGraph();
+    SceneHandle getRootNode();
+
+private:
+    // OpenGL creation, rendering
+    void createShaderPrograms();
+    void createFramebufferObjects(glm::vec2 size);
+    void renderTexturedQuad();
+    void renderFinalPass();
+
+    // Updates camera based on current size
+    void updateCamera();
+
+    // Finishes GL work and gives back ms since the last lap (profiling only)
+    float lap();
+
+    // Scene variables
+    Camera m_camera; // Camera of scene
+    Transforms m_transform; // Current scene transform
+    TexturedQuad m_texquad; // Global texQuad used when drawing to screen
+    glm::vec2 m_size; // Size of the final framebuffer
+    GLuint m_defaultFBO; // Final framebuffer
+    SceneGraph m_graph; // Every transform placed on the CPU, rebuilt every refresh
+    SceneHandle m_root; // The scene's model transform, which planets hang from
+
+    // Renderers
+    GLuint m_shaderTex;
+    StarsRenderer *m_stars; // Renders all stars
+    PlanetsRenderer *m_planets; // Renders all planets
+    FlowersRenderer *m_flowers; // Renders all flowers
+
+    // Time
+    SimulationClock m_clock; // Fixed step simulation time, pausing, and speed
+    float m_fps;
+    float m_rotationalSpeed; // Current rotational speed
+    int m_refreshes; // Times refreshed, to vary the seed reproducibly
+
+    // Profiling
+    bool m_profiling;
+    QElapsedTimer m_passTimer;
+    FrameTiming m_timing;
+};
+
+#endif // SCENE_H
@@ -0,0 +1,127 @@
+#include "StarSimulation.h"
+#include "ResourceLoader.h"
+#include "Particle.h"
+
+#include <algorithm>
+
+/**
+ * @brief Sets up an empty simulation - nothing is created until init()
+ */
+StarSimulation::StarSimulation()
+    : m_shader(0), m_current(0), m_count(0), m_capacity(0), m_uniformSeed(-1), m_uniformStepCount(-1) {
+    m_buffers[0] = m_buffers[1] = 0;
+    m_vaos[0] = m_vaos[1] = 0;
+}
+
+/**
+ * @brief Deletes the buffers, VAOs, and shader
+ */
+StarSimulation::~StarSimulation() {
+    if (m_vaos[0] != 0) glDeleteVertexArrays(2, m_vaos);
+    if (m_buffers[0] != 0) glDeleteBuffers(2, m_buffers);
+    if (m_shader != 0) glDeleteProgram(m_shader);
+}
+
+/**
+ * @brief Loads the simulation shader and makes a VAO reading from each buffer
+ * @param maxLife The life stars bounce back from
+ * @param spread How far out on each axis shooting stars can respawn
+ * @return If the shader linked - the simulation can't be used otherwise
+ */
+bool StarSimulation::init(float maxLife, float spread) {
+    const char *varyings[] = { "outPosLife", "outDirDecay" };
+    m_shader = ResourceLoader::loadTransformFeedbackShader(":/shaders/starSim.vert", varyings, 2);
+    if (m_shader == 0) return false;
+
+    m_uniformSeed = glGetUniformLocation(m_shader, "seed");
+    m_uniformStepCount = glGetUniformLocation(m_shader, "stepCount");
+    glUseProgram(m_shader);
+    glUniform1f(glGetUniformLocation(m_shader, "maxLife"), maxLife);
+    glUniform1f(glGetUniformLocation(m_shader, "spread"), spread);
+    glUseProgram(0);
+
+    GLuint posLife = glGetAttribLocation(m_shader, "posLife");
+    GLuint dirDecay = glGetAttribLocation(m_shader, "dirDecay");
+    GLsizei stride = PARTICLE_INSTANCE_FLOATS*sizeof(GLfloat);
+
+    glGenBuffers(2, m_buffers);
+    glGenVertexArrays(2, m_vaos);
+    for (int i = 0; i < 2; i++) {
+        glBindVertexArray(m_vaos[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffers[i]);
+        glEnableVertexAttribArray(posLife);
+        glVertexAttribPointer(posLife, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        glEnableVertexAttribArray(dirDecay);
+        glVertexAttribPointer(dirDecay, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4*sizeof(GLfloat)));
+    }
+
+    // Clean up
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    return true;
+}
+
+/**
+ * @brief Copies star state into both buffers, resizing them if needed
+ * @param data PARTICLE_INSTANCE_FLOATS floats per star
+ * @param count The number of stars in data
+ */
+void StarSimulation::upload(const GLfloat *data, int count) {
+    GLsizeiptr size = count*PARTICLE_INSTANCE_FLOATS*sizeof(GLfloat);
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffers[i]);
+        if (count > m_capacity) glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_COPY);
+        else glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_capacity = std::max(m_capacity, count);
+    m_count = count;
+    m_current = 0;
+}
+
+/**
+ * @brief Runs every star through the simulation shader once, with rasterizing off
+ * The result goes to the other buffer, which becomes the current one.
+ * @param seed Seed for respawning shooting stars
+ * @param stepCount Steps taken so far, so every step respawns differently
+ */
+void StarSimulation::step(unsigned int seed, unsigned int stepCount) {
+    if (m_shader == 0 || m_count == 0) return;
+    int next = 1 - m_current;
+
+    glUseProgram(m_shader);
+    glUniform1ui(m_uniformSeed, seed);
+    glUniform1ui(m_uniformStepCount, stepCount);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(m_vaos[m_current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_buffers[next]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, m_count);
+    glEndTransformFeedback();
+
+    // Clean up
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    glUseProgram(0);
+
+    m_current = next;
+}
+
+/**
+ * @brief Returns the buffer holding the latest star state
+ * @return A GLuint for a buffer laid out like Particle's instances
+ */
+GLuint StarSimulation::getCurrentBuffer() {
+    return m_buffers[m_current];
+}
+
+/**
+ * @brief Returns if init() succeeded
+ * @return If the simulation can be stepped
+ */
+bool StarSimulation::isInitialized() {
+    return m_shader != 0;
+}
@@ -0,0 +1,43 @@
+#ifndef STARSIMULATION_H
+#define STARSIMULATION_H
+
+#include "GLCommon.h"
+
+/**
+ * @brief Steps stars entirely on the GPU with transform feedback
+ * Star state lives in two buffers laid out exactly like Particle's
+ * instances (position + life, direction + decay). Each step reads one
+ * and writes the other, so after the first upload the CPU never touches
+ * star data again - the current buffer is drawn from directly.
+ */
+class StarSimulation {
+public:
+    StarSimulation();
+    ~StarSimulation();
+
+    // Needs a current GL context, returns false if the shader didn't link
+    bool init(float maxLife, float spread);
+
+    // Replaces all stars, PARTICLE_INSTANCE_FLOATS floats each
+    void upload(const GLfloat *data, int count);
+
+    // Advances every star by one fixed step
+    void step(unsigned int seed, unsigned int stepCount);
+
+    GLuint getCurrentBuffer();
+    bool isInitialized();
+
+private:
+    GLuint m_shader;
+    GLuint m_buffers[2]; // Ping-pong star state
+    GLuint m_vaos[2]; // Reads from the matching buffer
+    int m_current; // Which buffer holds the latest state
+    int m_count; // Number of stars in each buffer
+    int m_capacity; // Stars each buffer has room for
+
+    // Uniform locations, looked up once
+    GLint m_uniformSeed;
+    GLint m_uniformStepCount;
+};
+
+#endif // STARSIMULATION_H
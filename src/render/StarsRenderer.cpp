@@ -1,54 +1,148 @@
 #include "StarsRenderer.h"
 #include "ResourceLoader.h"
-#include "GLRenderWidget.h"
+#include "Scene.h"
 #include "Settings.h"
+#include "StarGenerator.h"
 
-#define NUMPARTICLES 4000
+#define NUMSTATIC 3880 // Stars that never move, unless settings.staticStars says otherwise
+#define NUMSHOOTING 120 // Stars that move, stepped every simulation step
 #define MAXLIFE 150.0f
 #define SPREAD 450.0f
 #define MINRADIUS 125.0f
-#define TAILLENGTH 6
-#define TAILCONTRIB 0.5f
+#define TRAILDECAY 0.55f // Trail brightness left after one step
+#define MAXSTREAK 4.0f // Most steps a shooting star is stretched over in one frame
 #define STARCOLOR glm::vec3(0.9f, 0.7f, 0.8f)
 #define SHOOTINGCOLOR glm::vec3(0.8f, 0.5f, 0.4f)
-#define SHOOTINGTHRESHOLD 0.97f
-#define TWINKLINGTHRESHOLD 0.5f
+#define SKYTILES 16 // Sky grid tiles along each cube face edge
+#define STARRADIUS 1.5f // Furthest a static star's quad reaches from its center
+#define SKYFACESIZE 1024 // Size of each face of the baked sky
+#define SKYRADIUS 360.0f // Radius baked stars are projected onto - past the furthest zoom
+#define SKYTURN 700.0f // Rotational speed per radian the sky turns
+#define SKYAXIS glm::vec3(0,1,-0.75f) // What the sky turns around
 
 /**
- * @brief Saves GLRenderWidget and makes a new particle data array
- * @param renderer The GLRenderWidget running everything
+ * @brief Saves Scene and makes room for packed stars
+ * @param scene The Scene running everything
  */
-StarsRenderer::StarsRenderer(GLRenderWidget *renderer) {
+StarsRenderer::StarsRenderer(Scene *scene) : m_skyGrid(SKYTILES) {
     m_textureID = -1;
-    m_renderer = renderer;
-    m_starData = new ParticleData[NUMPARTICLES];
+    m_scene = scene;
+    m_instanceData.resize(NUMSHOOTING*PARTICLE_INSTANCE_FLOATS);
+    m_gpuSimulation = false;
+    m_numStatic = 0;
+    m_seed = 0;
+    m_steps = 0;
+    m_skyNode = SCENE_NO_PARENT;
+    m_skySpeed = 0;
+    m_trailTextureID = -1;
+    m_trailFBOs[0] = m_trailFBOs[1] = 0;
+    m_trailTextures[0] = m_trailTextures[1] = 0;
+    m_currentTrail = 0;
+    m_lastTrailTime = 0;
+    m_skyCubemap = settings.skyCubemap;
+    m_skyFBO = 0;
+    m_skyTexture = 0;
+    m_skyTextureID = -1;
 }
 
 /**
- * @brief Simply deletes all particle data
+ * @brief Deletes the trail targets and baked sky - everything else cleans up after itself
  */
 StarsRenderer::~StarsRenderer() {
-    delete[] m_starData;
+    deleteTrailTargets();
+    if (m_skyFBO != 0) {
+        glDeleteFramebuffers(1, &m_skyFBO);
+        glDeleteTextures(1, &m_skyTexture);
+    }
 }
 
 /**
  * @brief Creates a particle and loads the star shaders, passing the right attribs in
+ * Constant uniforms are set here once, the rest are looked up for drawStars
  */
 void StarsRenderer::createShaderProgram() {
     m_shader = ResourceLoader::loadShaders(":/shaders/star.vert",":/shaders/star.frag");
     GLuint pos = glGetAttribLocation(m_shader, "position");
     GLuint texCoord = glGetAttribLocation(m_shader, "texCoord");
 
-    // Create a particle
+    // Create particles, drawn once per star - static stars only need position and twinkle phase
+    GLuint posLife = glGetAttribLocation(m_shader, "posLife");
     m_particle.init(pos, texCoord);
+    m_particle.initInstances(posLife, glGetAttribLocation(m_shader, "dirDecay"));
+    m_staticParticle.init(pos, texCoord);
+    m_staticParticle.initInstances(posLife);
+
+    m_uniformVP = glGetUniformLocation(m_shader, "vp");
+    m_uniformRotation = glGetUniformLocation(m_shader, "atmosphericRotation");
+    m_uniformEye = glGetUniformLocation(m_shader, "eye");
+    m_uniformAlpha = glGetUniformLocation(m_shader, "alpha");
+    m_uniformStreak = glGetUniformLocation(m_shader, "streak");
+    m_uniformTwinkle = glGetUniformLocation(m_shader, "twinkle");
+    m_uniformTwinkleTime = glGetUniformLocation(m_shader, "twinkleTime");
+    m_uniformBake = glGetUniformLocation(m_shader, "bake");
+
+    glUseProgram(m_shader);
+    glUniform1f(glGetUniformLocation(m_shader, "maxLife"), MAXLIFE);
+    glUniform3fv(glGetUniformLocation(m_shader, "starColor"), 1, glm::value_ptr(STARCOLOR));
+    glUniform3fv(glGetUniformLocation(m_shader, "shootingColor"), 1, glm::value_ptr(SHOOTINGCOLOR));
+    glUseProgram(0);
+
+    // Fades last frame's trails, and adds them to the stars
+    m_trailShader = ResourceLoader::loadShaders(":/shaders/tex.vert", ":/shaders/trail.frag");
+    m_trailQuad.init(glGetAttribLocation(m_trailShader, "position"),
+                     glGetAttribLocation(m_trailShader, "texCoords"));
+    m_uniformTrailTex = glGetUniformLocation(m_trailShader, "trailTex");
+    m_uniformTrailDecay = glGetUniformLocation(m_trailShader, "decay");
+
+    // Stepping on the GPU falls back to the CPU if the simulation shader won't link
+    if (settings.gpuStarSimulation) {
+        m_gpuSimulation = m_simulation.init(MAXLIFE, SPREAD);
+        if (!m_gpuSimulation) fprintf(stderr, "Couldn't simulate stars on the GPU, using the CPU instead\n");
+    }
 }
 
 /**
- * @brief Creates a new FBO for this renderer
+ * @brief Creates a new FBO for this renderer, and the two trail targets
+ * Trails are half floats so they can fade slowly without getting stuck
+ * on the smallest 8 bit value.
  * @param size The FBO size
  */
 void StarsRenderer::createFBO(glm::vec2 size) {
-    GLRenderWidget::createFBO(&m_FBO, &m_colorAttachment, getTextureID(), size, false);
+    Scene::createFBO(&m_FBO, &m_colorAttachment, getTextureID(), size, false);
+
+    deleteTrailTargets();
+    if (m_trailTextureID < 0) m_trailTextureID = settings.getAndIncrementTextureIndex();
+    glGenFramebuffers(2, m_trailFBOs);
+    glGenTextures(2, m_trailTextures);
+    glActiveTexture(GL_TEXTURE0+m_trailTextureID);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, m_trailTextures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, size.x, size.y, 0, GL_RGBA, GL_FLOAT, NULL);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_trailFBOs[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_trailTextures[i], 0);
+        glClearColor(0,0,0,0);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    // Clean up
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/**
+ * @brief Deletes both trail FBOs and their textures, if they exist
+ */
+void StarsRenderer::deleteTrailTargets() {
+    if (m_trailFBOs[0] == 0) return;
+    glDeleteFramebuffers(2, m_trailFBOs);
+    glDeleteTextures(2, m_trailTextures);
+    m_trailFBOs[0] = m_trailFBOs[1] = 0;
+    m_trailTextures[0] = m_trailTextures[1] = 0;
 }
 
 /**
@@ -80,13 +174,59 @@ void StarsRenderer::render() {
 
 /**
  * @brief Create entirely different stars for all of the particles
+ * Static stars are made on every core and uploaded once here, then never
+ * touched again, so there can be millions of them. Only the shooting stars
+ * are kept to step. Every star depends only on the seed and its index.
+ * The sky's rotation gets a node of its own, since it doesn't follow the
+ * scene's model transform.
  */
 void StarsRenderer::refresh() {
-    for (int i = 0; i<NUMPARTICLES; i++) {
-        setupStar(i);
+    m_skyNode = m_scene->getSceneGraph()->add(SCENE_NO_PARENT, glm::rotate(m_skySpeed/SKYTURN, SKYAXIS));
+    advance(m_scene->getRotationalSpeed());
+    m_seed = rand();
+    m_steps = 0;
+    m_lastTrailTime = 0;
+    StarGenerator generator(m_seed, MINRADIUS, SPREAD, MAXLIFE);
+
+    m_numStatic = settings.staticStars > 0 ? settings.staticStars : NUMSTATIC;
+    std::vector<GLfloat> staticData(m_numStatic*4);
+    generator.staticStars(m_numStatic, &staticData[0]);
+    m_staticParticle.setInstances(&staticData[0], m_numStatic, GL_STATIC_DRAW);
+    if (m_skyCubemap) bakeSky();
+    else m_skyGrid.build(staticData, 4, STARRADIUS);
+
+    m_starField.resize(NUMSHOOTING);
+    for (int i = 0; i<NUMSHOOTING; i++) {
+        m_starField.set(i, generator.shootingStar(i));
+    }
+
+    // The GPU keeps its own copy from here on
+    if (m_gpuSimulation) {
+        m_starField.pack(&m_instanceData[0]);
+        m_simulation.upload(&m_instanceData[0], NUMSHOOTING);
     }
 }
 
+/**
+ * @brief Moves and fades every shooting star by one fixed step of simulation time
+ * Static stars twinkle as a function of m_steps, so they need nothing here
+ */
+void StarsRenderer::step() {
+    if (m_gpuSimulation) m_simulation.step(m_seed, m_steps);
+    else m_starField.step(MAXLIFE, SPREAD, m_seed, m_steps);
+    m_steps++;
+}
+
+/**
+ * @brief Returns how much of the sky was drawn last frame
+ * @return Tile and static star counts
+ */
+StarStats StarsRenderer::getStats() {
+    m_stats.tiles = m_skyGrid.getTileCount();
+    m_stats.stars = m_numStatic;
+    return m_stats;
+}
+
 /**
  * @brief Gets the texture ID associated with this renderer
  * @return An int used to add to GL_TEXTURE0 to get a unique texture
@@ -113,163 +253,221 @@ GLuint *StarsRenderer::getFBO() {
 }
 
 /**
- * @brief Renders all stars with some optimizations
- * Gets saved data, then loops through all particle data and checks for
- * viewability. If outside viewport, culls the drawing of them. Passes
- * the right shader variables, and draws the particle. If a shooting
- * star, renders the tail too.
+ * @brief Renders all stars with a few instanced draws
+ * Static stars come straight from their buffer, one draw per run of sky
+ * tiles that pass culling, with life worked out in the shader from their
+ * phase and the time. Shooting stars on the CPU are packed only if they
+ * face away from the eye; on the GPU they're drawn from the simulation's
+ * latest buffer. Either way they go into the trails, not straight to the
+ * stars. Billboarding and the atmospheric rotation happen per instance,
+ * so the CPU only sets uniforms once per frame.
  */
 void StarsRenderer::drawStars() {
-    glm::vec3 eye = glm::normalize(m_renderer->getCamera().getData().eye);
-    bool isPaused = m_renderer->getPaused();
+    // Shared info for every star
+    Transforms trans = m_scene->getTransformation();
+    glm::mat4x4 vp = trans.projection * trans.view;
     glm::mat4x4 atmosphericRotation = getAtmosphericRotation();
-
-    for(int i =0; i<NUMPARTICLES; i++) {
-        glm::vec3 np = glm::normalize(-m_starData[i].pos);
-
-        // Manual backface culling
-        if (glm::dot(eye, glm::vec3(atmosphericRotation * glm::vec4(np, 1.f))) > 0) {
-            glm::vec3 n = glm::vec3(0.0f,0.0f,1.0f);
-            glm::vec3 axis = glm::cross(n, np);
-            float angle = glm::acos(glm::dot(n, np) / (glm::length(glm::vec4(n,0.0f)) * glm::length(glm::vec4(np,0.0f))));
-
-            // Actual drawing
-            drawBody(i, angle, axis);
-            if (isShootingStar(i)) drawTail(i, angle, axis);
+    glm::vec3 eye = glm::normalize(m_scene->getCamera().getData().eye);
+    float alpha = m_scene->getInterpolationAlpha();
+    glUniformMatrix4fv(m_uniformVP, 1, GL_FALSE, &vp[0][0]);
+    glUniformMatrix4fv(m_uniformRotation, 1, GL_FALSE, &atmosphericRotation[0][0]);
+    glUniform3fv(m_uniformEye, 1, &eye[0]);
+    glUniform1f(m_uniformAlpha, alpha);
+    glUniform1f(m_uniformStreak, 0);
+
+    // Static stars in tiles that might be seen, culled in the sky's own space - baked ones come in the final pass
+    if (m_skyCubemap) {
+        m_stats.starsDrawn = 0;
+        m_stats.tilesDrawn = 0;
+    } else {
+        glm::vec3 skyEye = glm::transpose(glm::mat3(atmosphericRotation)) * eye;
+        m_stats.starsDrawn = m_skyGrid.cull(vp * atmosphericRotation, skyEye, &m_visibleRanges);
+        m_stats.tilesDrawn = m_skyGrid.getTilesDrawn();
+
+        // Wrapping time to one twinkle so it never loses precision
+        glUniform1i(m_uniformTwinkle, 1);
+        glUniform1f(m_uniformTwinkleTime, fmod(m_steps + alpha, 2.0f*MAXLIFE));
+        for (size_t i = 0; i < m_visibleRanges.size(); i++) {
+            m_staticParticle.drawInstanced(m_visibleRanges[i].y, 1, m_visibleRanges[i].x);
         }
+        glUniform1i(m_uniformTwinkle, 0);
+    }
 
-        // Only calculate new data if the simulation isn't paused
-        if (!isPaused) calculateData(i);
+    int numShooting = NUMSHOOTING;
+    if (m_gpuSimulation) {
+        m_particle.setInstanceBuffer(m_simulation.getCurrentBuffer());
+    } else {
+        int visibleShooting;
+        numShooting = m_starField.packVisible(eye, glm::mat3(atmosphericRotation), NUMSHOOTING,
+                                              &m_instanceData[0], &visibleShooting);
+        m_particle.setInstances(&m_instanceData[0], numShooting);
     }
+    drawTrails(numShooting, m_steps + alpha);
 }
 
 /**
- * @brief Draws one celestial body given star index, angle, and axis
- * @param i The index of the star
- * @param angle The angle to rotate by to face user
- * @param axis The axis of rotation to face user
+ * @brief Fades the trails, adds the shooting stars to them, and adds them to the stars
+ * The trails ping-pong between two targets: last frame's is drawn into the
+ * other one dimmed by TRAILDECAY per step since, so the cost is one full
+ * screen pass no matter how many stars or how long the trails. Each star
+ * is stretched back over the steps since last frame so trails don't
+ * break up into dots.
+ * @param numShooting How many shooting stars are in m_particle's instances
+ * @param time Steps since refresh, including the interpolated part
  */
-void StarsRenderer::drawBody(int i, float angle, glm::vec3 axis) {
-    // Transformation computation
-    Transforms trans = m_renderer->getTransformation();
-    trans.model =
-            getAtmosphericRotation() *
-            glm::translate(m_starData[i].pos) *
-            glm::rotate(angle, axis) *
-            trans.model;
-
-    // Pass shader info
-    glUniformMatrix4fv(glGetUniformLocation(m_shader, "mvp"), 1, GL_FALSE, &trans.getTransform()[0][0]);
-    glUniformMatrix4fv(glGetUniformLocation(m_shader, "m"), 1, GL_FALSE, &trans.model[0][0]);
-    glUniform4f(glGetUniformLocation(m_shader, "color"),
-            m_starData[i].color.x,
-            m_starData[i].color.y,
-            m_starData[i].color.z,
-            m_starData[i].life / MAXLIFE);
-
-    // Draw it!
-    m_particle.draw();
-}
+void StarsRenderer::drawTrails(int numShooting, float time) {
+    float elapsed = glm::clamp(time - m_lastTrailTime, 0.0f, MAXSTREAK);
+    m_lastTrailTime = time;
+    int next = 1 - m_currentTrail;
 
-/**
- * @brief Draws the tail of a shooting star
- * @param i The index of the star to draw the tail for
- * @param angle The angle to move in so the particle is facing the user
- * @param axis The axis about which to rotate the particle
- */
-void StarsRenderer::drawTail(int i, float angle, glm::vec3 axis) {
-    glm::mat4x4 atmosphericRotation = getAtmosphericRotation();
-    float alpha = m_starData[i].life / MAXLIFE;
-
-    // For length of tail, calculate new offset and scale
-    for (int dt = 0; dt <= TAILLENGTH; dt++) {
-        float contrib = 1.0f/((float)dt);
-        glm::vec3 newPos = glm::vec3(m_starData[i].pos - TAILCONTRIB*dt*m_starData[i].dir);
-
-        // Transformation
-        Transforms temp = m_renderer->getTransformation();
-        temp.model = atmosphericRotation *
-                     glm::translate(newPos) *
-                     glm::rotate(angle, axis) *
-                     glm::scale(glm::vec3(1.0f + contrib)) *
-                     temp.model;
-
-        // Shader info
-        glm::vec3 color = contrib*m_starData[i].color;
-        glUniformMatrix4fv(glGetUniformLocation(m_shader, "mvp"), 1, GL_FALSE, &temp.getTransform()[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(m_shader, "m"), 1, GL_FALSE, &temp.model[0][0]);
-        glUniform4f(glGetUniformLocation(m_shader, "color"), color.x, color.y, color.z, alpha);
-
-        // Draw it!
-        m_particle.draw();
-    }
+    // Fade what's there into the other target
+    glBindFramebuffer(GL_FRAMEBUFFER, m_trailFBOs[next]);
+    glDisable(GL_BLEND);
+    glUseProgram(m_trailShader);
+    glActiveTexture(GL_TEXTURE0+m_trailTextureID);
+    glBindTexture(GL_TEXTURE_2D, m_trailTextures[m_currentTrail]);
+    glUniform1i(m_uniformTrailTex, m_trailTextureID);
+    glUniform1f(m_uniformTrailDecay, pow(TRAILDECAY, elapsed));
+    m_trailQuad.draw();
+
+    // Add this frame's shooting stars on top
+    glEnable(GL_BLEND);
+    glUseProgram(m_shader);
+    glUniform1f(m_uniformStreak, elapsed);
+    m_particle.drawInstanced(numShooting);
+
+    // Add the trails to everything else
+    glBindFramebuffer(GL_FRAMEBUFFER, m_FBO);
+    glUseProgram(m_trailShader);
+    glBindTexture(GL_TEXTURE_2D, m_trailTextures[next]);
+    glUniform1f(m_uniformTrailDecay, 1.0f);
+    m_trailQuad.draw();
+
+    // Clean up
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(m_shader);
+    m_currentTrail = next;
 }
 
 /**
- * @brief Calculates new position/life of star i
- * @param i The index into the particle data
+ * @brief Draws every static star once into the sky cubemap, seen from the center
+ * Stars are added at full life in half floats, with their twinkle phase
+ * kept by max blending in alpha, so the final pass can twinkle them with
+ * one lookup per pixel. Stars that overlap share the brighter phase.
  */
-void StarsRenderer::calculateData(int i) {
-    float globalSpeed = m_renderer->getSimulationSpeed();
-    m_starData[i].pos = m_starData[i].pos + globalSpeed*m_starData[i].dir;
-    m_starData[i].life += globalSpeed*m_starData[i].decay;
-
-    // If the life is below min or above max, reset position
-    if (m_starData[i].life <= 0 || m_starData[i].life >= MAXLIFE) {
-        m_starData[i].decay *= -1.0f;
-        if (isShootingStar(i) && m_starData[i].life <= 0) {
-            m_starData[i].pos.x = urand(-SPREAD, SPREAD);
-            m_starData[i].pos.y = urand(-SPREAD, SPREAD);
-            m_starData[i].pos.z = urand(-SPREAD, SPREAD);
+void StarsRenderer::bakeSky() {
+    // Cube faces in the order GL numbers them, looking out from the center
+    static const glm::vec3 faceDirs[6] = { glm::vec3(1,0,0), glm::vec3(-1,0,0), glm::vec3(0,1,0),
+                                           glm::vec3(0,-1,0), glm::vec3(0,0,1), glm::vec3(0,0,-1) };
+    static const glm::vec3 faceUps[6] = { glm::vec3(0,-1,0), glm::vec3(0,-1,0), glm::vec3(0,0,1),
+                                          glm::vec3(0,0,-1), glm::vec3(0,-1,0), glm::vec3(0,-1,0) };
+
+    if (m_skyFBO == 0) {
+        m_skyTextureID = settings.getAndIncrementTextureIndex();
+        glGenFramebuffers(1, &m_skyFBO);
+        glGenTextures(1, &m_skyTexture);
+        glActiveTexture(GL_TEXTURE0+m_skyTextureID);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, m_skyTexture);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        for (int face = 0; face < 6; face++) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA16F, SKYFACESIZE, SKYFACESIZE, 0,
+                         GL_RGBA, GL_FLOAT, NULL);
         }
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
     }
-}
 
-/**
- * @brief Creates a star from scratch
- * @param The index into the particleData array
- */
-void StarsRenderer::setupStar(int i) {
-    float x,y,z;
-    float radius = 0.0f;
-    while (radius < MINRADIUS) {
-        x = urand(-SPREAD, SPREAD);
-        y = urand(-SPREAD, SPREAD);
-        z = urand(-SPREAD, SPREAD);
-        radius = sqrt(pow(x,2.0f) + pow(y,2.0f) + pow(z,2.0f));
-    }
-    m_starData[i].life = urand(0, MAXLIFE);
-    m_starData[i].dir = glm::vec3(0);
-    m_starData[i].pos = glm::vec3(x,y,z);
-    m_starData[i].color = STARCOLOR;
-    m_starData[i].decay = -1;
-
-    // Shooting star
-    if (urand(0.0f,1.0f) > SHOOTINGTHRESHOLD) {
-        m_starData[i].color = SHOOTINGCOLOR;
-        m_starData[i].dir = glm::vec3(urand(-M_PI, M_PI),urand(-M_PI, M_PI),urand(-M_PI, M_PI));
+    // Everything the bake changes, to put back afterwards
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+
+    glUseProgram(m_shader);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_skyFBO);
+    glViewport(0, 0, SKYFACESIZE, SKYFACESIZE);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
+
+    glm::mat4x4 identity(1.0f);
+    glm::mat4x4 projection = glm::perspective((float)(M_PI/2.0), 1.0f, 1.0f, 2.0f*SPREAD);
+    glUniformMatrix4fv(m_uniformRotation, 1, GL_FALSE, &identity[0][0]);
+    glUniform1f(m_uniformAlpha, 0);
+    glUniform1f(m_uniformStreak, 0);
+    glUniform1i(m_uniformTwinkle, 1);
+    glUniform1f(m_uniformTwinkleTime, 0);
+    glUniform1i(m_uniformBake, 1);
+    for (int face = 0; face < 6; face++) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                               m_skyTexture, 0);
+        glClearColor(0,0,0,0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glm::mat4x4 vp = projection * glm::lookAt(glm::vec3(0), faceDirs[face], faceUps[face]);
+        glUniformMatrix4fv(m_uniformVP, 1, GL_FALSE, &vp[0][0]);
+        m_staticParticle.drawInstanced(m_numStatic);
     }
+    glUniform1i(m_uniformBake, 0);
+    glUniform1i(m_uniformTwinkle, 0);
 
-    // Twinkling (fading out/in)
-    else if (urand(0.0f,1.0f) > TWINKLINGTHRESHOLD)
-        m_starData[i].decay = 1;
+    // Clean up
+    glBlendEquation(GL_FUNC_ADD);
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    if (cullFace) glEnable(GL_CULL_FACE);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glUseProgram(0);
 }
 
 /**
- * @brief Returns the atmospheric rotation of the stars based on speed
- * @return The glm::mat4x4 representing the rotation for the current rotational speed
+ * @brief Binds the baked sky and sets everything the final pass needs to sample it
+ * Does nothing but turn the sky off unless static stars are baked.
+ * @param shader The final pass's program, already in use
  */
-glm::mat4x4 StarsRenderer::getAtmosphericRotation() {
-    return glm::rotate(m_renderer->getRotationalSpeed()/700.0f,
-                       glm::vec3(0,1,-0.75f));
+void StarsRenderer::bindSky(GLuint shader) {
+    glUniform1i(glGetUniformLocation(shader, "skyCubemap"), m_skyCubemap);
+    if (!m_skyCubemap) return;
+
+    Transforms trans = m_scene->getTransformation();
+    glm::mat4x4 inverseVP = glm::inverse(trans.projection * trans.view);
+    glm::mat3x3 inverseRotation = glm::transpose(glm::mat3(getAtmosphericRotation()));
+    glm::vec3 skyEye = inverseRotation * m_scene->getCamera().getData().eye;
+    float time = fmod(m_steps + m_scene->getInterpolationAlpha(), 2.0f*MAXLIFE);
+
+    glActiveTexture(GL_TEXTURE0+m_skyTextureID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_skyTexture);
+    glUniform1i(glGetUniformLocation(shader, "skyTex"), m_skyTextureID);
+    glUniformMatrix4fv(glGetUniformLocation(shader, "inverseVP"), 1, GL_FALSE, &inverseVP[0][0]);
+    glUniformMatrix3fv(glGetUniformLocation(shader, "inverseRotation"), 1, GL_FALSE, &inverseRotation[0][0]);
+    glUniform3fv(glGetUniformLocation(shader, "skyEye"), 1, &skyEye[0]);
+    glUniform1f(glGetUniformLocation(shader, "skyRadius"), SKYRADIUS);
+    glUniform1f(glGetUniformLocation(shader, "twinkleTime"), time);
+    glUniform1f(glGetUniformLocation(shader, "maxLife"), MAXLIFE);
 }
 
 /**
- * @brief Checks whether a given star is a shooting star
- * @param i The index of the star
- * @return If the direction is something other than static
+ * @brief Turns the sky's node to the atmospheric rotation for a speed
+ * Does nothing if the speed hasn't changed, so a paused sky isn't redone.
+ * @param speed The scene's rotational speed
  */
-bool StarsRenderer::isShootingStar(int i) {
-    return glm::length(m_starData[i].dir) > 0;
+void StarsRenderer::advance(float speed) {
+    if (speed == m_skySpeed) return;
+    m_scene->getSceneGraph()->setLocal(m_skyNode, glm::rotate(speed/SKYTURN, SKYAXIS));
+    m_skySpeed = speed;
 }
 
+/**
+ * @brief Returns the atmospheric rotation of the stars based on speed
+ * @return The glm::mat4x4 from the sky's node, as of the last scene graph update
+ */
+glm::mat4x4 StarsRenderer::getAtmosphericRotation() {
+    return m_scene->getSceneGraph()->getWorld(m_skyNode);
+}
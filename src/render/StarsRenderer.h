@@ -4,17 +4,22 @@
 #include "GLCommon.h"
 #include "Renderer.h"
 #include "Particle.h" // Must be included here
+#include "TexturedQuad.h"
+#include "StarSimulation.h"
+#include "StarField.h"
+#include "SkyGrid.h"
+#include "Scene.h"
 
-class ParticleData;
-class GLRenderWidget;
 
 /**
  * @brief Class to support rendering of arbitrary numbers of
- * stars, using particles to actually draw them
+ * stars, using instanced particles to actually draw them. Stars that
+ * never move live in one buffer on the GPU, sorted into sky tiles that
+ * are culled as a whole; only the few shooting stars are simulated.
  */
 class StarsRenderer : public Renderer {
 public:
-    StarsRenderer(GLRenderWidget *renderer);
+    StarsRenderer(Scene *scene);
     ~StarsRenderer();
 
     void createShaderProgram();
@@ -22,22 +27,73 @@ public:
     void render();
     void refresh();
 
+    // Advances all stars by one fixed simulation step, on the GPU if enabled
+    void step();
+
+    // Turns the sky's node to the current speed
+    void advance(float speed);
+
+    // Culling counters from the last frame
+    StarStats getStats();
+
+    // Sets the final pass's sky cubemap uniforms, if static stars are baked
+    void bindSky(GLuint shader);
+
     int getTextureID();
     GLuint *getColorAttach();
     GLuint *getFBO();
 
 private:
     void drawStars();
-    void drawBody(int i, float angle, glm::vec3 axis);
-    void drawTail(int i, float angle, glm::vec3 axis);
-    void calculateData(int i);
-    void setupStar(int i);
-    bool isShootingStar(int i);
+    void drawTrails(int numShooting, float time);
+    void deleteTrailTargets();
+    void bakeSky();
     glm::mat4x4 getAtmosphericRotation();
 
     // Objects
-    Particle m_particle;
-    ParticleData *m_starData;
+    Particle m_staticParticle; // Stars that never move, uploaded once per refresh
+    Particle m_particle; // Shooting stars, uploaded every frame on the CPU
+    int m_numStatic;
+    SkyGrid m_skyGrid; // Static stars are sorted by tile so whole tiles can be culled
+    std::vector<glm::ivec2> m_visibleRanges; // Runs of static stars in visible tiles
+    StarStats m_stats;
+    StarField m_starField; // Shooting stars stepped on the CPU
+    std::vector<GLfloat> m_instanceData; // Stars packed for the instance buffer
+    StarSimulation m_simulation; // Steps stars on the GPU instead of m_starField
+    bool m_gpuSimulation; // If m_simulation is in use
+
+    // Simulation state
+    unsigned int m_seed; // Seed for respawning shooting stars
+    unsigned int m_steps; // Steps since the last refresh
+    SceneHandle m_skyNode; // The atmospheric rotation, a root of its own
+    float m_skySpeed; // Speed m_skyNode was last turned to
+
+    // Trails for shooting stars, ping-ponged every frame
+    GLuint m_trailShader;
+    TexturedQuad m_trailQuad;
+    GLuint m_trailFBOs[2];
+    GLuint m_trailTextures[2];
+    int m_trailTextureID; // Texture unit trails are read from
+    int m_currentTrail; // Which target holds last frame's trails
+    float m_lastTrailTime; // Steps since refresh when trails were last drawn
+    GLint m_uniformTrailTex;
+    GLint m_uniformTrailDecay;
+
+    // Static stars drawn once per refresh into a cubemap, if settings.skyCubemap is set
+    bool m_skyCubemap;
+    GLuint m_skyFBO;
+    GLuint m_skyTexture;
+    int m_skyTextureID; // Texture unit the final pass reads the sky from
+
+    // Uniform locations, looked up once
+    GLint m_uniformVP;
+    GLint m_uniformRotation;
+    GLint m_uniformEye;
+    GLint m_uniformAlpha;
+    GLint m_uniformStreak;
+    GLint m_uniformTwinkle;
+    GLint m_uniformTwinkleTime;
+    GLint m_uniformBake;
 };
 
 #endif // STARSRENDERER_H
@@ -0,0 +1,330 @@
+#include "FlowerField.h"
+#include "Random.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include <math.h>
+#include <algorithm>
+
+#define STEMSCALE 0.08f // Length of a stem
+#define MINPETALS 5
+
+/**
+ * @brief Empties every array, keeping its storage
+ */
+void FlowerParts::clear() {
+    std::vector<float> *arrays[] = { &qx, &qy, &qz, &qw, &tx, &ty, &tz, &sx, &sy, &sz };
+    for (int a = 0; a < 10; a++) arrays[a]->clear();
+}
+
+/**
+ * @brief Makes room for count parts in every array
+ * @param count The number of parts
+ */
+void FlowerParts::reserve(int count) {
+    std::vector<float> *arrays[] = { &qx, &qy, &qz, &qw, &tx, &ty, &tz, &sx, &sy, &sz };
+    for (int a = 0; a < 10; a++) arrays[a]->reserve(count);
+}
+
+/**
+ * @brief Returns how many parts there are
+ * @return The length of every array
+ */
+int FlowerParts::size() const {
+    return qw.size();
+}
+
+/**
+ * @brief Adds a part to the end of every array
+ * @param rotation The part's rotation
+ * @param translation Where it's moved after rotating
+ * @param scale Its size along its own axes, before rotating
+ */
+void FlowerParts::push(const glm::quat &rotation, const glm::vec3 &translation, const glm::vec3 &scale) {
+    qx.push_back(rotation.x);
+    qy.push_back(rotation.y);
+    qz.push_back(rotation.z);
+    qw.push_back(rotation.w);
+    tx.push_back(translation.x);
+    ty.push_back(translation.y);
+    tz.push_back(translation.z);
+    sx.push_back(scale.x);
+    sy.push_back(scale.y);
+    sz.push_back(scale.z);
+}
+
+/**
+ * @brief Returns one part's rotation
+ * @param i The part's index
+ * @return The rotation as a quaternion
+ */
+glm::quat FlowerParts::getRotation(int i) const {
+    return glm::quat(qw[i], qx[i], qy[i], qz[i]);
+}
+
+/**
+ * @brief Returns one part's translation
+ * @param i The part's index
+ * @return Where the part is moved after rotating
+ */
+glm::vec3 FlowerParts::getTranslation(int i) const {
+    return glm::vec3(tx[i], ty[i], tz[i]);
+}
+
+/**
+ * @brief Builds one part's model matrix: translate * rotate * scale
+ * @param i The part's index
+ * @return The part's model as a glm::mat4
+ */
+glm::mat4 FlowerParts::getModel(int i) const {
+    glm::mat4 model = glm::mat4_cast(getRotation(i));
+    model[0] *= sx[i];
+    model[1] *= sy[i];
+    model[2] *= sz[i];
+    model[3] = glm::vec4(tx[i], ty[i], tz[i], 1.0f);
+    return model;
+}
+
+/**
+ * @brief Starts out with no flowers
+ */
+FlowerField::FlowerField() {
+    m_petalBegins.push_back(0);
+}
+
+/**
+ * @brief Drops every flower - O(1), since parts and colors are plain floats
+ */
+void FlowerField::clear() {
+    m_stems.clear();
+    m_centers.clear();
+    m_petals.clear();
+    m_petalBegins.resize(1);
+    m_clusterBegins.clear();
+    m_centerColors.clear();
+    m_petalColors.clear();
+}
+
+/**
+ * @brief Makes room up front, so filling the field doesn't reallocate
+ * @param flowers The number of flowers
+ * @param petals The number of petals over all of them
+ */
+void FlowerField::reserve(int flowers, int petals) {
+    m_stems.reserve(flowers);
+    m_centers.reserve(flowers);
+    m_petals.reserve(petals);
+    m_petalBegins.reserve(flowers + 1);
+    m_clusterBegins.reserve(flowers);
+    m_centerColors.reserve(flowers*3);
+    m_petalColors.reserve(flowers*3);
+}
+
+/**
+ * @brief Adds a random flower, not depending on any other
+ * Standing straight out of the moon at up, spun some way around it, with a
+ * stem, a center at its top, and 5 to 8 petals spread around the center.
+ * Starts a new cluster. Its looks come from random at index, so the same
+ * index always gives the same flower.
+ * @param up Where it stands, as a direction out of the moon's center
+ * @param random The stream its looks come from
+ * @param index Which of the stream's numbers to use
+ * @return The new flower's index
+ */
+int FlowerField::addTemplate(const glm::vec3 &up, const Philox &random, int index) {
+    m_clusterBegins.push_back(getFlowerCount());
+    float u[8];
+    random.uniform(index, 0, u);
+    random.uniform(index, 1, u + 4);
+
+    // Straight up is +y before turning
+    glm::quat turn = glm::rotation(glm::vec3(0.0f, 1.0f, 0.0f), glm::normalize(up)) *
+                     glm::angleAxis(2.0f * (float)M_PI * u[0], glm::vec3(0.0f, 1.0f, 0.0f));
+
+    glm::vec3 center;
+    center.r = 1.0f;
+    center.g = 0.5f + u[1] / 2.f;
+    center.b = 0.0f;
+    int petals = std::min(FLOWER_MAX_PETALS, MINPETALS + (int)(u[2] * (FLOWER_MAX_PETALS - MINPETALS + 1)));
+    glm::vec3 petal(u[3], u[4], u[5]);
+
+    // Stem halfway up, center at the top, petals radially around the center
+    glm::vec3 top = turn * glm::vec3(0.0f, FLOWER_GROUND + STEMSCALE, 0.0f);
+    m_stems.push(turn, turn * glm::vec3(0.0f, FLOWER_GROUND + STEMSCALE/2.0f, 0.0f),
+                 glm::vec3(STEMSCALE/30.f, STEMSCALE, STEMSCALE/30.f));
+    m_centers.push(turn, top, glm::vec3(STEMSCALE/15.f));
+    for (int j = 0; j < petals; j++) {
+        glm::quat spread = glm::angleAxis(2.0f * (float)M_PI / petals * j, glm::vec3(0.0f, 1.0f, 0.0f));
+        m_petals.push(turn * spread, top, glm::vec3(0.02f / ((float)petals), 0.003f, 0.03f));
+    }
+    m_petalBegins.push_back(m_petals.size());
+    addColors(center, petal);
+    return getFlowerCount() - 1;
+}
+
+/**
+ * @brief Adds a flower copying another, turned over the moon to stand somewhere else
+ * This is the way gardens are made to look alike.
+ * @param around The flower it should copy
+ * @param up Where it stands, as a direction out of the moon's center
+ * @return The new flower's index
+ */
+int FlowerField::addNeighbour(int around, const glm::vec3 &up) {
+    glm::quat turn = glm::rotation(glm::normalize(m_stems.getTranslation(around)), glm::normalize(up));
+
+    // Turning the whole flower turns each part and where it's moved to
+    m_stems.push(turn * m_stems.getRotation(around), turn * m_stems.getTranslation(around),
+                 glm::vec3(m_stems.sx[around], m_stems.sy[around], m_stems.sz[around]));
+    m_centers.push(turn * m_centers.getRotation(around), turn * m_centers.getTranslation(around),
+                   glm::vec3(m_centers.sx[around], m_centers.sy[around], m_centers.sz[around]));
+    for (int j = getPetalBegin(around); j < getPetalEnd(around); j++) {
+        m_petals.push(turn * m_petals.getRotation(j), turn * m_petals.getTranslation(j),
+                      glm::vec3(m_petals.sx[j], m_petals.sy[j], m_petals.sz[j]));
+    }
+    m_petalBegins.push_back(m_petals.size());
+    addColors(getCenterColor(around), getPetalColor(around));
+    return getFlowerCount() - 1;
+}
+
+/**
+ * @brief Adds the newest flower's colors
+ * @param center Its center's color
+ * @param petal Every one of its petals' color
+ */
+void FlowerField::addColors(const glm::vec3 &center, const glm::vec3 &petal) {
+    m_centerColors.push_back(center.r);
+    m_centerColors.push_back(center.g);
+    m_centerColors.push_back(center.b);
+    m_petalColors.push_back(petal.r);
+    m_petalColors.push_back(petal.g);
+    m_petalColors.push_back(petal.b);
+}
+
+/**
+ * @brief Returns how many flowers there are
+ * @return The number of stems, which is the number of flowers
+ */
+int FlowerField::getFlowerCount() const {
+    return m_stems.size();
+}
+
+/**
+ * @brief Returns how many petals there are over every flower
+ * @return The size of the petal arena
+ */
+int FlowerField::getPetalCount() const {
+    return m_petals.size();
+}
+
+/**
+ * @brief Returns a flower's first petal in the petal arena
+ * @param flower The flower's index
+ * @return The index of its first petal
+ */
+int FlowerField::getPetalBegin(int flower) const {
+    return m_petalBegins[flower];
+}
+
+/**
+ * @brief Returns one past a flower's last petal in the petal arena
+ * @param flower The flower's index
+ * @return The index after its last petal
+ */
+int FlowerField::getPetalEnd(int flower) const {
+    return m_petalBegins[flower + 1];
+}
+
+/**
+ * @brief Returns how many clusters there are, one per template
+ * @return The number of templates
+ */
+int FlowerField::getClusterCount() const {
+    return m_clusterBegins.size();
+}
+
+/**
+ * @brief Returns a cluster's first flower, its template
+ * @param cluster The cluster's index
+ * @return The template's flower index
+ */
+int FlowerField::getClusterBegin(int cluster) const {
+    return m_clusterBegins[cluster];
+}
+
+/**
+ * @brief Returns one past a cluster's last flower
+ * @param cluster The cluster's index
+ * @return The next template's flower index, or the flower count for the last cluster
+ */
+int FlowerField::getClusterEnd(int cluster) const {
+    return cluster + 1 < (int)m_clusterBegins.size() ? m_clusterBegins[cluster + 1] : getFlowerCount();
+}
+
+/**
+ * @brief Returns a flower's stem model, in the moon's space
+ * @param flower The flower's index
+ * @return The model as a glm::mat4
+ */
+glm::mat4 FlowerField::getStemModel(int flower) const {
+    return m_stems.getModel(flower);
+}
+
+/**
+ * @brief Returns a flower's center model, in the moon's space
+ * @param flower The flower's index
+ * @return The model as a glm::mat4
+ */
+glm::mat4 FlowerField::getCenterModel(int flower) const {
+    return m_centers.getModel(flower);
+}
+
+/**
+ * @brief Returns a petal's model, in the moon's space
+ * @param petal The petal's index in the petal arena
+ * @return The model as a glm::mat4
+ */
+glm::mat4 FlowerField::getPetalModel(int petal) const {
+    return m_petals.getModel(petal);
+}
+
+/**
+ * @brief Returns a flower's center color
+ * @param flower The flower's index
+ * @return The color as RGB
+ */
+glm::vec3 FlowerField::getCenterColor(int flower) const {
+    return glm::vec3(m_centerColors[flower*3], m_centerColors[flower*3 + 1], m_centerColors[flower*3 + 2]);
+}
+
+/**
+ * @brief Returns the color of every one of a flower's petals
+ * @param flower The flower's index
+ * @return The color as RGB
+ */
+glm::vec3 FlowerField::getPetalColor(int flower) const {
+    return glm::vec3(m_petalColors[flower*3], m_petalColors[flower*3 + 1], m_petalColors[flower*3 + 2]);
+}
+
+/**
+ * @brief Returns every stem, in flower order
+ * @return The stem arena
+ */
+const FlowerParts &FlowerField::getStems() const {
+    return m_stems;
+}
+
+/**
+ * @brief Returns every center, in flower order
+ * @return The center arena
+ */
+const FlowerParts &FlowerField::getCenters() const {
+    return m_centers;
+}
+
+/**
+ * @brief Returns every petal, each flower's in a run
+ * @return The petal arena
+ */
+const FlowerParts &FlowerField::getPetals() const {
+    return m_petals;
+}
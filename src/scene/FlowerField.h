@@ -0,0 +1,90 @@
+#ifndef FLOWERFIELD_H
+#define FLOWERFIELD_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+#define STEMCOLOR glm::vec3(0, 0.5, 0)
+#define FLOWER_MAX_PETALS 8 // Most petals one flower has
+#define FLOWER_GROUND 0.65f // Where stems start, from the moon's center
+
+class Philox;
+
+/**
+ * @brief Structure of arrays store of one kind of flower part
+ * Each part is a rotation, a translation, and a scale along its own axes,
+ * 10 floats instead of a mat4's 16, each in its own array. Clearing keeps
+ * every array's storage, so refilling doesn't allocate.
+ */
+struct FlowerParts {
+    void clear();
+    void reserve(int count);
+    int size() const;
+
+    void push(const glm::quat &rotation, const glm::vec3 &translation, const glm::vec3 &scale);
+    glm::quat getRotation(int i) const;
+    glm::vec3 getTranslation(int i) const;
+    glm::mat4 getModel(int i) const;
+
+    std::vector<float> qx, qy, qz, qw; // Rotation
+    std::vector<float> tx, ty, tz; // Translation, applied after rotating
+    std::vector<float> sx, sy, sz; // Scale, applied before rotating
+};
+
+/**
+ * @brief Every flower on the moon, in contiguous arenas
+ * Stems and centers are one per flower, in flower order. Petals live in
+ * one arena of their own, each flower's in a run starting at its petal
+ * begin, so walking flowers in order walks every array front to back.
+ * Templates are random flowers standing at a given spot; neighbours copy
+ * a template turned over to their own spot, so gardens look alike. Each
+ * template starts a cluster, and its neighbours follow it in the same run. Nothing is allocated per
+ * flower, and clearing is O(1) and keeps the memory for the next garden.
+ */
+class FlowerField {
+public:
+    FlowerField();
+
+    // Drops every flower, keeping storage
+    void clear();
+    void reserve(int flowers, int petals);
+
+    // A new random flower, or one like around, standing at up - giving back its index
+    int addTemplate(const glm::vec3 &up, const Philox &random, int index);
+    int addNeighbour(int around, const glm::vec3 &up);
+
+    int getFlowerCount() const;
+    int getPetalCount() const;
+    int getPetalBegin(int flower) const;
+    int getPetalEnd(int flower) const;
+
+    // A template and the neighbours added after it, as a run of flowers
+    int getClusterCount() const;
+    int getClusterBegin(int cluster) const;
+    int getClusterEnd(int cluster) const;
+
+    // Moon-local models and colors
+    glm::mat4 getStemModel(int flower) const;
+    glm::mat4 getCenterModel(int flower) const;
+    glm::mat4 getPetalModel(int petal) const;
+    glm::vec3 getCenterColor(int flower) const;
+    glm::vec3 getPetalColor(int flower) const;
+
+    const FlowerParts &getStems() const;
+    const FlowerParts &getCenters() const;
+    const FlowerParts &getPetals() const;
+
+private:
+    void addColors(const glm::vec3 &center, const glm::vec3 &petal);
+
+    FlowerParts m_stems;
+    FlowerParts m_centers;
+    FlowerParts m_petals;
+    std::vector<int> m_petalBegins; // Each flower's first petal, then one past the last
+    std::vector<int> m_clusterBegins; // Each cluster's template
+    std::vector<float> m_centerColors; // RGB per flower
+    std::vector<float> m_petalColors;
+};
+
+#endif // FLOWERFIELD_H
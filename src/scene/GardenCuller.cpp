@@ -0,0 +1,235 @@
+#include "GardenCuller.h"
+#include "FlowerField.h"
+#include "Parallel.h"
+
+#include <math.h>
+#include <algorithm>
+
+#define PARTREACH 0.71f // Farthest a unit cylinder or sphere reaches from its center, times its scale
+#define CULL_OUTSIDE 0
+#define CULL_PARTIAL 1
+#define CULL_INSIDE 2
+
+/**
+ * @brief Reaches as far as a part's longest axis lets it
+ * @param parts The arena the part is in
+ * @param i The part's index
+ * @param center Where the flower's bounds are centered
+ * @return How far from center any of the part might be
+ */
+static float partReach(const FlowerParts &parts, int i, glm::vec3 center) {
+    float scale = std::max(parts.sx[i], std::max(parts.sy[i], parts.sz[i]));
+    return glm::length(parts.getTranslation(i) - center) + PARTREACH*scale;
+}
+
+/**
+ * @brief Starts out with nothing to cull
+ */
+GardenCuller::GardenCuller()
+    : m_ground(0), m_clustersDrawn(0), m_flowersDrawn(0), m_partsDrawn(0) {}
+
+/**
+ * @brief Bounds every flower with a sphere, then every cluster with a cone and a sphere
+ * @param field Every flower, in the moon's space
+ * @param ground Radius of the moon under the flowers - nothing is seen through it
+ */
+void GardenCuller::build(const FlowerField &field, float ground) {
+    int flowers = field.getFlowerCount();
+    int clusters = field.getClusterCount();
+    m_ground = ground;
+
+    m_clusterBegins.resize(clusters + 1);
+    for (int c = 0; c < clusters; c++) m_clusterBegins[c] = field.getClusterBegin(c);
+    m_clusterBegins[clusters] = flowers;
+    m_partBegins.resize(flowers + 1);
+    for (int i = 0; i <= flowers; i++) m_partBegins[i] = 2*i + field.getPetalBegin(i); // Stem, center, petals
+
+    // A sphere around each flower, centered halfway up its stem
+    m_flowerSpheres.resize(flowers);
+    parallelFor(flowers, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            glm::vec3 center = field.getStems().getTranslation(i);
+            float radius = std::max(partReach(field.getStems(), i, center), partReach(field.getCenters(), i, center));
+            for (int j = field.getPetalBegin(i); j < field.getPetalEnd(i); j++) {
+                radius = std::max(radius, partReach(field.getPetals(), j, center));
+            }
+            m_flowerSpheres[i] = glm::vec4(center, radius);
+        }
+    });
+
+    // A cone out of the moon's center through every flower sphere, and a sphere around them
+    m_clusterAxes.resize(clusters);
+    m_clusterAngles.resize(clusters);
+    m_clusterRadii.resize(clusters);
+    m_clusterSpheres.resize(clusters);
+    parallelFor(clusters, [&](int begin, int end) {
+        for (int c = begin; c < end; c++) {
+            glm::vec3 axis(0), mean(0);
+            for (int i = m_clusterBegins[c]; i < m_clusterBegins[c + 1]; i++) {
+                axis += glm::normalize(glm::vec3(m_flowerSpheres[i]));
+                mean += glm::vec3(m_flowerSpheres[i]);
+            }
+            axis = glm::length(axis) > 0 ? glm::normalize(axis) : glm::vec3(0, 1, 0);
+            mean /= (float)std::max(1, m_clusterBegins[c + 1] - m_clusterBegins[c]);
+
+            float angle = 0, inner = INFINITY, outer = 0, radius = 0;
+            for (int i = m_clusterBegins[c]; i < m_clusterBegins[c + 1]; i++) {
+                glm::vec3 center(m_flowerSpheres[i]);
+                float r = m_flowerSpheres[i].w, distance = glm::length(center);
+                float spread = r < distance ? asin(r / distance) : M_PI;
+                angle = std::max(angle, acos(glm::clamp(glm::dot(axis, center / distance), -1.0f, 1.0f)) + spread);
+                inner = std::min(inner, distance - r);
+                outer = std::max(outer, distance + r);
+                radius = std::max(radius, glm::length(center - mean) + r);
+            }
+            m_clusterAxes[c] = axis;
+            m_clusterAngles[c] = std::min(angle, (float)M_PI);
+            m_clusterRadii[c] = glm::vec2(std::max(0.0f, inner), outer);
+            m_clusterSpheres[c] = glm::vec4(mean, radius);
+        }
+    });
+}
+
+/**
+ * @brief Culls every cluster against the moon's horizon and the view frustum, then flowers on the edges
+ * @param clip Takes moon-local positions to clip space (projection * view * orbit)
+ * @param eye The eye position in the moon's space
+ * @param runs Filled in with (first flower, count) for each run of visible flowers
+ * @return The total number of flowers in all runs
+ */
+int GardenCuller::cull(const glm::mat4 &clip, glm::vec3 eye, std::vector<glm::ivec2> *runs) {
+    // Frustum planes straight out of the matrix, pointing inwards, scaled to moon-local distances
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; r++) rows[r] = glm::vec4(clip[0][r], clip[1][r], clip[2][r], clip[3][r]);
+    glm::vec4 planes[6] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+                            rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2] };
+    for (int p = 0; p < 6; p++) planes[p] /= glm::length(glm::vec3(planes[p]));
+
+    float distance = glm::length(eye);
+    glm::vec3 eyeDir = distance > 0 ? eye / distance : glm::vec3(0);
+
+    runs->clear();
+    m_clustersDrawn = 0;
+    m_flowersDrawn = 0;
+    m_partsDrawn = 0;
+    int clusters = getClusterCount();
+    for (int c = 0; c < clusters; c++) {
+        int horizon = classifyHorizon(m_clusterAxes[c], m_clusterAngles[c], m_clusterRadii[c], eyeDir, distance);
+        if (horizon == CULL_OUTSIDE) continue;
+        int frustum = classify(m_clusterSpheres[c], planes);
+        if (frustum == CULL_OUTSIDE) continue;
+
+        int drawn = m_flowersDrawn;
+        if (horizon == CULL_INSIDE && frustum == CULL_INSIDE) {
+            addRun(m_clusterBegins[c], m_clusterBegins[c + 1], runs);
+        } else {
+            // On an edge, so each flower is tested on its own
+            for (int i = m_clusterBegins[c]; i < m_clusterBegins[c + 1]; i++) {
+                glm::vec3 center(m_flowerSpheres[i]);
+                float r = m_flowerSpheres[i].w, length = glm::length(center);
+                if (r < length) {
+                    glm::vec2 radii(length - r, length + r);
+                    if (classifyHorizon(center / length, asin(r / length), radii, eyeDir, distance) == CULL_OUTSIDE) continue;
+                }
+                if (classify(m_flowerSpheres[i], planes) == CULL_OUTSIDE) continue;
+                addRun(i, i + 1, runs);
+            }
+        }
+        if (m_flowersDrawn > drawn) m_clustersDrawn++;
+    }
+    return m_flowersDrawn;
+}
+
+/**
+ * @brief Returns how many clusters the last build bounded
+ * @return One per template in the field
+ */
+int GardenCuller::getClusterCount() {
+    return m_clusterAxes.size();
+}
+
+/**
+ * @brief Returns how many clusters kept any flower in the last cull
+ * @return m_clustersDrawn
+ */
+int GardenCuller::getClustersDrawn() {
+    return m_clustersDrawn;
+}
+
+/**
+ * @brief Returns how many flowers survived the last cull
+ * @return m_flowersDrawn
+ */
+int GardenCuller::getFlowersDrawn() {
+    return m_flowersDrawn;
+}
+
+/**
+ * @brief Returns how many stems, centers, and petals the last cull kept
+ * @return m_partsDrawn
+ */
+int GardenCuller::getPartsDrawn() {
+    return m_partsDrawn;
+}
+
+/**
+ * @brief Returns how many stems, centers, and petals the last cull dropped
+ * @return Every part, less the ones drawn
+ */
+int GardenCuller::getPartsCulled() {
+    return (m_partBegins.empty() ? 0 : m_partBegins.back()) - m_partsDrawn;
+}
+
+/**
+ * @brief Tests a sphere against the six frustum planes
+ * @param sphere Center and radius, in the moon's space
+ * @param planes The frustum planes, normalized and pointing inwards
+ * @return CULL_OUTSIDE if it's all outside one plane, CULL_INSIDE if it's inside every one
+ */
+int GardenCuller::classify(const glm::vec4 &sphere, const glm::vec4 *planes) {
+    int result = CULL_INSIDE;
+    for (int p = 0; p < 6; p++) {
+        float distance = glm::dot(glm::vec3(planes[p]), glm::vec3(sphere)) + planes[p].w;
+        if (distance < -sphere.w) return CULL_OUTSIDE;
+        if (distance < sphere.w) result = CULL_PARTIAL;
+    }
+    return result;
+}
+
+/**
+ * @brief Tests a cone of directions, between two radii, against the moon's horizon
+ * A point at radius r can be seen over the ground as long as it's less
+ * than acos(ground/eye distance) + acos(ground/r) around from the eye, so
+ * the cone is hidden when even its nearest edge is past that at its
+ * highest radius, and all seen when its farthest edge is within it at
+ * its lowest radius.
+ * @param axis The cone's axis, normalized
+ * @param angle The cone's half angle
+ * @param radii Lowest and highest radius of anything in it
+ * @param eye The eye direction in the moon's space, normalized
+ * @param distance How far the eye is from the moon's center
+ * @return CULL_OUTSIDE if all of it is hidden, CULL_INSIDE if none of it is
+ */
+int GardenCuller::classifyHorizon(glm::vec3 axis, float angle, glm::vec2 radii, glm::vec3 eye, float distance) {
+    if (distance <= m_ground) return CULL_INSIDE;
+    float around = acos(glm::clamp(glm::dot(axis, eye), -1.0f, 1.0f));
+    float horizon = acos(m_ground / distance);
+    float lowest = radii.x > m_ground ? acos(m_ground / radii.x) : 0.0f;
+    float highest = radii.y > m_ground ? acos(m_ground / radii.y) : 0.0f;
+    if (around - angle > horizon + highest) return CULL_OUTSIDE;
+    if (around + angle <= horizon + lowest) return CULL_INSIDE;
+    return CULL_PARTIAL;
+}
+
+/**
+ * @brief Adds flowers to the last run if they follow straight on from it, counting them
+ * @param first The first flower
+ * @param end One past the last flower
+ * @param runs The runs so far
+ */
+void GardenCuller::addRun(int first, int end, std::vector<glm::ivec2> *runs) {
+    if (!runs->empty() && runs->back().x + runs->back().y == first) runs->back().y += end - first;
+    else runs->push_back(glm::ivec2(first, end - first));
+    m_flowersDrawn += end - first;
+    m_partsDrawn += m_partBegins[end] - m_partBegins[first];
+}
@@ -0,0 +1,55 @@
+#ifndef GARDENCULLER_H
+#define GARDENCULLER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+class FlowerField;
+
+/**
+ * @brief Culls flowers on the moon a cluster at a time, then a flower at a time
+ * Every cluster (a template and its neighbours) is bounded by a cone out
+ * of the moon's center, cut between the lowest and highest radius of any
+ * of its parts, and by a sphere. Each frame, a cluster behind the moon's
+ * horizon or outside the frustum is dropped whole. A cluster entirely in
+ * view is kept whole, and only clusters on an edge test their flowers'
+ * bounding spheres one by one. Everything works in the moon's own space,
+ * so nothing is rebuilt as the moon orbits. Flowers are kept in field
+ * order, so neighbouring survivors are merged into one run.
+ */
+class GardenCuller {
+public:
+    GardenCuller();
+
+    // Bounds every cluster and flower in the field
+    void build(const FlowerField &field, float ground);
+
+    // Gives back runs of flowers (first, count) that might be seen
+    int cull(const glm::mat4 &clip, glm::vec3 eye, std::vector<glm::ivec2> *runs);
+
+    int getClusterCount();
+    int getClustersDrawn();
+    int getFlowersDrawn();
+    int getPartsDrawn();
+    int getPartsCulled();
+
+private:
+    int classify(const glm::vec4 &sphere, const glm::vec4 *planes);
+    int classifyHorizon(glm::vec3 axis, float angle, glm::vec2 radii, glm::vec3 eye, float distance);
+    void addRun(int first, int end, std::vector<glm::ivec2> *runs);
+
+    float m_ground; // Radius of the moon that hides flowers behind it
+    std::vector<int> m_clusterBegins; // First flower of each cluster, then one past the last
+    std::vector<int> m_partBegins; // First part of each flower, then one past the last
+    std::vector<glm::vec3> m_clusterAxes; // Each cluster's cone axis, out of the moon's center
+    std::vector<float> m_clusterAngles; // Each cone's half angle
+    std::vector<glm::vec2> m_clusterRadii; // Lowest and highest radius of any part in each cluster
+    std::vector<glm::vec4> m_clusterSpheres; // Center and radius around each cluster
+    std::vector<glm::vec4> m_flowerSpheres; // Center and radius around each flower
+
+    int m_clustersDrawn; // Clusters with any flower that survived the last cull
+    int m_flowersDrawn;
+    int m_partsDrawn;
+};
+
+#endif // GARDENCULLER_H
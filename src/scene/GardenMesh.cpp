@@ -0,0 +1,190 @@
+#include "GardenMesh.h"
+#include "FlowerField.h"
+#include "Shape.h"
+#include "Parallel.h"
+
+#include <map>
+
+/**
+ * @brief Starts out with nothing baked
+ */
+GardenMesh::GardenMesh()
+    : m_vao(0), m_buffer(0), m_indices(0), m_count(0), m_indexCount(0),
+      m_stemIndexCount(0), m_sphereIndexCount(0), m_modelLocation(-1) {}
+
+/**
+ * @brief Deletes the buffers and VAO
+ */
+GardenMesh::~GardenMesh() {
+    deleteGL();
+}
+
+/**
+ * @brief Merges every flower in the field into one moon-local mesh
+ * Every flower takes the same vertices and indices for its stem and center,
+ * plus the same again per petal, so each flower's start comes straight from
+ * its first petal and flowers fill their own ranges in parallel.
+ * @param shader The flower shader, reading position, instanceColor, and model
+ * @param field Every flower, in the moon's space
+ * @param stem The shape drawn for stems
+ * @param sphere The shape drawn for centers and petals
+ * @param stemColor The color of every stem
+ */
+void GardenMesh::bake(GLuint shader, const FlowerField &field, Shape *stem, Shape *sphere, glm::vec3 stemColor) {
+    deleteGL();
+
+    std::vector<GLfloat> stemPositions, spherePositions;
+    std::vector<GLuint> stemIndices, sphereIndices;
+    weld(stem, &stemPositions, &stemIndices);
+    weld(sphere, &spherePositions, &sphereIndices);
+    int stemVertices = stemPositions.size() / 3, sphereVertices = spherePositions.size() / 3;
+    int stemIndexCount = stemIndices.size(), sphereIndexCount = sphereIndices.size();
+    m_stemIndexCount = stemIndexCount;
+    m_sphereIndexCount = sphereIndexCount;
+
+    // Where every flower starts, from how many parts came before it
+    int flowers = field.getFlowerCount();
+    int parts = field.getPetalCount();
+    m_count = flowers*(stemVertices + sphereVertices) + parts*sphereVertices;
+    m_indexCount = flowers*(stemIndexCount + sphereIndexCount) + parts*sphereIndexCount;
+    std::vector<GLfloat> vertices(m_count*GARDEN_VERTEX_FLOATS);
+    std::vector<GLuint> indices(m_indexCount);
+
+    parallelFor(flowers, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            int petalBegin = field.getPetalBegin(i);
+            int vertex = i*(stemVertices + sphereVertices) + petalBegin*sphereVertices;
+            int index = i*(stemIndexCount + sphereIndexCount) + petalBegin*sphereIndexCount;
+
+            // Stem, center, then each petal, one after another
+            for (int part = -2; part < field.getPetalEnd(i) - petalBegin; part++) {
+                bool isStem = part == -2;
+                const std::vector<GLfloat> &positions = isStem ? stemPositions : spherePositions;
+                const std::vector<GLuint> &triangles = isStem ? stemIndices : sphereIndices;
+                glm::mat4 model = isStem ? field.getStemModel(i) : part == -1 ? field.getCenterModel(i) :
+                                                                   field.getPetalModel(petalBegin + part);
+                glm::vec3 color = isStem ? stemColor : part == -1 ? field.getCenterColor(i) : field.getPetalColor(i);
+
+                for (size_t t = 0; t < triangles.size(); t++) indices[index++] = vertex + triangles[t];
+                for (size_t v = 0; v < positions.size(); v += 3) {
+                    glm::vec4 p = model * glm::vec4(positions[v], positions[v + 1], positions[v + 2], 1.0f);
+                    GLfloat *out = &vertices[vertex++ * GARDEN_VERTEX_FLOATS];
+                    out[0] = p.x;
+                    out[1] = p.y;
+                    out[2] = p.z;
+                    out[3] = color.r;
+                    out[4] = color.g;
+                    out[5] = color.b;
+                }
+            }
+        }
+    });
+    if (m_count == 0) return;
+
+    // One buffer for vertices and one for triangles, which the VAO keeps bound
+    GLint position = glGetAttribLocation(shader, "position");
+    GLint color = glGetAttribLocation(shader, "instanceColor");
+    m_modelLocation = glGetAttribLocation(shader, "model");
+    GLsizei stride = GARDEN_VERTEX_FLOATS*sizeof(GLfloat);
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
+    glEnableVertexAttribArray(position);
+    glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(color);
+    glVertexAttribPointer(color, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3*sizeof(GLfloat)));
+    glGenBuffers(1, &m_indices);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indices);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+
+    // Clean up
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * @brief Draws runs of flowers in one call
+ * Each run's indices start where its first flower's do, worked out the
+ * same way as in bake. The model attribute isn't in the VAO, so it's set
+ * to the identity as a constant first - everything is already in the
+ * moon's space.
+ * @param field The field the mesh was last baked from
+ * @param runs (first flower, count) for each run to draw
+ */
+void GardenMesh::draw(const FlowerField &field, const std::vector<glm::ivec2> &runs) {
+    if (m_vao == 0 || runs.empty()) return;
+    int perFlower = m_stemIndexCount + m_sphereIndexCount;
+    m_runCounts.resize(runs.size());
+    m_runOffsets.resize(runs.size());
+    for (size_t r = 0; r < runs.size(); r++) {
+        int first = runs[r].x, end = runs[r].x + runs[r].y;
+        int begin = first*perFlower + field.getPetalBegin(first)*m_sphereIndexCount;
+        m_runCounts[r] = end*perFlower + field.getPetalBegin(end)*m_sphereIndexCount - begin;
+        m_runOffsets[r] = (const GLvoid *)(begin*sizeof(GLuint));
+    }
+
+    for (int i = 0; m_modelLocation >= 0 && i < 4; i++) {
+        glVertexAttrib4f(m_modelLocation + i, i == 0, i == 1, i == 2, i == 3);
+    }
+    glBindVertexArray(m_vao);
+    glMultiDrawElements(GL_TRIANGLES, &m_runCounts[0], GL_UNSIGNED_INT, &m_runOffsets[0], runs.size());
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Returns how many vertices were baked
+ * @return m_count
+ */
+int GardenMesh::getVertexCount() {
+    return m_count;
+}
+
+/**
+ * @brief Returns how many indices were baked, three per triangle
+ * @return m_indexCount
+ */
+int GardenMesh::getIndexCount() {
+    return m_indexCount;
+}
+
+/**
+ * @brief Merges a shape's vertices that share a position, ignoring normals
+ * @param shape The shape to weld
+ * @param positions Replaced with xyz per distinct vertex
+ * @param indices Replaced with the shape's triangles, indexing positions
+ */
+void GardenMesh::weld(Shape *shape, std::vector<GLfloat> *positions, std::vector<GLuint> *indices) {
+    std::vector<GLuint> triangles;
+    shape->getTriangles(&triangles);
+    const GLfloat *data = shape->getVertexData();
+
+    std::map<std::pair<std::pair<float, float>, float>, GLuint> welded;
+    positions->clear();
+    indices->clear();
+    for (size_t t = 0; t < triangles.size(); t++) {
+        const GLfloat *v = data + 6*triangles[t];
+        std::pair<std::pair<float, float>, float> key(std::make_pair(v[0], v[1]), v[2]);
+        std::map<std::pair<std::pair<float, float>, float>, GLuint>::iterator found = welded.find(key);
+        if (found == welded.end()) {
+            found = welded.insert(std::make_pair(key, (GLuint)(positions->size() / 3))).first;
+            positions->insert(positions->end(), v, v + 3);
+        }
+        indices->push_back(found->second);
+    }
+}
+
+/**
+ * @brief Deletes the buffers and VAO, if they exist
+ */
+void GardenMesh::deleteGL() {
+    if (m_vao != 0) glDeleteVertexArrays(1, &m_vao);
+    if (m_buffer != 0) glDeleteBuffers(1, &m_buffer);
+    if (m_indices != 0) glDeleteBuffers(1, &m_indices);
+    m_vao = 0;
+    m_buffer = 0;
+    m_indices = 0;
+    m_count = 0;
+    m_indexCount = 0;
+}
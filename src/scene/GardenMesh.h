@@ -0,0 +1,59 @@
+#ifndef GARDENMESH_H
+#define GARDENMESH_H
+
+#include "GLCommon.h"
+#include <vector>
+
+// Floats per baked vertex: moon-local position, then color
+#define GARDEN_VERTEX_FLOATS 6
+
+class FlowerField;
+class Shape;
+
+/**
+ * @brief Every flower on the moon merged into one static mesh
+ * Flowers never move on the moon, so every stem, center, and petal is
+ * transformed into the moon's space once per bake, with its color on
+ * every vertex, and the whole garden draws with one call and the moon's
+ * orbit. Each shape is welded into shared vertices and triangles first,
+ * so parts only keep the vertices they need. Flowers are baked in field
+ * order, each a stem, then a center, then its petals, so where any
+ * flower starts is known up front and flowers are baked on every core.
+ * Each flower's triangles are one range of indices, so the runs of
+ * flowers that survive culling draw with one multi-draw call. It draws
+ * with the instanced flower shader, its model attribute set to a constant
+ * identity.
+ */
+class GardenMesh {
+public:
+    GardenMesh();
+    ~GardenMesh();
+
+    // Replaces the mesh with the field's flowers - needs a current GL context
+    void bake(GLuint shader, const FlowerField &field, Shape *stem, Shape *sphere, glm::vec3 stemColor);
+    // Draws runs of flowers (first, count) from the field it was baked from
+    void draw(const FlowerField &field, const std::vector<glm::ivec2> &runs);
+
+    int getVertexCount();
+    int getIndexCount();
+
+private:
+    GardenMesh(const GardenMesh &);
+    GardenMesh &operator=(const GardenMesh &);
+
+    static void weld(Shape *shape, std::vector<GLfloat> *positions, std::vector<GLuint> *indices);
+    void deleteGL();
+
+    GLuint m_vao;
+    GLuint m_buffer; // GARDEN_VERTEX_FLOATS floats per vertex
+    GLuint m_indices;
+    int m_count; // Number of vertices
+    int m_indexCount;
+    int m_stemIndexCount; // Indices per stem, then per center or petal
+    int m_sphereIndexCount;
+    std::vector<GLsizei> m_runCounts; // Indices in each run, scratch for draw
+    std::vector<const GLvoid *> m_runOffsets; // Byte offset of each run, scratch for draw
+    GLint m_modelLocation; // First of the model attribute's four locations, set as a constant
+};
+
+#endif // GARDENMESH_H
@@ -0,0 +1,435 @@
+#include "GardenSampler.h"
+#include "Parallel.h"
+#include "Random.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+
+#define NUMFACES 6
+#define NUMEDGES 12
+#define CENTER_STREAM 0x67617264 // Random streams for garden centers and their flowers
+#define MEMBER_STREAM 0x666c7772
+#define COVERAGE 0.35f // Fraction of the sphere (or a garden) covered by disks half a spacing across
+#define MAXDARTS 32 // Darts thrown per point wanted before giving up
+#define MAXRADIUS 0.25f // Largest angle a garden spreads out from its center
+#define EDGEFRACTION 2.351f // 12 edges * (their 70.5 degree arc / 360 degrees), times sin of the half width gives the strips' share of the sphere
+
+/**
+ * @brief Buckets points on the unit sphere by the cube cell they're in, hashed into a fixed table
+ * Cells are as wide as the chord two points have to be apart, so only a
+ * point's own cell and the 26 around it need checking.
+ */
+class PointHash {
+public:
+    /**
+     * @brief Sets up an empty table
+     * @param chord The straight line distance points have to be apart
+     * @param expected Roughly how many points will be added
+     */
+    PointHash(float chord, int expected) : m_cell(std::max(chord, 1e-6f)), m_chord(chord) {
+        int size = 1;
+        while (size < 2*expected) size *= 2;
+        m_heads.assign(size, -1);
+        m_next.reserve(expected);
+    }
+
+    /**
+     * @brief Adds a point
+     * @param points Where every point is, including this one, at its index
+     * @param index The point's index, one more than the last one added
+     */
+    void insert(const std::vector<glm::vec3> &points, int index) {
+        int bucket = bucketOf(cellOf(points[index]));
+        m_next.push_back(m_heads[bucket]);
+        m_heads[bucket] = index;
+    }
+
+    /**
+     * @brief Tests a point against every point near it
+     * @param p The point to test
+     * @param points Where every point added is
+     * @return If nothing added is closer than the chord
+     */
+    bool isClear(const glm::vec3 &p, const std::vector<glm::vec3> &points) const {
+        glm::ivec3 cell = cellOf(p);
+        float chord2 = m_chord * m_chord;
+        for (int x = -1; x <= 1; x++) for (int y = -1; y <= 1; y++) for (int z = -1; z <= 1; z++) {
+            for (int i = m_heads[bucketOf(cell + glm::ivec3(x, y, z))]; i >= 0; i = m_next[i]) {
+                glm::vec3 d = points[i] - p;
+                if (glm::dot(d, d) < chord2) return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Finds the nearest other point added, if any is within the chord
+     * @param points Where every point added is
+     * @param index The point to search around
+     * @return The smallest straight line distance, or the chord if none is closer
+     */
+    float nearest(const std::vector<glm::vec3> &points, int index) const {
+        glm::ivec3 cell = cellOf(points[index]);
+        float best = m_chord * m_chord;
+        for (int x = -1; x <= 1; x++) for (int y = -1; y <= 1; y++) for (int z = -1; z <= 1; z++) {
+            for (int i = m_heads[bucketOf(cell + glm::ivec3(x, y, z))]; i >= 0; i = m_next[i]) {
+                if (i == index) continue;
+                glm::vec3 d = points[i] - points[index];
+                best = std::min(best, glm::dot(d, d));
+            }
+        }
+        return sqrt(best);
+    }
+
+private:
+    glm::ivec3 cellOf(const glm::vec3 &p) const {
+        return glm::ivec3(glm::floor((p + 1.0f) / m_cell));
+    }
+
+    int bucketOf(const glm::ivec3 &cell) const {
+        uint32_t h = (uint32_t)cell.x * 73856093u ^ (uint32_t)cell.y * 19349663u ^ (uint32_t)cell.z * 83492791u;
+        return h & (m_heads.size() - 1);
+    }
+
+    float m_cell;
+    float m_chord;
+    std::vector<int> m_heads; // First point in each bucket, -1 for none
+    std::vector<int> m_next; // Next point in the same bucket, by index
+};
+
+/**
+ * @brief Turns an angle between two directions into the straight line distance between them
+ * @param angle The angle, in radians
+ * @return The chord across the unit sphere
+ */
+static float chordOf(float angle) {
+    return 2.0f * sin(std::min(angle, (float)M_PI) / 2.0f);
+}
+
+/**
+ * @brief Makes a uniformly random direction
+ * @param u Two floats in [0,1)
+ * @return A unit vector
+ */
+static glm::vec3 uniformDirection(const float *u) {
+    float z = 2.0f*u[0] - 1.0f;
+    float angle = 2.0f*M_PI*u[1];
+    float r = sqrt(std::max(0.0f, 1.0f - z*z));
+    return glm::vec3(r*cos(angle), r*sin(angle), z);
+}
+
+/**
+ * @brief Finds the axis a direction is furthest along, and the next furthest
+ * @param p Any direction
+ * @param major Set to the axis of the cube face p is on
+ * @param minor Set to the axis of the face across p's nearest edge
+ */
+static void axesOf(const glm::vec3 &p, int *major, int *minor) {
+    glm::vec3 a = glm::abs(p);
+    *major = a.x >= a.y && a.x >= a.z ? 0 : a.y >= a.z ? 1 : 2;
+    int j = (*major + 1) % 3, k = (*major + 2) % 3;
+    *minor = a[j] >= a[k] ? j : k;
+}
+
+/**
+ * @brief Moves a direction onto a cube face, keeping it uniformly random
+ * Turning the cube onto itself never changes how directions are spread,
+ * so the axes are cycled until p's face lands on the one wanted.
+ * @param p Any direction
+ * @param face The face wanted, 2*axis, plus 1 for the negative side
+ * @return p turned onto face
+ */
+static glm::vec3 ontoFace(const glm::vec3 &p, int face) {
+    int major, minor;
+    axesOf(p, &major, &minor);
+    int axis = face / 2;
+    glm::vec3 q;
+    for (int c = 0; c < 3; c++) q[(axis + c) % 3] = p[(major + c) % 3];
+    q[axis] = face % 2 == 0 ? fabs(q[axis]) : -fabs(q[axis]);
+    return q;
+}
+
+/**
+ * @brief Tests if a direction is within an angle of its cube face's edge
+ * The edge with the next face over is the great circle where both axes
+ * are equal, so the sine of the angle to it is their difference over root 2.
+ * @param p A unit direction
+ * @param gap Root 2 times the sine of the angle
+ * @return If it's closer to the edge than that
+ */
+static bool nearEdge(const glm::vec3 &p, float gap) {
+    int major, minor;
+    axesOf(p, &major, &minor);
+    return fabs(p[major]) - fabs(p[minor]) < gap;
+}
+
+/**
+ * @brief Starts out with nothing placed
+ */
+GardenSampler::GardenSampler() : m_gardenSpacing(0), m_gardenRadius(0), m_flowerSpacing(0) {
+    m_gardenBegins.push_back(0);
+}
+
+/**
+ * @brief Places every garden's center, then every garden's flowers
+ * Spacings come from how many there are: centers cover COVERAGE of the
+ * sphere with disks half a spacing across, and flowers cover the same
+ * share of their garden. Gardens stay far enough apart that flowers in
+ * neighbouring gardens are still a flower spacing apart. If darts run out
+ * first, there are fewer gardens or flowers than asked for.
+ * @param seed Picks the random streams - the same seed always places the same flowers
+ * @param gardens How many gardens
+ * @param members Flowers per garden, counting the one at its center
+ * @param threads How many threads to use, 0 for every core - never changes the result
+ * @return How many flowers were placed
+ */
+int GardenSampler::sample(unsigned int seed, int gardens, int members, int threads) {
+    gardens = std::max(0, gardens);
+    members = std::max(1, members);
+    m_gardenSpacing = 4.0f * sqrt(COVERAGE / std::max(1, gardens));
+    m_gardenRadius = std::min(MAXRADIUS, m_gardenSpacing / (2.0f * (1.0f + sqrt(COVERAGE / members))));
+    m_flowerSpacing = 2.0f * m_gardenRadius * sqrt(COVERAGE / members);
+
+    // Strips along the edges get their share of gardens, the rest split between faces
+    float margin = m_gardenSpacing / 2.0f;
+    int seams = std::min(gardens, (int)(gardens * std::min(1.0f, EDGEFRACTION * sin(std::min(margin, (float)M_PI_2))) + 0.5f));
+    int faceGardens = gardens - seams;
+    int faceThreads = gardens * members >= PARALLEL_MIN_ITEMS ? threads : 1;
+    parallelFor(NUMFACES, [&](int begin, int end) {
+        for (int f = begin; f < end; f++) {
+            throwCenters(f, seed, faceGardens / NUMFACES + (f < faceGardens % NUMFACES), &m_faceCenters[f]);
+        }
+    }, faceThreads, 1);
+
+    m_centers.clear();
+    for (int f = 0; f < NUMFACES; f++) m_centers.insert(m_centers.end(), m_faceCenters[f].begin(), m_faceCenters[f].end());
+    throwSeams(seed, gardens - m_centers.size());
+
+    // Each garden's flowers into its own slots, then packed down in garden order
+    int placedGardens = m_centers.size();
+    m_slots.resize(placedGardens * members);
+    m_placed.resize(placedGardens);
+    parallelFor(placedGardens, [&](int begin, int end) {
+        for (int g = begin; g < end; g++) m_placed[g] = throwMembers(g, seed, members, &m_slots[g * members]);
+    }, threads, std::max(1, PARALLEL_MIN_ITEMS / members));
+
+    m_directions.clear();
+    m_directions.reserve(m_slots.size());
+    m_gardenBegins.resize(1);
+    m_gardenBegins.reserve(placedGardens + 1);
+    for (int g = 0; g < placedGardens; g++) {
+        m_directions.insert(m_directions.end(), m_slots.begin() + g * members, m_slots.begin() + g * members + m_placed[g]);
+        m_gardenBegins.push_back(m_directions.size());
+    }
+    return m_directions.size();
+}
+
+/**
+ * @brief Throws darts at one cube face until it has its gardens or runs out
+ * Darts within half a garden spacing of the face's edges are thrown away,
+ * so no center here is ever too close to one on another face.
+ * @param face Which face, 2*axis, plus 1 for the negative side
+ * @param seed Picks the random stream
+ * @param quota How many centers the face should get
+ * @param centers Replaced with the face's centers, in the order they were placed
+ */
+void GardenSampler::throwCenters(int face, unsigned int seed, int quota, std::vector<glm::vec3> *centers) const {
+    Philox random(seed, CENTER_STREAM);
+    float gap = sqrt(2.0f) * sin(std::min(m_gardenSpacing / 2.0f, (float)M_PI_2));
+    PointHash grid(chordOf(m_gardenSpacing), quota);
+    centers->clear();
+    for (int dart = 0; (int)centers->size() < quota && dart < quota * MAXDARTS; dart++) {
+        float u[4];
+        random.uniform(face, dart, u);
+        glm::vec3 p = ontoFace(uniformDirection(u), face);
+        if (nearEdge(p, gap) || !grid.isClear(p, *centers)) continue;
+        centers->push_back(p);
+        grid.insert(*centers, centers->size() - 1);
+    }
+}
+
+/**
+ * @brief Throws darts along the cube's edges, against every center so far, until there are enough
+ * Each dart is spread evenly over a strip around one edge's great circle,
+ * and only kept if that edge is the nearest one to it on its own face,
+ * so strips that overlap near corners aren't filled twice as densely.
+ * @param seed Picks the random stream
+ * @param quota How many more centers are wanted
+ */
+void GardenSampler::throwSeams(unsigned int seed, int quota) {
+    if (quota <= 0) return;
+    Philox random(seed, CENTER_STREAM);
+    float margin = std::min(m_gardenSpacing / 2.0f, (float)M_PI_2);
+    float gap = sqrt(2.0f) * sin(margin);
+    int target = m_centers.size() + quota;
+    PointHash grid(chordOf(m_gardenSpacing), target);
+    for (size_t i = 0; i < m_centers.size(); i++) grid.insert(m_centers, i);
+
+    int tries = 0;
+    for (int dart = 0; (int)m_centers.size() < target && tries < quota * MAXDARTS && dart < quota * MAXDARTS * NUMEDGES; dart++) {
+        float u[4];
+        random.uniform(NUMFACES, dart, u);
+
+        // Which edge: a pair of axes and a side of each
+        int edge = std::min(NUMEDGES - 1, (int)(u[0] * NUMEDGES));
+        int i = edge / 4 == 2 ? 1 : 0, j = edge / 4 == 0 ? 1 : 2, k = 3 - i - j;
+        float si = edge & 1 ? -1.0f : 1.0f, sj = edge & 2 ? -1.0f : 1.0f;
+        glm::vec3 along(0), across(0), normal(0);
+        along[i] = si / sqrt(2.0f);
+        along[j] = sj / sqrt(2.0f);
+        normal[i] = si / sqrt(2.0f);
+        normal[j] = -sj / sqrt(2.0f);
+        across[k] = 1.0f;
+
+        // Around the great circle, and evenly out to the margin either side of it
+        float angle = 2.0f*M_PI*u[1];
+        float side = (2.0f*u[2] - 1.0f) * sin(margin);
+        glm::vec3 p = sqrt(1.0f - side*side) * (cos(angle)*along + sin(angle)*across) + side*normal;
+
+        int major, minor;
+        axesOf(p, &major, &minor);
+        bool onEdge = (major == i && minor == j) || (major == j && minor == i);
+        if (!onEdge || p[i]*si < 0 || p[j]*sj < 0 || fabs(p[major]) - fabs(p[minor]) >= gap) continue;
+        tries++;
+        if (!grid.isClear(p, m_centers)) continue;
+        m_centers.push_back(p);
+        grid.insert(m_centers, m_centers.size() - 1);
+    }
+}
+
+/**
+ * @brief Throws darts into a disk around a garden's center until it has its flowers or runs out
+ * The first flower is at the center. Darts are even over the disk seen
+ * straight down on the center, which is within a few percent of even
+ * over the sphere that close in, and needs no trig. Each random draw is
+ * two darts. The garden is small enough that checking every flower so
+ * far beats a grid.
+ * @param garden Which garden, picking its random numbers
+ * @param seed Picks the random stream
+ * @param members How many flowers it should get
+ * @param out Room for members directions
+ * @return How many flowers were placed
+ */
+int GardenSampler::throwMembers(int garden, unsigned int seed, int members, glm::vec3 *out) const {
+    Philox random(seed, MEMBER_STREAM);
+    glm::vec3 center = m_centers[garden];
+    glm::vec3 helper = fabs(center.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+    glm::vec3 e1 = glm::normalize(glm::cross(center, helper));
+    glm::vec3 e2 = glm::cross(center, e1);
+    float reach = sin(m_gardenRadius);
+    float chord = chordOf(m_flowerSpacing);
+
+    int placed = 0;
+    out[placed++] = center;
+    for (int dart = 0; placed < members && dart < members * MAXDARTS; dart += 2) {
+        float u[4];
+        random.uniform(garden, dart / 2, u);
+        for (int d = 0; d < 4 && placed < members; d += 2) {
+            float x = 2.0f*u[d] - 1.0f, y = 2.0f*u[d + 1] - 1.0f;
+            if (x*x + y*y >= 1.0f) continue;
+            x *= reach;
+            y *= reach;
+            glm::vec3 p = x*e1 + y*e2 + sqrt(1.0f - x*x - y*y)*center;
+            bool clear = true;
+            for (int i = 0; i < placed && clear; i++) {
+                glm::vec3 between = p - out[i];
+                clear = glm::dot(between, between) >= chord*chord;
+            }
+            if (clear) out[placed++] = p;
+        }
+    }
+    return placed;
+}
+
+/**
+ * @brief Returns how many gardens were placed
+ * @return The number of garden centers
+ */
+int GardenSampler::getGardenCount() const {
+    return m_gardenBegins.size() - 1;
+}
+
+/**
+ * @brief Returns a garden's first flower, the one at its center
+ * @param garden The garden's index
+ * @return The center's flower index
+ */
+int GardenSampler::getGardenBegin(int garden) const {
+    return m_gardenBegins[garden];
+}
+
+/**
+ * @brief Returns one past a garden's last flower
+ * @param garden The garden's index
+ * @return The next garden's first flower
+ */
+int GardenSampler::getGardenEnd(int garden) const {
+    return m_gardenBegins[garden + 1];
+}
+
+/**
+ * @brief Returns how many flowers were placed over every garden
+ * @return The number of directions
+ */
+int GardenSampler::getFlowerCount() const {
+    return m_directions.size();
+}
+
+/**
+ * @brief Returns where a flower is
+ * @param flower The flower's index
+ * @return Its direction out of the sphere's center, normalized
+ */
+const glm::vec3 &GardenSampler::getDirection(int flower) const {
+    return m_directions[flower];
+}
+
+/**
+ * @brief Returns the smallest angle between garden centers, from the last sample
+ * @return m_gardenSpacing
+ */
+float GardenSampler::getGardenSpacing() const {
+    return m_gardenSpacing;
+}
+
+/**
+ * @brief Returns the largest angle from a garden's center to its flowers, from the last sample
+ * @return m_gardenRadius
+ */
+float GardenSampler::getGardenRadius() const {
+    return m_gardenRadius;
+}
+
+/**
+ * @brief Returns the smallest angle between flowers, from the last sample
+ * @return m_flowerSpacing
+ */
+float GardenSampler::getFlowerSpacing() const {
+    return m_flowerSpacing;
+}
+
+/**
+ * @brief Finds the smallest angle between any two flowers from the last sample
+ * @return The angle between the closest pair, in radians, at most twice the flower spacing
+ */
+float GardenSampler::findClosest() const {
+    return findClosest(m_directions, 2.0f * m_flowerSpacing);
+}
+
+/**
+ * @brief Finds the smallest angle between any two directions, through a grid of them all
+ * Anything further apart than within isn't looked at, so that's the most
+ * it gives back.
+ * @param directions Unit directions
+ * @param within The largest angle worth looking for
+ * @return The angle between the closest pair, in radians
+ */
+float GardenSampler::findClosest(const std::vector<glm::vec3> &directions, float within) {
+    int count = directions.size();
+    PointHash grid(chordOf(within), count);
+    for (int i = 0; i < count; i++) grid.insert(directions, i);
+    float closest = chordOf(within);
+    for (int i = 0; i < count; i++) closest = std::min(closest, grid.nearest(directions, i));
+    return 2.0f * asin(std::min(1.0f, closest / 2.0f));
+}
@@ -0,0 +1,58 @@
+#ifndef GARDENSAMPLER_H
+#define GARDENSAMPLER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Poisson-disk placement of gardens, and the flowers in each, on a sphere
+ * Garden centers are kept a garden spacing apart, and every flower a
+ * flower spacing apart from every other, so nothing overlaps or clumps
+ * by chance. Centers are dart thrown on each of the six cube faces on its
+ * own thread, each face with its own spatial hash grid, keeping half a
+ * spacing back from the face's edges so faces never have to agree. One
+ * pass afterwards fills the strips along the edges against every face.
+ * Each garden's flowers are then thrown into a disk around its center,
+ * gardens on every core. Every dart comes from a counter based random
+ * stream, so a seed always gives the same flowers on any number of threads.
+ */
+class GardenSampler {
+public:
+    GardenSampler();
+
+    // Places gardens of members flowers each, giving back how many flowers fit
+    int sample(unsigned int seed, int gardens, int members, int threads = 0);
+
+    // Flowers are directions out of the sphere's center, garden by garden, each garden's center first
+    int getGardenCount() const;
+    int getGardenBegin(int garden) const;
+    int getGardenEnd(int garden) const;
+    int getFlowerCount() const;
+    const glm::vec3 &getDirection(int flower) const;
+
+    // Angles, on the unit sphere
+    float getGardenSpacing() const;
+    float getGardenRadius() const;
+    float getFlowerSpacing() const;
+
+    // Smallest angle between any two flowers, or any two directions up to within, for checking spacing
+    float findClosest() const;
+    static float findClosest(const std::vector<glm::vec3> &directions, float within);
+
+private:
+    void throwCenters(int face, unsigned int seed, int quota, std::vector<glm::vec3> *centers) const;
+    void throwSeams(unsigned int seed, int quota);
+    int throwMembers(int garden, unsigned int seed, int members, glm::vec3 *out) const;
+
+    float m_gardenSpacing; // Smallest angle between garden centers
+    float m_gardenRadius; // Largest angle from a garden's center to its flowers
+    float m_flowerSpacing; // Smallest angle between flowers
+    std::vector<glm::vec3> m_faceCenters[6]; // Garden centers each face placed, scratch
+    std::vector<glm::vec3> m_centers; // Garden centers, face by face, then along the edges
+    std::vector<glm::vec3> m_slots; // members directions per garden, scratch
+    std::vector<int> m_placed; // Flowers that fit in each garden, scratch
+    std::vector<glm::vec3> m_directions; // Every flower
+    std::vector<int> m_gardenBegins; // Each garden's first flower, then one past the last
+};
+
+#endif // GARDENSAMPLER_H
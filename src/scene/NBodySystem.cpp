@@ -0,0 +1,529 @@
+#include "NBodySystem.h"
+#include "GLMath.h"
+#include "Parallel.h"
+#include "SIMD.h"
+
+#include <algorithm>
+
+#define NBODY_THETA 0.6f // Nodes smaller than this times their distance are lumped together
+#define NBODY_LEAF_SIZE 16 // Most bodies a leaf holds, unless they share a cell at the deepest level
+#define NBODY_GROUP_SIZE 64 // Most bodies sharing one walk of the tree, unless they're all in one leaf
+#define NBODY_LEVELS 21 // Levels of the tree, 3 bits each of a 64 bit Morton key
+#define NBODY_SOFTENING 0.5f // Added to every distance, so close passes don't fling bodies out
+#define NBODY_ETA 0.1f // Fraction of the softening's free fall time each step is
+#define NBODY_MAX_STEP 0.5f // Longest step, even when nothing pulls hard
+#define NBODY_MAX_SUBSTEPS 8 // Most steps one advance takes before falling behind
+
+#ifdef SIMD_WIDTH
+#define NBODY_PADDING SIMD_WIDTH
+#else
+#define NBODY_PADDING 1
+#endif
+
+/**
+ * @brief Spreads the low 21 bits of v out to every third bit
+ * @param v A cell coordinate
+ * @return The coordinate ready to interleave into a Morton key
+ */
+static inline uint64_t spreadBits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+/**
+ * @brief Starts out with no bodies
+ */
+NBodySystem::NBodySystem()
+    : m_count(0), m_gm(0), m_time(0), m_offset(0), m_started(false), m_dt(NBODY_MAX_STEP), m_rootSize(0), m_latest(0) {
+    m_min[0] = m_min[1] = m_min[2] = 0;
+}
+
+/**
+ * @brief Places every body and starts it on a circular orbit around the origin
+ * The mass at the origin is picked from the median body, so its closed form
+ * year stays about the same. Orbits go the way the closed form ones do, and
+ * bodies at the origin start still.
+ * @param bodies Every planet and belt body, in the renderer's order
+ */
+void NBodySystem::reset(const QList<PlanetData> &bodies) {
+    m_count = bodies.size();
+    m_time = 0;
+    m_offset = 0;
+    m_started = false;
+    m_stats = NBodyStats();
+
+    // G times the central mass, from r^3 / year^2 for each body going around it
+    std::vector<float> kepler;
+    for (int i = 0; i < m_count; i++) {
+        const PlanetData &data = bodies.at(i);
+        float radius = glm::length(data.position);
+        if (radius > 0 && data.year != 0) kepler.push_back(radius * radius * radius / (data.year * data.year));
+    }
+    m_gm = 1.0f;
+    if (!kepler.empty()) {
+        std::nth_element(kepler.begin(), kepler.begin() + kepler.size() / 2, kepler.end());
+        m_gm = kepler[kepler.size() / 2];
+    }
+
+    int padded = m_count + NBODY_PADDING;
+    std::vector<float> *arrays[] = { &m_px, &m_py, &m_pz, &m_vx, &m_vy, &m_vz, &m_ax, &m_ay, &m_az, &m_mass };
+    for (int a = 0; a < 10; a++) arrays[a]->assign(padded, 0.0f);
+    m_ids.resize(m_count);
+    for (int i = 0; i < m_count; i++) {
+        const PlanetData &data = bodies.at(i);
+        glm::vec3 p = data.position;
+        m_px[i] = p.x;
+        m_py[i] = p.y;
+        m_pz[i] = p.z;
+        m_mass[i] = data.mass * m_gm;
+        m_ids[i] = i;
+
+        // The closed form orbit turns positions toward (z, 0, -x)
+        float around = sqrt(p.x*p.x + p.z*p.z);
+        if (around > 0) {
+            float speed = sqrt(m_gm / glm::length(p)) * (data.year < 0 ? -1.0f : 1.0f);
+            m_vx[i] = p.z / around * speed;
+            m_vz[i] = -p.x / around * speed;
+        }
+    }
+
+    computeForces(0);
+    recordEphemeris(0);
+    m_ephemeris[1 - m_latest] = m_ephemeris[m_latest];
+}
+
+/**
+ * @brief Steps until the latest step is at or past time, so it can be drawn
+ * The first call only sets where time 0 is. Each step is as long as the
+ * last force pass allows, so faster multipliers take more of them. Past
+ * NBODY_MAX_SUBSTEPS the rest is dropped and the system falls behind,
+ * like SimulationClock does, so slow frames can't snowball.
+ * @param time The renderer's rotational speed
+ * @param threads How many threads to use, 0 for parallelThreadCount()
+ */
+void NBodySystem::advanceTo(float time, int threads) {
+    m_stats.substeps = 0;
+    m_stats.dropped = 0;
+    if (m_count == 0) return;
+    if (!m_started) {
+        m_offset = time;
+        m_started = true;
+    }
+
+    float target = time - m_offset;
+    while (m_time < target && m_stats.substeps < NBODY_MAX_SUBSTEPS) {
+        step(m_dt, threads);
+        m_stats.substeps++;
+    }
+    if (m_time < target) {
+        m_stats.dropped = target - m_time;
+        m_offset += m_stats.dropped;
+    }
+}
+
+/**
+ * @brief Takes one kick-drift-kick leapfrog step and adds it to the ephemeris
+ * @param dt How long the step is
+ * @param threads How many threads to use, 0 for parallelThreadCount()
+ */
+void NBodySystem::step(float dt, int threads) {
+    float half = dt * 0.5f;
+    parallelFor(m_count, [=](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            m_vx[i] += m_ax[i] * half;
+            m_vy[i] += m_ay[i] * half;
+            m_vz[i] += m_az[i] * half;
+            m_px[i] += m_vx[i] * dt;
+            m_py[i] += m_vy[i] * dt;
+            m_pz[i] += m_vz[i] * dt;
+        }
+    }, threads);
+
+    computeForces(threads);
+    parallelFor(m_count, [=](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            m_vx[i] += m_ax[i] * half;
+            m_vy[i] += m_ay[i] * half;
+            m_vz[i] += m_az[i] * half;
+        }
+    }, threads);
+
+    m_time += dt;
+    recordEphemeris(threads);
+}
+
+/**
+ * @brief Interpolates every body between the two latest steps
+ * Cubic Hermite on positions and velocities, so bodies don't jerk when a
+ * step lands between frames. Times outside the two steps are clamped.
+ * @param time The renderer's rotational speed
+ * @param out Room for the body count times stride floats
+ * @param stride Floats from one body's x to the next one's
+ * @param threads How many threads to use, 0 for parallelThreadCount()
+ */
+void NBodySystem::positionsAt(float time, float *out, int stride, int threads) const {
+    const NBodyEphemeris &before = m_ephemeris[1 - m_latest];
+    const NBodyEphemeris &after = m_ephemeris[m_latest];
+    float h = after.time - before.time;
+    float s = h > 0 ? glm::clamp((time - m_offset - before.time) / h, 0.0f, 1.0f) : 1.0f;
+    float s2 = s*s, s3 = s2*s;
+    float h00 = 2*s3 - 3*s2 + 1, h10 = (s3 - 2*s2 + s) * h, h01 = -2*s3 + 3*s2, h11 = (s3 - s2) * h;
+
+    parallelFor(m_count, [=, &before, &after](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            for (int c = 0; c < 3; c++) {
+                out[i*stride + c] = h00 * before.position[i*3 + c] + h10 * before.velocity[i*3 + c] +
+                                    h01 * after.position[i*3 + c] + h11 * after.velocity[i*3 + c];
+            }
+        }
+    }, threads);
+}
+
+/**
+ * @brief Returns the number of bodies
+ * @return m_count
+ */
+int NBodySystem::getBodyCount() const {
+    return m_count;
+}
+
+/**
+ * @brief Returns the time of the latest step, from when the clock started
+ * @return m_time
+ */
+float NBodySystem::getTime() const {
+    return m_time;
+}
+
+/**
+ * @brief Returns how long the next step will be
+ * @return m_dt
+ */
+float NBodySystem::getStableStep() const {
+    return m_dt;
+}
+
+/**
+ * @brief Returns what the last advance and force pass did
+ * @return m_stats
+ */
+NBodyStats NBodySystem::getStats() const {
+    return m_stats;
+}
+
+/**
+ * @brief Sums kinetic and potential energy directly, over every pair
+ * Leapfrog keeps this close to constant, so it drifting shows steps that
+ * are too long or forces that are wrong. Only for small systems.
+ * @return The total energy, with G folded into the masses
+ */
+double NBodySystem::energy() const {
+    double total = 0;
+    for (int i = 0; i < m_count; i++) {
+        double v2 = (double)m_vx[i]*m_vx[i] + (double)m_vy[i]*m_vy[i] + (double)m_vz[i]*m_vz[i];
+        double r2 = (double)m_px[i]*m_px[i] + (double)m_py[i]*m_py[i] + (double)m_pz[i]*m_pz[i];
+        total += m_mass[i] * (0.5 * v2 - m_gm / sqrt(r2 + NBODY_SOFTENING*NBODY_SOFTENING));
+        for (int j = i + 1; j < m_count; j++) {
+            double dx = m_px[j] - m_px[i], dy = m_py[j] - m_py[i], dz = m_pz[j] - m_pz[i];
+            total -= m_mass[i] * m_mass[j] / sqrt(dx*dx + dy*dy + dz*dz + NBODY_SOFTENING*NBODY_SOFTENING);
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Compares the tree's accelerations against summing every body directly
+ * @param samples How many bodies to check, spread evenly through the tree
+ * @return The RMS of each sample's error over its exact acceleration
+ */
+double NBodySystem::forceError(int samples) const {
+    if (m_count == 0 || samples <= 0) return 0;
+    double squared = 0;
+    float eps2 = NBODY_SOFTENING * NBODY_SOFTENING;
+    for (int s = 0; s < samples; s++) {
+        int i = (int)((long long)s * m_count / samples);
+        double r2 = (double)m_px[i]*m_px[i] + (double)m_py[i]*m_py[i] + (double)m_pz[i]*m_pz[i] + eps2;
+        double central = -m_gm / (r2 * sqrt(r2));
+        double a[3] = { central * m_px[i], central * m_py[i], central * m_pz[i] };
+        for (int j = 0; j < m_count; j++) {
+            double dx = m_px[j] - m_px[i], dy = m_py[j] - m_py[i], dz = m_pz[j] - m_pz[i];
+            double d2 = dx*dx + dy*dy + dz*dz + eps2;
+            double pull = m_mass[j] / (d2 * sqrt(d2));
+            a[0] += dx * pull;
+            a[1] += dy * pull;
+            a[2] += dz * pull;
+        }
+        double ex = m_ax[i] - a[0], ey = m_ay[i] - a[1], ez = m_az[i] - a[2];
+        double exact = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+        if (exact > 0) squared += (ex*ex + ey*ey + ez*ez) / exact;
+    }
+    return sqrt(squared / samples);
+}
+
+/**
+ * @brief Sorts the bodies, builds the tree, and works out every acceleration
+ * Also picks the next step from the largest acceleration, so nothing falls
+ * more than a fraction of the softening length in one.
+ * @param threads How many threads to use, 0 for parallelThreadCount()
+ */
+void NBodySystem::computeForces(int threads) {
+    if (m_count == 0) return;
+    sortBodies(threads);
+
+    m_nodes.clear();
+    m_groups.clear();
+    m_groupBegins.clear();
+    buildNode(0, m_count, 0, false);
+    int groups = m_groups.size();
+    m_groupAccel.assign(groups, 0.0f);
+    m_groupInteractions.assign(groups, 0);
+
+    // Each thread takes the groups that start in its range of bodies
+    parallelFor(m_count, [this](int begin, int end) {
+        std::vector<float> list;
+        int g = std::lower_bound(m_groupBegins.begin(), m_groupBegins.end(), begin) - m_groupBegins.begin();
+        for (; g < (int)m_groupBegins.size() && m_groupBegins[g] < end; g++) forceGroup(g, &list);
+    }, threads);
+
+    float accel = 0;
+    double interactions = 0;
+    for (int g = 0; g < groups; g++) {
+        accel = std::max(accel, m_groupAccel[g]);
+        interactions += m_groupInteractions[g];
+    }
+    accel = sqrt(accel);
+    m_dt = accel > 0 ? std::min(NBODY_MAX_STEP, NBODY_ETA * sqrt(NBODY_SOFTENING / accel)) : NBODY_MAX_STEP;
+    m_stats.nodes = m_nodes.size();
+    m_stats.groups = groups;
+    m_stats.interactions = interactions / m_count;
+}
+
+/**
+ * @brief Puts every body in Morton order inside a cube around all of them
+ * Bodies barely move between steps, so they're nearly sorted already.
+ * @param threads How many threads to use, 0 for parallelThreadCount()
+ */
+void NBodySystem::sortBodies(int threads) {
+    float lo[3] = { m_px[0], m_py[0], m_pz[0] }, hi[3] = { m_px[0], m_py[0], m_pz[0] };
+    for (int i = 1; i < m_count; i++) {
+        lo[0] = std::min(lo[0], m_px[i]); hi[0] = std::max(hi[0], m_px[i]);
+        lo[1] = std::min(lo[1], m_py[i]); hi[1] = std::max(hi[1], m_py[i]);
+        lo[2] = std::min(lo[2], m_pz[i]); hi[2] = std::max(hi[2], m_pz[i]);
+    }
+    m_rootSize = std::max(hi[0] - lo[0], std::max(hi[1] - lo[1], hi[2] - lo[2])) * 1.001f + 1e-3f;
+    for (int c = 0; c < 3; c++) m_min[c] = lo[c];
+
+    m_order.resize(m_count);
+    float cells = (float)(1 << NBODY_LEVELS) / m_rootSize;
+    const float *corner = m_min;
+    parallelFor(m_count, [=](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            uint64_t x = std::min((uint64_t)((m_px[i] - corner[0]) * cells), (uint64_t)(1 << NBODY_LEVELS) - 1);
+            uint64_t y = std::min((uint64_t)((m_py[i] - corner[1]) * cells), (uint64_t)(1 << NBODY_LEVELS) - 1);
+            uint64_t z = std::min((uint64_t)((m_pz[i] - corner[2]) * cells), (uint64_t)(1 << NBODY_LEVELS) - 1);
+            m_order[i] = std::make_pair(spreadBits(x) | spreadBits(y) << 1 | spreadBits(z) << 2, i);
+        }
+    }, threads);
+    std::sort(m_order.begin(), m_order.end());
+
+    // Gather every array into the new order
+    m_keys.resize(m_count);
+    m_scratch.resize(m_px.size());
+    m_scratchIds.resize(m_count);
+    for (int i = 0; i < m_count; i++) m_keys[i] = m_order[i].first;
+    std::vector<float> *arrays[] = { &m_px, &m_py, &m_pz, &m_vx, &m_vy, &m_vz, &m_mass };
+    for (int a = 0; a < 7; a++) {
+        std::vector<float> &array = *arrays[a];
+        for (int i = 0; i < m_count; i++) m_scratch[i] = array[m_order[i].second];
+        array.swap(m_scratch);
+    }
+    for (int i = 0; i < m_count; i++) m_scratchIds[i] = m_ids[m_order[i].second];
+    m_ids.swap(m_scratchIds);
+}
+
+/**
+ * @brief Adds the node holding sorted bodies [begin, end) and everything under it
+ * Children are the runs of bodies sharing the next 3 bits of their keys,
+ * so they come straight from the sorted keys. The biggest nodes with at
+ * most NBODY_GROUP_SIZE bodies become groups.
+ * @param begin First body in the node
+ * @param end One past the last body
+ * @param level How deep the node is, 0 for the root
+ * @param grouped If a node above this one is already a group
+ * @return The node's index
+ */
+int NBodySystem::buildNode(int begin, int end, int level, bool grouped) {
+    int index = m_nodes.size();
+    m_nodes.push_back(NBodyNode());
+    double mass = 0, x = 0, y = 0, z = 0;
+    bool leaf = end - begin <= NBODY_LEAF_SIZE || level == NBODY_LEVELS;
+    if (!grouped && (leaf || end - begin <= NBODY_GROUP_SIZE)) {
+        m_groups.push_back(index);
+        m_groupBegins.push_back(begin);
+        grouped = true;
+    }
+
+    if (leaf) {
+        for (int i = begin; i < end; i++) {
+            mass += m_mass[i];
+            x += (double)m_mass[i] * m_px[i];
+            y += (double)m_mass[i] * m_py[i];
+            z += (double)m_mass[i] * m_pz[i];
+        }
+    } else {
+        int shift = 3 * (NBODY_LEVELS - 1 - level);
+        for (int start = begin; start < end;) {
+            uint64_t limit = ((m_keys[start] >> shift) + 1) << shift;
+            int stop = std::lower_bound(m_keys.begin() + start, m_keys.begin() + end, limit) - m_keys.begin();
+            const NBodyNode &child = m_nodes[buildNode(start, stop, level + 1, grouped)];
+            mass += child.mass;
+            x += (double)child.mass * child.x;
+            y += (double)child.mass * child.y;
+            z += (double)child.mass * child.z;
+            start = stop;
+        }
+    }
+
+    NBodyNode &node = m_nodes[index];
+    node.mass = mass;
+    node.x = mass > 0 ? x / mass : 0;
+    node.y = mass > 0 ? y / mass : 0;
+    node.z = mass > 0 ? z / mass : 0;
+    node.size = m_rootSize / (float)(1 << level);
+    node.begin = begin;
+    node.end = end;
+    node.next = m_nodes.size();
+    return index;
+}
+
+/**
+ * @brief Walks the tree once for a group, then pulls every body in it
+ * A node is lumped together if it's small enough next to its distance from
+ * the group's bounding box, so the list is right for all of its bodies.
+ * @param group Which group
+ * @param list Scratch space for the group's interactions, 4 floats each
+ */
+void NBodySystem::forceGroup(int group, std::vector<float> *list) {
+    const NBodyNode &bodies = m_nodes[m_groups[group]];
+    float lo[3] = { m_px[bodies.begin], m_py[bodies.begin], m_pz[bodies.begin] }, hi[3] = { lo[0], lo[1], lo[2] };
+    for (int i = bodies.begin + 1; i < bodies.end; i++) {
+        lo[0] = std::min(lo[0], m_px[i]); hi[0] = std::max(hi[0], m_px[i]);
+        lo[1] = std::min(lo[1], m_py[i]); hi[1] = std::max(hi[1], m_py[i]);
+        lo[2] = std::min(lo[2], m_pz[i]); hi[2] = std::max(hi[2], m_pz[i]);
+    }
+
+    // Everything pulling on the group, as position and G times mass
+    list->clear();
+    int count = m_nodes.size();
+    for (int n = 0; n < count;) {
+        const NBodyNode &node = m_nodes[n];
+        if (node.mass <= 0) {
+            n = node.next;
+            continue;
+        }
+        float dx = std::max(0.0f, std::max(lo[0] - node.x, node.x - hi[0]));
+        float dy = std::max(0.0f, std::max(lo[1] - node.y, node.y - hi[1]));
+        float dz = std::max(0.0f, std::max(lo[2] - node.z, node.z - hi[2]));
+        if (node.size * node.size < NBODY_THETA * NBODY_THETA * (dx*dx + dy*dy + dz*dz)) {
+            float entry[4] = { node.x, node.y, node.z, node.mass };
+            list->insert(list->end(), entry, entry + 4);
+            n = node.next;
+        } else if (node.next == n + 1) {
+            for (int i = node.begin; i < node.end; i++) {
+                if (m_mass[i] <= 0) continue;
+                float entry[4] = { m_px[i], m_py[i], m_pz[i], m_mass[i] };
+                list->insert(list->end(), entry, entry + 4);
+            }
+            n = node.next;
+        } else {
+            n++;
+        }
+    }
+
+    int entries = list->size() / 4;
+    const float *pull = entries > 0 ? &(*list)[0] : NULL;
+    float eps2 = NBODY_SOFTENING * NBODY_SOFTENING;
+    float accel = 0;
+#ifdef SIMD_WIDTH
+    // SIMD_WIDTH bodies at a time against each entry - lanes past the group read padding and are dropped
+    for (int i = bodies.begin; i < bodies.end; i += SIMD_WIDTH) {
+        vfloat x = vloadu(&m_px[i]), y = vloadu(&m_py[i]), z = vloadu(&m_pz[i]);
+        vfloat soft = vset1(eps2), one = vset1(1.0f);
+        vfloat r2 = vadd(vadd(vmul(x, x), vmul(y, y)), vadd(vmul(z, z), soft));
+        vfloat inv = vdiv(one, vsqrt(r2));
+        vfloat central = vmul(vset1(-m_gm), vmul(inv, vmul(inv, inv)));
+        vfloat ax = vmul(x, central), ay = vmul(y, central), az = vmul(z, central);
+        for (int e = 0; e < entries; e++) {
+            const float *entry = pull + e*4;
+            vfloat dx = vsub(vset1(entry[0]), x), dy = vsub(vset1(entry[1]), y), dz = vsub(vset1(entry[2]), z);
+            vfloat d2 = vadd(vadd(vmul(dx, dx), vmul(dy, dy)), vadd(vmul(dz, dz), soft));
+            vfloat id = vdiv(one, vsqrt(d2));
+            vfloat s = vmul(vset1(entry[3]), vmul(id, vmul(id, id)));
+            ax = vadd(ax, vmul(dx, s));
+            ay = vadd(ay, vmul(dy, s));
+            az = vadd(az, vmul(dz, s));
+        }
+
+        float lanes[3][SIMD_WIDTH];
+        vstoreu(lanes[0], ax);
+        vstoreu(lanes[1], ay);
+        vstoreu(lanes[2], az);
+        for (int l = 0; l < SIMD_WIDTH && i + l < bodies.end; l++) {
+            m_ax[i + l] = lanes[0][l];
+            m_ay[i + l] = lanes[1][l];
+            m_az[i + l] = lanes[2][l];
+            accel = std::max(accel, lanes[0][l]*lanes[0][l] + lanes[1][l]*lanes[1][l] + lanes[2][l]*lanes[2][l]);
+        }
+    }
+#else
+    for (int i = bodies.begin; i < bodies.end; i++) {
+        float x = m_px[i], y = m_py[i], z = m_pz[i];
+        float r2 = x*x + y*y + z*z + eps2;
+        float central = -m_gm / (r2 * sqrt(r2));
+        float ax = x * central, ay = y * central, az = z * central;
+        for (int e = 0; e < entries; e++) {
+            const float *entry = pull + e*4;
+            float dx = entry[0] - x, dy = entry[1] - y, dz = entry[2] - z;
+            float d2 = dx*dx + dy*dy + dz*dz + eps2;
+            float s = entry[3] / (d2 * sqrt(d2));
+            ax += dx * s;
+            ay += dy * s;
+            az += dz * s;
+        }
+        m_ax[i] = ax;
+        m_ay[i] = ay;
+        m_az[i] = az;
+        accel = std::max(accel, ax*ax + ay*ay + az*az);
+    }
+#endif
+    m_groupAccel[group] = accel;
+    m_groupInteractions[group] = entries * (bodies.end - bodies.begin);
+}
+
+/**
+ * @brief Makes the latest step the newest ephemeris, back in body order
+ * @param threads How many threads to use, 0 for parallelThreadCount()
+ */
+void NBodySystem::recordEphemeris(int threads) {
+    m_latest = 1 - m_latest;
+    NBodyEphemeris &latest = m_ephemeris[m_latest];
+    latest.time = m_time;
+    latest.position.resize(m_count * 3);
+    latest.velocity.resize(m_count * 3);
+    parallelFor(m_count, [this, &latest](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            int id = m_ids[i];
+            latest.position[id*3] = m_px[i];
+            latest.position[id*3 + 1] = m_py[i];
+            latest.position[id*3 + 2] = m_pz[i];
+            latest.velocity[id*3] = m_vx[i];
+            latest.velocity[id*3 + 1] = m_vy[i];
+            latest.velocity[id*3 + 2] = m_vz[i];
+        }
+    }, threads);
+}
@@ -0,0 +1,125 @@
+#ifndef NBODYSYSTEM_H
+#define NBODYSYSTEM_H
+
+#include "PlanetDataParser.h"
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief What the last advance and force pass did
+ */
+struct NBodyStats {
+    NBodyStats() : substeps(0), nodes(0), groups(0), interactions(0), dropped(0) {}
+
+    int substeps; // Substeps the last advance took
+    int nodes; // Tree nodes in the last force pass
+    int groups; // Groups of nearby bodies that walked the tree, once for all of them
+    float interactions; // Mean nodes and bodies pulling on each body in the last force pass
+    float dropped; // Time the last advance gave up on because it couldn't keep up
+};
+
+/**
+ * @brief A cube of the octree, with everything in it lumped at its center of mass
+ * Nodes are stored depth first, so a node's first child is the node right
+ * after it and next skips its whole subtree. Leaves have nothing to skip.
+ */
+struct NBodyNode {
+    float x, y, z, mass; // Center of mass, then G times the mass
+    float size; // Side of the node's cube
+    int begin, end; // Bodies inside, in tree order
+    int next; // The node after this one's subtree
+};
+
+/**
+ * @brief Bodies at their positions and velocities at one time, in body order
+ */
+struct NBodyEphemeris {
+    NBodyEphemeris() : time(0) {}
+
+    float time;
+    std::vector<float> position; // xyz per body
+    std::vector<float> velocity;
+};
+
+/**
+ * @brief Physical orbits for every body, instead of closed form rotations
+ * Bodies start where their PlanetData puts them, on circular orbits around
+ * a fixed mass at the origin whose pull is picked so the bodies' closed form
+ * years mostly hold. Each body's mass is a fraction of that one, and every
+ * body with mass pulls on every other through a Barnes-Hut octree. Steps
+ * are kick-drift-kick leapfrog, as long as the largest acceleration allows.
+ *
+ * Every force pass sorts the bodies along a Morton curve, so the tree is
+ * built straight from the sorted keys and each node's bodies sit together.
+ * Small subtrees walk the tree once for all their bodies, and the forces on
+ * them are summed SIMD_WIDTH bodies at a time, on every thread parallelFor has.
+ *
+ * Time is in PlanetData year units, the renderer's rotational speed. The
+ * two latest steps are kept as an ephemeris, so positions at any time
+ * between them come out smooth however steps and frames line up. Asked to
+ * go further than NBODY_MAX_SUBSTEPS steps can, it falls behind instead.
+ */
+class NBodySystem {
+public:
+    NBodySystem();
+
+    // Starts over with these bodies, at time 0
+    void reset(const QList<PlanetData> &bodies);
+
+    // Steps until the ephemeris reaches time, starting the clock on the first call
+    void advanceTo(float time, int threads = 0);
+    void step(float dt, int threads = 0);
+
+    // Writes xyz for every body in order at time, stride floats apart
+    void positionsAt(float time, float *out, int stride, int threads = 0) const;
+
+    int getBodyCount() const;
+    float getTime() const;
+    float getStableStep() const;
+    NBodyStats getStats() const;
+
+    // Slow checks, for the micro-benchmark
+    double energy() const;
+    double forceError(int samples) const;
+
+private:
+    void computeForces(int threads);
+    void sortBodies(int threads);
+    int buildNode(int begin, int end, int level, bool grouped);
+    void forceGroup(int group, std::vector<float> *list);
+    void recordEphemeris(int threads);
+
+    int m_count;
+    float m_gm; // G times the mass at the origin
+    float m_time; // Time of the latest step
+    float m_offset; // What's subtracted from times asked for, grown whenever stepping falls behind
+    bool m_started;
+    float m_dt; // Step the last force pass allows
+    NBodyStats m_stats;
+
+    // Bodies in tree order, each array padded by a SIMD width
+    std::vector<float> m_px, m_py, m_pz;
+    std::vector<float> m_vx, m_vy, m_vz;
+    std::vector<float> m_ax, m_ay, m_az;
+    std::vector<float> m_mass; // G times the mass
+    std::vector<int> m_ids; // Which body each one is
+
+    // The tree, rebuilt every force pass
+    std::vector<std::pair<uint64_t, int> > m_order; // Morton key, then index before sorting
+    std::vector<uint64_t> m_keys; // Sorted keys
+    std::vector<float> m_scratch;
+    std::vector<int> m_scratchIds;
+    std::vector<NBodyNode> m_nodes;
+    std::vector<int> m_groups; // Nodes that walk the tree for their bodies, in order
+    std::vector<int> m_groupBegins; // First body of each group
+    std::vector<float> m_groupAccel; // Largest acceleration squared in each group
+    std::vector<int> m_groupInteractions; // Interactions summed over each group's bodies
+    float m_min[3]; // Corner of the root cube
+    float m_rootSize;
+
+    NBodyEphemeris m_ephemeris[2];
+    int m_latest; // Which ephemeris is newest
+};
+
+#endif // NBODYSYSTEM_H
@@ -9,6 +9,21 @@
  */
 Particle::Particle() {
     m_isInitialized = false;
+    m_vaoID = 0;
+    m_vboID = 0;
+    m_instanceID = 0;
+    m_instanceSource = 0;
+    m_instanceFirst = 0;
+    m_instanceCapacity = 0;
+}
+
+/**
+ * @brief Deletes the quad and instance buffers
+ */
+Particle::~Particle() {
+    if (m_instanceID != 0) glDeleteBuffers(1, &m_instanceID);
+    if (m_vboID != 0) glDeleteBuffers(1, &m_vboID);
+    if (m_vaoID != 0) glDeleteVertexArrays(1, &m_vaoID);
 }
 
 /**
@@ -32,9 +47,8 @@ void Particle::init(const GLuint vertexLocation, const GLuint textureLocation){
     // VAO and vertex buffer init
     glGenVertexArrays(1, &m_vaoID);
     glBindVertexArray(m_vaoID);
-    GLuint vertexBuffer;
-    glGenBuffers(1, &vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glGenBuffers(1, &m_vboID);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vboID);
     glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat)*30, vertexBufferData, GL_STATIC_DRAW);
 
     // Expose vertices to shader
@@ -64,24 +78,118 @@ void Particle::init(const GLuint vertexLocation, const GLuint textureLocation){
 }
 
 /**
- * @brief Draws a particle by binding to the VAO and drawing 2 triangles
- * Fails if init hasn't been called
+ * @brief Adds a per instance buffer to the particle's VAO - assumes init was called
+ * Each instance is PARTICLE_INSTANCE_FLOATS floats: a vec4 of position and life,
+ * then a vec4 of direction and decay.
+ * @param posLifeLocation The shader's location for position + life
+ * @param dirDecayLocation The shader's location for direction + decay
  */
-void Particle::draw(){
-    if (!m_isInitialized){
-        std::cout << "You must call init() before you can draw!" << std::endl;
-        return;
+void Particle::initInstances(const GLuint posLifeLocation, const GLuint dirDecayLocation) {
+    m_instanceLocations.clear();
+    m_instanceLocations.push_back(posLifeLocation);
+    m_instanceLocations.push_back(dirDecayLocation);
+
+    glGenBuffers(1, &m_instanceID);
+    pointInstancesAt(m_instanceID);
+}
+
+/**
+ * @brief Adds a per instance buffer with a single vec4 per instance - assumes init was called
+ * Used for particles that never move, where the shader works out the rest.
+ * @param posLifeLocation The shader's location for the vec4
+ */
+void Particle::initInstances(const GLuint posLifeLocation) {
+    m_instanceLocations.clear();
+    m_instanceLocations.push_back(posLifeLocation);
+
+    glGenBuffers(1, &m_instanceID);
+    pointInstancesAt(m_instanceID);
+}
+
+/**
+ * @brief Draws instances from a buffer owned by someone else, like a GPU simulation
+ * The buffer must be laid out the same as setInstances' data. setInstances
+ * switches back to the particle's own buffer.
+ * @param buffer The buffer to read instances from
+ */
+void Particle::setInstanceBuffer(GLuint buffer) {
+    pointInstancesAt(buffer);
+}
+
+/**
+ * @brief Uploads instance data, growing the buffer only when it's too small
+ * Data that's only set once (GL_STATIC_DRAW) always gets fresh storage sized to fit.
+ * @param data getInstanceFloats() floats per instance
+ * @param count The number of instances in data
+ * @param usage GL_STREAM_DRAW for data set every frame, GL_STATIC_DRAW for data set once
+ */
+void Particle::setInstances(const GLfloat *data, int count, GLenum usage) {
+    if (m_instanceSource != m_instanceID || m_instanceFirst != 0) pointInstancesAt(m_instanceID);
+
+    GLsizeiptr size = count*getInstanceFloats()*sizeof(GLfloat);
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceID);
+    if (count > m_instanceCapacity || usage != GL_STREAM_DRAW) {
+        glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+        m_instanceCapacity = count;
+    } else {
+        // Orphan the old storage so we never wait on the last frame's draw
+        glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity*getInstanceFloats()*sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
     }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    glDepthMask(GL_FALSE);
-    glEnable(GL_BLEND);
+/**
+ * @brief Returns how many floats each instance takes up
+ * @return 4 per vec4 passed to initInstances
+ */
+int Particle::getInstanceFloats() {
+    return 4*m_instanceLocations.size();
+}
 
+/**
+ * @brief Points the instance attributes of the VAO at a buffer
+ * Starting partway in stands in for base instances, which need GL 4.2
+ * @param buffer The buffer to read instances from
+ * @param first The instance in the buffer that's drawn as instance 0
+ */
+void Particle::pointInstancesAt(GLuint buffer, int first) {
+    m_instanceSource = buffer;
+    m_instanceFirst = first;
     glBindVertexArray(m_vaoID);
-    glDrawArrays(GL_TRIANGLES, 0, NUM_TRIS*3);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    GLsizei stride = getInstanceFloats()*sizeof(GLfloat);
+    for (size_t i = 0; i < m_instanceLocations.size(); i++) {
+        GLintptr offset = first*stride + 4*i*sizeof(GLfloat);
+        glEnableVertexAttribArray(m_instanceLocations[i]);
+        glVertexAttribPointer(m_instanceLocations[i], 4, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+        glVertexAttribDivisor(m_instanceLocations[i], 1);
+    }
+
+    // Clean up
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+}
 
-    glAccum(GL_MULT,0.5);
-    glAccum(GL_ACCUM,1);
-    glAccum(GL_RETURN,1);
+/**
+ * @brief Draws count quads in one call
+ * Fails if init or initInstances haven't been called
+ * @param count The number of quads to draw
+ * @param divisor How many quads in a row share one instance's data
+ * @param first The first instance in the buffer to draw
+ */
+void Particle::drawInstanced(int count, int divisor, int first) {
+    if (!m_isInitialized || m_instanceID == 0){
+        std::cout << "You must call init() and initInstances() before you can draw!" << std::endl;
+        return;
+    }
+    if (first != m_instanceFirst) pointInstancesAt(m_instanceSource, first);
+
+    glBindVertexArray(m_vaoID);
+    for (size_t i = 0; i < m_instanceLocations.size(); i++) {
+        glVertexAttribDivisor(m_instanceLocations[i], divisor);
+    }
+    glDrawArraysInstanced(GL_TRIANGLES, 0, NUM_TRIS*3, count);
+    glBindVertexArray(0);
 }
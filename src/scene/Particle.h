@@ -3,31 +3,39 @@
 
 #include "GLCommon.h"
 
-/**
- * @brief Struct to hold information about a particle
- */
-struct __attribute__ ((aligned (16))) ParticleData {
-    float life;
-    float decay;
-    glm::vec3 color;
-    glm::vec3 pos;
-    glm::vec3 dir;
-    glm::vec3 force;
-};
+// Floats per moving instance: position + life, then direction + decay
+#define PARTICLE_INSTANCE_FLOATS 8
 
 /**
- * @brief Supports initialization and rendering of particles
+ * @brief Supports initialization and instanced rendering of particles
+ * Every particle is the same quad - what differs per particle (position,
+ * life, direction, decay) comes from an instance buffer, so any number
+ * of them draw with one call.
  */
 class Particle {
 public:
     Particle();
+    ~Particle();
 
     void init(const GLuint vertexLocation, const GLuint normalLocation);
-    void draw();
+    void initInstances(const GLuint posLifeLocation, const GLuint dirDecayLocation);
+    void initInstances(const GLuint posLifeLocation);
+    void setInstances(const GLfloat *data, int count, GLenum usage = GL_STREAM_DRAW);
+    void setInstanceBuffer(GLuint buffer);
+    int getInstanceFloats();
+    void drawInstanced(int count, int divisor = 1, int first = 0);
 
 private:
+    void pointInstancesAt(GLuint buffer, int first = 0);
+
     bool m_isInitialized;
     GLuint m_vaoID;
+    GLuint m_vboID;
+    GLuint m_instanceID;
+    GLuint m_instanceSource; // Buffer the instance attributes read from right now
+    int m_instanceFirst; // Instance in that buffer they start at
+    std::vector<GLuint> m_instanceLocations; // One vec4 attribute each, in order
+    int m_instanceCapacity; // Instances the buffer currently has room for
 };
 
 #endif // PARTICLE_H
@@ -0,0 +1,129 @@
+#include "PlanetLOD.h"
+
+#include <algorithm>
+
+#define LOD_PIXELS_PER_EDGE 6.0f // Wanted length of a triangle edge across the middle of the planet
+#define LOD_HYSTERESIS 0.25f // How much finer than needed a coarser level must be to switch down
+#define LOD_FADE_FRAMES 12 // Length of a cross fade
+
+/**
+ * @brief Sorts resolutions from coarsest to finest
+ * @param a The first resolution
+ * @param b The second resolution
+ * @return If a is less detailed than b
+ */
+static bool lessDetailed(const PlanetResolution &a, const PlanetResolution &b) {
+    return a.detail < b.detail;
+}
+
+/**
+ * @brief Starts with no levels - everything draws with the default resolution until setLevels()
+ */
+PlanetLOD::PlanetLOD() {}
+
+/**
+ * @brief Replaces the levels and forgets every planet's state
+ * @param resolutions All resolutions that have meshes, in any order
+ * @param bodies How many planets will be updated
+ */
+void PlanetLOD::setLevels(const QList<PlanetResolution> &resolutions, int bodies) {
+    m_levels.clear();
+    for (int i = 0; i < resolutions.size(); i++) {
+        if (!m_levels.contains(resolutions.at(i))) m_levels.append(resolutions.at(i));
+    }
+    std::stable_sort(m_levels.begin(), m_levels.end(), lessDetailed);
+    m_states.assign(bodies, PlanetLODState());
+}
+
+/**
+ * @brief Gives back the resolution for a level
+ * @param level An index from a PlanetLODState
+ * @return The resolution to draw with
+ */
+PlanetResolution PlanetLOD::getLevel(int level) {
+    if (m_levels.isEmpty()) return PlanetResolution();
+    return m_levels.at(glm::clamp(level, 0, m_levels.size() - 1));
+}
+
+/**
+ * @brief Returns how many levels there are
+ * @return The number of distinct resolutions
+ */
+int PlanetLOD::getLevelCount() {
+    return m_levels.size();
+}
+
+/**
+ * @brief Moves one planet to the level its screen size needs, and steps its cross fade
+ * @param body The planet's index in the body table, in [0, bodies)
+ * @param start The resolution from the XML, used for the first frame
+ * @param screenRadius The planet's projected radius in pixels
+ * @param crossFade If a switch fades between the two levels instead of popping
+ * @return The planet's state for this frame
+ */
+const PlanetLODState &PlanetLOD::update(int body, PlanetResolution start, float screenRadius, bool crossFade) {
+    PlanetLODState &state = m_states[body];
+    if (state.level < 0) state.level = std::max(0, m_levels.indexOf(start));
+    if (state.fadeFrames > 0) state.fadeFrames--;
+
+    // Wait for a fade to finish before starting another
+    int level = levelFor(state.level, screenRadius);
+    if (level != state.level && state.fadeFrames == 0) {
+        state.previous = state.level;
+        state.level = level;
+        state.fadeFrames = crossFade ? LOD_FADE_FRAMES : 0;
+    }
+    return state;
+}
+
+/**
+ * @brief How much of the new level is showing in a cross fade
+ * @param state A planet's state
+ * @return 0 when just switched, up to 1 once the fade is done
+ */
+float PlanetLOD::fadeAmount(const PlanetLODState &state) {
+    return 1.0f - state.fadeFrames / (float)(LOD_FADE_FRAMES + 1);
+}
+
+/**
+ * @brief Projects a sphere's radius onto the screen
+ * Uses the distance to the center, so it's a little small for spheres
+ * seen from very close - anything the eye is inside of is as big as it gets.
+ * @param center The sphere's center in eye space
+ * @param worldRadius The sphere's radius in eye space
+ * @param projection The camera's projection
+ * @param height The framebuffer's height in pixels
+ * @return The radius in pixels
+ */
+float PlanetLOD::screenRadius(const glm::vec3 &center, float worldRadius, const glm::mat4 &projection, float height) {
+    float distance = glm::length(center);
+    if (distance <= worldRadius) return height;
+    return worldRadius / distance * projection[1][1] * height * 0.5f;
+}
+
+/**
+ * @brief Picks the coarsest level fine enough for a screen radius, with hysteresis
+ * A level of detail d has about 2d edges around the equator, so the
+ * detail needed is half the circumference over the wanted edge length.
+ * @param current The level drawn last frame
+ * @param screenRadius The planet's projected radius in pixels
+ * @return The level to draw with this frame
+ */
+int PlanetLOD::levelFor(int current, float screenRadius) {
+    if (m_levels.isEmpty()) return 0;
+    float needed = (float)M_PI * screenRadius / LOD_PIXELS_PER_EDGE;
+
+    // Finest level is the fallback when nothing is enough
+    int level = m_levels.size() - 1;
+    for (int i = 0; i < m_levels.size(); i++) {
+        if (m_levels.at(i).detail >= needed) {
+            level = i;
+            break;
+        }
+    }
+
+    // Finer switches right away, coarser only with a margin
+    if (level >= current) return level;
+    while (level < current && m_levels.at(level).detail * (1.0f - LOD_HYSTERESIS) < needed) level++;
+    return level;
+}
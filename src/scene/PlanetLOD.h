@@ -0,0 +1,54 @@
+#ifndef PLANETLOD_H
+#define PLANETLOD_H
+
+#include "GLCommon.h"
+#include "PlanetDataParser.h"
+#include <vector>
+
+/**
+ * @brief Which mesh a planet was last drawn with, and what it's fading from
+ */
+struct PlanetLODState {
+    PlanetLODState() : level(-1), previous(0), fadeFrames(0) {}
+
+    int level; // Index into the levels, coarsest first - -1 until first drawn
+    int previous; // Level being faded out, only used while fadeFrames > 0
+    int fadeFrames; // Frames left in the cross fade, 0 if not fading
+};
+
+/**
+ * @brief Picks each planet's resolution every frame from how big it is on screen
+ * Levels are all resolutions sorted by detail. A planet moves to a finer
+ * level as soon as its projected radius needs it, but only drops to a
+ * coarser one once that level would be enough with some margin, so a
+ * planet sitting on a boundary doesn't pop back and forth. Switches can
+ * optionally cross fade over a few frames with a screen door dither.
+ * Planets are known by their index in the body table, so thousands of
+ * them only cost an array lookup each.
+ */
+class PlanetLOD {
+public:
+    PlanetLOD();
+
+    // Replaces the levels and forgets every planet
+    void setLevels(const QList<PlanetResolution> &resolutions, int bodies);
+    PlanetResolution getLevel(int level);
+    int getLevelCount();
+
+    // Steps one planet's state for this frame, starting it at its XML resolution
+    const PlanetLODState &update(int body, PlanetResolution start, float screenRadius, bool crossFade);
+
+    // How far a planet's cross fade is, in [0,1]
+    static float fadeAmount(const PlanetLODState &state);
+
+    // Radius in pixels of a sphere at the model's origin
+    static float screenRadius(const glm::vec3 &center, float worldRadius, const glm::mat4 &projection, float height);
+
+private:
+    int levelFor(int current, float screenRadius);
+
+    QList<PlanetResolution> m_levels;
+    std::vector<PlanetLODState> m_states; // One per body
+};
+
+#endif // PLANETLOD_H
@@ -0,0 +1,207 @@
+#include "PlanetMesh.h"
+#include "Sphere.h"
+#include "IcoSphere.h"
+#include "CubeSphere.h"
+#include "Noise.h"
+
+#include <vector>
+
+
+/**
+ * @brief Sets up an empty mesh - nothing is created until bake()
+ */
+PlanetMesh::PlanetMesh()
+    : m_vao(0), m_buffer(0), m_indices(0), m_count(0), m_indexCount(0), m_instanceSource(0), m_instanceFirst(0) {}
+
+/**
+ * @brief Deletes the baked buffer and VAO
+ */
+PlanetMesh::~PlanetMesh() {
+    deleteGL();
+}
+
+/**
+ * @brief Runs every vertex of a sphere through the noise shader once, with rasterizing off
+ * The sphere itself is only needed while baking, so it's thrown away after.
+ * @param bakeShader The transform feedback program capturing bakedPosition and bakedNoise
+ * @param drawShader The program the mesh is drawn with, reading positionNoise
+ * @param resolution How detailed the sphere is and how it's tesselated
+ * @param noise The planet's noise basis and octave range
+ * @param seed The planet noise seed
+ */
+void PlanetMesh::bake(GLuint bakeShader, GLuint drawShader, PlanetResolution resolution, PlanetNoise noise,
+                      float seed) {
+    deleteGL();
+    Sphere *sphere = createSphere(bakeShader, resolution);
+    m_count = sphere->getVertexCount();
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    glBufferData(GL_ARRAY_BUFFER, m_count*NOISE_BAKED_FLOATS*sizeof(GLfloat), NULL, GL_STATIC_COPY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glUseProgram(bakeShader);
+    NoiseOptions options = noiseOptions(resolution, noise);
+    glUniform1f(glGetUniformLocation(bakeShader, "seed"), seed);
+    glUniform1i(glGetUniformLocation(bakeShader, "octaves"), options.octaves);
+    glUniform1i(glGetUniformLocation(bakeShader, "simplex"), options.basis == NOISE_SIMPLEX);
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_buffer);
+    glBeginTransformFeedback(GL_POINTS);
+    sphere->renderPoints();
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    glUseProgram(0);
+
+    // Drawn straight from what was captured
+    createVAO(drawShader, sphere);
+    delete sphere;
+}
+
+/**
+ * @brief Works out the noise for every vertex of a sphere with Noise, then uploads it
+ * Gives the same mesh as bake(), without needing transform feedback.
+ * @param drawShader The program the mesh is drawn with, reading positionNoise
+ * @param resolution How detailed the sphere is and how it's tesselated
+ * @param noise The planet's noise basis and octave range
+ * @param seed The planet noise seed
+ */
+void PlanetMesh::bakeCPU(GLuint drawShader, PlanetResolution resolution, PlanetNoise noise, float seed) {
+    deleteGL();
+    Sphere *sphere = createSphere(drawShader, resolution);
+    m_count = sphere->getVertexCount();
+
+    std::vector<GLfloat> baked(m_count*NOISE_BAKED_FLOATS);
+    Noise::bakePlanet(sphere->getVertexData(), m_count, seed, &baked[0], 0, noiseOptions(resolution, noise));
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    glBufferData(GL_ARRAY_BUFFER, baked.size()*sizeof(GLfloat), &baked[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    createVAO(drawShader, sphere);
+    delete sphere;
+}
+
+/**
+ * @brief Picks the octaves a sphere's vertices can show, within the planet's range
+ * Every mesh type puts about detail vertices from pole to pole.
+ * @param resolution How detailed the sphere is
+ * @param noise The planet's noise basis and octave range
+ * @return What to bake the sphere with
+ */
+NoiseOptions PlanetMesh::noiseOptions(PlanetResolution resolution, PlanetNoise noise) {
+    return noise.optionsFor((float)M_PI / resolution.detail);
+}
+
+/**
+ * @brief Makes the sphere a resolution asks for
+ * @param shader The program the sphere's own VAO reads position and normal for
+ * @param resolution How detailed the sphere is and how it's tesselated
+ * @return A new sphere, to be deleted by the caller
+ */
+Sphere *PlanetMesh::createSphere(GLuint shader, PlanetResolution resolution) {
+    switch (resolution.mesh) {
+    case MESH_ICO: return new IcoSphere(shader, resolution.detail);
+    case MESH_CUBE: return new CubeSphere(shader, resolution.detail);
+    default: return new Sphere(shader, resolution.detail, resolution.detail);
+    }
+}
+
+/**
+ * @brief Makes the VAO drawing from the baked buffer, copying the sphere's indices if it has them
+ * Instance attributes are found here, but only pointed at a buffer when drawn.
+ * @param drawShader The program the mesh is drawn with, reading positionNoise and the instance attributes
+ * @param sphere The sphere that was baked
+ */
+void PlanetMesh::createVAO(GLuint drawShader, Sphere *sphere) {
+    m_instanceLocations.clear();
+    m_instanceLocations.push_back(glGetAttribLocation(drawShader, "instance"));
+    m_instanceSource = 0;
+    m_instanceFirst = 0;
+
+    GLuint positionNoise = glGetAttribLocation(drawShader, "positionNoise");
+    GLsizei stride = NOISE_BAKED_FLOATS*sizeof(GLfloat);
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    glEnableVertexAttribArray(positionNoise);
+    glVertexAttribPointer(positionNoise, NOISE_BAKED_FLOATS, GL_FLOAT, GL_FALSE, stride, (void*)0);
+
+    // The VAO keeps the element buffer bound for draw()
+    m_indexCount = sphere->getIndexCount();
+    if (m_indexCount > 0) {
+        glGenBuffers(1, &m_indices);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indices);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexCount*sizeof(GLuint), sphere->getIndexData(), GL_STATIC_DRAW);
+    }
+
+    // Clean up
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Points the instance attributes of the VAO at a buffer
+ * Starting partway in stands in for base instances, which need GL 4.2
+ * @param buffer The buffer to read instances from, PLANET_INSTANCE_FLOATS floats each
+ * @param first The instance in the buffer that's drawn as instance 0
+ */
+void PlanetMesh::pointInstancesAt(GLuint buffer, int first) {
+    m_instanceSource = buffer;
+    m_instanceFirst = first;
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    GLsizei stride = PLANET_INSTANCE_FLOATS*sizeof(GLfloat);
+    for (size_t i = 0; i < m_instanceLocations.size(); i++) {
+        GLintptr offset = first*stride + 4*i*sizeof(GLfloat);
+        glEnableVertexAttribArray(m_instanceLocations[i]);
+        glVertexAttribPointer(m_instanceLocations[i], 4, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+        glVertexAttribDivisor(m_instanceLocations[i], 1);
+    }
+
+    // Clean up
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Draws the baked triangles once per instance, in one call
+ * @param buffer The buffer holding instances, PLANET_INSTANCE_FLOATS floats each
+ * @param first The first instance in the buffer to draw
+ * @param count The number of instances to draw
+ */
+void PlanetMesh::drawInstanced(GLuint buffer, int first, int count) {
+    if (m_vao == 0 || count <= 0) return;
+    if (buffer != m_instanceSource || first != m_instanceFirst) pointInstancesAt(buffer, first);
+
+    glBindVertexArray(m_vao);
+    if (m_indexCount > 0) glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, (void*)0, count);
+    else glDrawArraysInstanced(GL_TRIANGLES, 0, m_count, count);
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Returns how many vertices were baked - shared ones only count once
+ * @return m_count
+ */
+int PlanetMesh::getVertexCount() {
+    return m_count;
+}
+
+/**
+ * @brief Deletes the buffer and VAO, if they exist
+ */
+void PlanetMesh::deleteGL() {
+    if (m_vao != 0) glDeleteVertexArrays(1, &m_vao);
+    if (m_buffer != 0) glDeleteBuffers(1, &m_buffer);
+    if (m_indices != 0) glDeleteBuffers(1, &m_indices);
+    m_vao = 0;
+    m_buffer = 0;
+    m_indices = 0;
+    m_count = 0;
+    m_indexCount = 0;
+    m_instanceSource = 0;
+    m_instanceFirst = 0;
+}
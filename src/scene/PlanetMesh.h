@@ -0,0 +1,61 @@
+#ifndef PLANETMESH_H
+#define PLANETMESH_H
+
+#include "GLCommon.h"
+#include "PlanetDataParser.h"
+#include <vector>
+
+// Floats per instance: body index, then the dither range, then unused - the rest is in the body buffer
+#define PLANET_INSTANCE_FLOATS 4
+
+class Sphere;
+
+/**
+ * @brief A sphere with planet noise already applied
+ * The noise only depends on the sphere's vertices and the seed, so it's
+ * worked out once per bake with transform feedback (noise.vert) instead
+ * of every vertex every frame. Each vertex keeps its displaced position
+ * and noise value, so drawing is a plain transform (planet.vert).
+ * Noise can port the same work to the CPU when transform feedback isn't
+ * available. Indexed spheres only bake their shared vertices and keep
+ * their triangles in an element buffer. Only as many octaves as the
+ * sphere's vertices can sample are baked, within the planet's range.
+ * Every planet drawn with a mesh is an instance of it, so any number of
+ * them draw with one call.
+ */
+class PlanetMesh {
+public:
+    PlanetMesh();
+    ~PlanetMesh();
+
+    // Replaces the mesh with a freshly noised sphere - needs a current GL context
+    void bake(GLuint bakeShader, GLuint drawShader, PlanetResolution resolution, PlanetNoise noise, float seed);
+
+    // The same, with the noise worked out on every core instead
+    void bakeCPU(GLuint drawShader, PlanetResolution resolution, PlanetNoise noise, float seed);
+
+    static NoiseOptions noiseOptions(PlanetResolution resolution, PlanetNoise noise);
+
+    void drawInstanced(GLuint buffer, int first, int count);
+    int getVertexCount();
+
+private:
+    PlanetMesh(const PlanetMesh &);
+    PlanetMesh &operator=(const PlanetMesh &);
+
+    static Sphere *createSphere(GLuint shader, PlanetResolution resolution);
+    void createVAO(GLuint drawShader, Sphere *sphere);
+    void pointInstancesAt(GLuint buffer, int first);
+    void deleteGL();
+
+    GLuint m_vao;
+    GLuint m_buffer; // Position then noise for every vertex
+    GLuint m_indices; // Triangles for indexed spheres, 0 otherwise
+    int m_count; // Number of vertices
+    int m_indexCount; // Number of indices, 0 if not indexed
+    std::vector<GLuint> m_instanceLocations; // One vec4 attribute each, in order
+    GLuint m_instanceSource; // Buffer the instance attributes read from right now
+    int m_instanceFirst; // Instance in that buffer they start at
+};
+
+#endif // PLANETMESH_H
@@ -0,0 +1,484 @@
+#include "PlanetTerrain.h"
+#include "Noise.h"
+#include "Shape.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#define FACES 6
+#define TERRAIN_QUADS 32 // Quads along each side of a chunk
+#define TERRAIN_ROW (TERRAIN_QUADS + 1)
+#define TERRAIN_VERTICES (TERRAIN_ROW*TERRAIN_ROW + 4*TERRAIN_ROW) // Grid, then skirt
+#define TERRAIN_MAX_LEVEL 12
+#define TERRAIN_PIXELS_PER_QUAD 6.0f // Nodes split while their quads are bigger than this on screen
+#define TERRAIN_CHUNK_BUDGET 384 // Most chunks a frame should draw, over all planets
+#define TERRAIN_BUDGET_STEP 1.1f // How fast the split threshold follows the budget
+#define TERRAIN_MAX_PIXELS_PER_QUAD (8*TERRAIN_PIXELS_PER_QUAD) // Highest the budget can push the threshold
+#define TERRAIN_MIN_RADIUS 0.42f // Lowest and highest the noise moves the surface, with a margin
+#define TERRAIN_MAX_RADIUS 0.64f
+#define TERRAIN_SKIRT 0.08f // Skirt depth as a fraction of the chunk's width
+#define TERRAIN_CACHE_CHUNKS 1024
+#define TERRAIN_UPLOADS_PER_FRAME 8
+#define TERRAIN_MAX_BUILDS 64 // Chunks queued at once - the rest are asked for again next frame
+
+// A node is its noise variant, face, level, and position in the level, packed into one key
+#define KEY(variant, face, level, x, y) (((quint64)(variant) << 56) | ((quint64)(face) << 53) | \
+                                         ((quint64)(level) << 48) | ((quint64)(x) << 24) | (quint64)(y))
+#define KEYVARIANT(key) (int)((key) >> 56)
+#define KEYFACE(key) (int)(((key) >> 53) & 0x7)
+#define KEYLEVEL(key) (int)(((key) >> 48) & 0x1f)
+#define KEYX(key) (int)(((key) >> 24) & 0xffffff)
+#define KEYY(key) (int)((key) & 0xffffff)
+#define MAX_VARIANTS 256
+
+/**
+ * @brief Makes one chunk on a worker thread and hands it back to the terrain
+ */
+class TerrainBuild : public QRunnable {
+public:
+    /**
+     * @brief Saves what to make - nothing happens until run()
+     * @param terrain The terrain to hand the chunk to
+     * @param key The node to make
+     * @param seed The planet noise seed
+     * @param options The octaves and basis for the node's level and variant
+     * @param generation The terrain's generation when this was queued
+     */
+    TerrainBuild(PlanetTerrain *terrain, quint64 key, float seed, NoiseOptions options, int generation)
+        : m_terrain(terrain), m_key(key), m_seed(seed), m_options(options), m_generation(generation) {}
+
+    /**
+     * @brief Makes the chunk's vertices and queues them for upload
+     */
+    void run() {
+        std::vector<GLfloat> vertices;
+        PlanetTerrain::buildChunk(m_key, m_seed, m_options, &vertices);
+        m_terrain->finish(m_key, m_generation, vertices);
+    }
+
+private:
+    PlanetTerrain *m_terrain;
+    quint64 m_key;
+    float m_seed;
+    NoiseOptions m_options;
+    int m_generation;
+};
+
+/**
+ * @brief Sets up an empty terrain - nothing is made until reset() and draw()
+ * Leaves one core for the GL thread.
+ */
+PlanetTerrain::PlanetTerrain()
+    : m_indices(0), m_indexCount(0), m_seed(0), m_generation(0), m_building(0), m_frame(0),
+      m_pixelsPerQuad(TERRAIN_PIXELS_PER_QUAD), m_splitDrawn(0) {
+    m_pool.setMaxThreadCount(glm::max(1, QThread::idealThreadCount() - 1));
+}
+
+/**
+ * @brief Waits for running builds, then deletes every chunk and the index buffer
+ */
+PlanetTerrain::~PlanetTerrain() {
+    m_pool.clear();
+    m_pool.waitForDone();
+    deleteChunks();
+    if (m_indices != 0) glDeleteBuffers(1, &m_indices);
+}
+
+/**
+ * @brief Forgets every chunk and starts making them with a new seed
+ * Builds already running finish, but what they make is thrown away.
+ * @param seed The planet noise seed
+ */
+void PlanetTerrain::reset(float seed) {
+    m_pool.clear();
+    deleteChunks();
+    m_variants.clear();
+    m_seed = seed;
+    m_generation++;
+    m_building = 0;
+}
+
+/**
+ * @brief Uploads a few finished chunks, then evicts the least recently used past the cache size
+ * Also nudges the split threshold toward drawing at most TERRAIN_CHUNK_BUDGET chunks.
+ * Only chunks below face level count, since no threshold can merge the faces.
+ * @param drawShader The program chunks are drawn with, reading positionNoise
+ */
+void PlanetTerrain::beginFrame(GLuint drawShader) {
+    if (m_splitDrawn > TERRAIN_CHUNK_BUDGET) {
+        m_pixelsPerQuad = glm::min(TERRAIN_MAX_PIXELS_PER_QUAD, m_pixelsPerQuad * TERRAIN_BUDGET_STEP);
+    } else if (m_splitDrawn < TERRAIN_CHUNK_BUDGET / 2) {
+        m_pixelsPerQuad = glm::max(TERRAIN_PIXELS_PER_QUAD, m_pixelsPerQuad / TERRAIN_BUDGET_STEP);
+    }
+    m_frame++;
+    m_stats = TerrainStats();
+    m_splitDrawn = 0;
+    if (m_indices == 0) createIndices();
+
+    // Take finished chunks without holding the lock while uploading
+    QList<Finished> finished;
+    {
+        QMutexLocker lock(&m_mutex);
+        while (!m_finished.isEmpty() && finished.size() < TERRAIN_UPLOADS_PER_FRAME) {
+            finished.append(m_finished.takeFirst());
+        }
+    }
+
+    GLuint positionNoise = glGetAttribLocation(drawShader, "positionNoise");
+    GLsizei stride = NOISE_BAKED_FLOATS*sizeof(GLfloat);
+    for (int i = 0; i < finished.size(); i++) {
+        const Finished &result = finished.at(i);
+        if (result.generation != m_generation || !m_chunks.contains(result.key)) continue;
+        m_building--;
+
+        // Tighter bounds than the whole noise range, for culling
+        Chunk &chunk = m_chunks[result.key];
+        chunk.minRadius = TERRAIN_MAX_RADIUS;
+        chunk.maxRadius = 0;
+        for (size_t v = 0; v < result.vertices.size(); v += NOISE_BAKED_FLOATS) {
+            float radius = glm::length(glm::vec3(result.vertices[v], result.vertices[v + 1], result.vertices[v + 2]));
+            chunk.minRadius = glm::min(chunk.minRadius, radius);
+            chunk.maxRadius = glm::max(chunk.maxRadius, radius);
+        }
+
+        glGenBuffers(1, &chunk.vbo);
+        glGenVertexArrays(1, &chunk.vao);
+        glBindVertexArray(chunk.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+        glBufferData(GL_ARRAY_BUFFER, result.vertices.size()*sizeof(GLfloat), &result.vertices[0], GL_STATIC_DRAW);
+        glEnableVertexAttribArray(positionNoise);
+        glVertexAttribPointer(positionNoise, NOISE_BAKED_FLOATS, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indices);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        m_lru.push_front(result.key);
+        chunk.lru = m_lru.begin();
+        chunk.lastUsed = m_frame;
+    }
+
+    // Only chunks nothing drew last frame can go
+    while ((int)m_lru.size() > TERRAIN_CACHE_CHUNKS) {
+        quint64 key = m_lru.back();
+        Chunk &chunk = m_chunks[key];
+        if (chunk.lastUsed >= m_frame - 1) break;
+        glDeleteVertexArrays(1, &chunk.vao);
+        glDeleteBuffers(1, &chunk.vbo);
+        m_chunks.remove(key);
+        m_lru.pop_back();
+    }
+}
+
+/**
+ * @brief Draws one planet's terrain with whatever viewProjection and instance attributes are already set
+ * @param modelView Takes the terrain's local space (where the sphere has radius 0.5) to eye space
+ * @param projection The camera's projection
+ * @param height The framebuffer's height in pixels
+ * @param noise The planet's noise basis and octave range
+ * @return If it was drawn - false until all six faces have been made
+ */
+bool PlanetTerrain::draw(const glm::mat4 &modelView, const glm::mat4 &projection, float height,
+                         const PlanetNoise &noise) {
+    int variant = m_variants.indexOf(noise);
+    if (variant < 0) {
+        if (m_variants.size() >= MAX_VARIANTS) return false;
+        variant = m_variants.size();
+        m_variants.append(noise);
+    }
+
+    bool ready = true;
+    for (int face = 0; face < FACES; face++) {
+        quint64 key = KEY(variant, face, 0, 0, 0);
+        if (!isReady(key)) {
+            request(key);
+            ready = false;
+        }
+    }
+    if (!ready) return false;
+
+    // Faces are never evicted, even when they're all out of view
+    for (int face = 0; face < FACES; face++) use(&m_chunks[KEY(variant, face, 0, 0, 0)]);
+
+    // Camera in the terrain's space
+    View view;
+    view.eye = glm::vec3(glm::inverse(modelView)[3]);
+    view.eyeDistance = glm::length(view.eye);
+    view.horizon = view.eyeDistance > TERRAIN_MIN_RADIUS ? acos(TERRAIN_MIN_RADIUS / view.eyeDistance) : -1.0f;
+    view.pixelScale = projection[1][1] * height * 0.5f;
+
+    // Frustum planes straight from the rows of the mvp
+    glm::mat4 mvp = glm::transpose(projection * modelView);
+    view.planes[0] = mvp[3] + mvp[0];
+    view.planes[1] = mvp[3] - mvp[0];
+    view.planes[2] = mvp[3] + mvp[1];
+    view.planes[3] = mvp[3] - mvp[1];
+    view.planes[4] = mvp[3] + mvp[2];
+    view.planes[5] = mvp[3] - mvp[2];
+
+    for (int face = 0; face < FACES; face++) drawNode(KEY(variant, face, 0, 0, 0), view);
+    return true;
+}
+
+/**
+ * @brief Returns what the last frame drew and holds
+ * @return The terrain counters
+ */
+TerrainStats PlanetTerrain::getStats() {
+    m_stats.chunksCached = m_lru.size();
+    m_stats.chunksBuilding = m_building;
+    return m_stats;
+}
+
+/**
+ * @brief Makes a chunk's grid and skirt, then noises them like noise.vert
+ * Grid vertices go along the face's first axis, then its second. The
+ * skirt is a copy of the border, counter clockwise from the first
+ * corner, pushed down toward the center.
+ * @param key The node to make
+ * @param seed The planet noise seed
+ * @param options The octaves and basis to noise with
+ * @param out Filled with NOISE_BAKED_FLOATS floats for each of TERRAIN_VERTICES vertices
+ */
+void PlanetTerrain::buildChunk(quint64 key, float seed, NoiseOptions options, std::vector<GLfloat> *out) {
+    int face = KEYFACE(key);
+    float size = 1.0f / (1 << KEYLEVEL(key));
+    float s0 = KEYX(key) * size, t0 = KEYY(key) * size;
+
+    std::vector<GLfloat> grid(TERRAIN_ROW*TERRAIN_ROW*NOISE_VERTEX_FLOATS);
+    for (int j = 0; j <= TERRAIN_QUADS; j++) {
+        for (int i = 0; i <= TERRAIN_QUADS; i++) {
+            glm::vec3 normal = cubeToSphere(face, s0 + size*i/TERRAIN_QUADS, t0 + size*j/TERRAIN_QUADS);
+            GLfloat *vertex = &grid[(j*TERRAIN_ROW + i)*NOISE_VERTEX_FLOATS];
+            for (int c = 0; c < 3; c++) {
+                vertex[c] = normal[c] * RADIUS;
+                vertex[3 + c] = normal[c];
+            }
+        }
+    }
+    out->resize(TERRAIN_VERTICES*NOISE_BAKED_FLOATS);
+    Noise::bakePlanet(&grid[0], TERRAIN_ROW*TERRAIN_ROW, seed, &(*out)[0], 1, options);
+
+    // Border vertices of each edge, in order around the chunk
+    float depth = TERRAIN_SKIRT * size * (float)M_PI / 2.0f * RADIUS;
+    for (int edge = 0; edge < 4; edge++) {
+        for (int k = 0; k <= TERRAIN_QUADS; k++) {
+            int i = edge == 0 ? k : edge == 1 ? TERRAIN_QUADS : edge == 2 ? TERRAIN_QUADS - k : 0;
+            int j = edge == 0 ? 0 : edge == 1 ? k : edge == 2 ? TERRAIN_QUADS : TERRAIN_QUADS - k;
+            const GLfloat *border = &(*out)[(j*TERRAIN_ROW + i)*NOISE_BAKED_FLOATS];
+            GLfloat *skirt = &(*out)[(TERRAIN_ROW*TERRAIN_ROW + edge*TERRAIN_ROW + k)*NOISE_BAKED_FLOATS];
+            glm::vec3 position(border[0], border[1], border[2]);
+            position -= glm::normalize(position) * depth;
+            skirt[0] = position.x;
+            skirt[1] = position.y;
+            skirt[2] = position.z;
+            skirt[3] = border[3];
+        }
+    }
+}
+
+/**
+ * @brief Maps a point on a cube face onto the unit sphere with an equal angle warp
+ * Each face's two axes are ordered so their cross product points out.
+ * @param face Positive then negative x, y, and z
+ * @param s The first coordinate on the face, in [0,1]
+ * @param t The second coordinate on the face, in [0,1]
+ * @return A unit vector
+ */
+glm::vec3 PlanetTerrain::cubeToSphere(int face, float s, float t) {
+    int axis = face / 2;
+    bool positive = face % 2 == 0;
+    glm::vec3 p;
+    p[axis] = positive ? 1.0f : -1.0f;
+    p[positive ? (axis + 1) % 3 : (axis + 2) % 3] = tan((s * 2.0f - 1.0f) * M_PI / 4.0f);
+    p[positive ? (axis + 2) % 3 : (axis + 1) % 3] = tan((t * 2.0f - 1.0f) * M_PI / 4.0f);
+    return glm::normalize(p);
+}
+
+/**
+ * @brief Queues a worker's chunk for upload - called from worker threads
+ * @param key The node that was made
+ * @param generation The terrain's generation when it was queued
+ * @param vertices The chunk's vertices, taken over
+ */
+void PlanetTerrain::finish(quint64 key, int generation, std::vector<GLfloat> &vertices) {
+    Finished result;
+    result.key = key;
+    result.generation = generation;
+    result.vertices.swap(vertices);
+    QMutexLocker lock(&m_mutex);
+    m_finished.append(result);
+}
+
+/**
+ * @brief Draws a node, or its children if it's too coarse and they're all ready
+ * Children that aren't ready are asked for, and the node draws itself meanwhile.
+ * Only called for nodes that are ready.
+ * @param key The node
+ * @param view The camera in the terrain's space
+ */
+void PlanetTerrain::drawNode(quint64 key, const View &view) {
+    float pixels;
+    if (!isVisible(key, m_chunks[key], view, &pixels)) return;
+
+    int level = KEYLEVEL(key);
+    if (level < TERRAIN_MAX_LEVEL && pixels > m_pixelsPerQuad) {
+        quint64 children[4];
+        bool ready = true;
+        for (int c = 0; c < 4; c++) {
+            children[c] = KEY(KEYVARIANT(key), KEYFACE(key), level + 1, KEYX(key)*2 + c % 2, KEYY(key)*2 + c / 2);
+            if (!isReady(children[c])) {
+                request(children[c]);
+                ready = false;
+            }
+        }
+        if (ready) {
+            use(&m_chunks[key]); // Keep the fallback around
+            for (int c = 0; c < 4; c++) drawNode(children[c], view);
+            return;
+        }
+    }
+    if (level > 0) m_splitDrawn++;
+    drawChunk(&m_chunks[key]);
+}
+
+/**
+ * @brief Checks if a node's chunk has been uploaded
+ * @param key The node
+ * @return If it can be drawn
+ */
+bool PlanetTerrain::isReady(quint64 key) {
+    QHash<quint64, Chunk>::iterator found = m_chunks.find(key);
+    return found != m_chunks.end() && found->vao != 0;
+}
+
+/**
+ * @brief Culls a node against the horizon and the view, and measures its quads on screen
+ * Bounds are a cone through the corners, between the chunk's lowest and
+ * highest vertex. Anything the lowest possible surface hides can't be seen.
+ * @param key The node
+ * @param chunk The node's uploaded chunk
+ * @param view The camera in the terrain's space
+ * @param pixels Set to about how many pixels a quad of the node spans
+ * @return If any of the node could be seen
+ */
+bool PlanetTerrain::isVisible(quint64 key, const Chunk &chunk, const View &view, float *pixels) {
+    int face = KEYFACE(key);
+    float size = 1.0f / (1 << KEYLEVEL(key));
+    float s0 = KEYX(key) * size, t0 = KEYY(key) * size;
+
+    glm::vec3 center = cubeToSphere(face, s0 + size*0.5f, t0 + size*0.5f);
+    float cosAngle = 1.0f;
+    for (int c = 0; c < 4; c++) {
+        cosAngle = glm::min(cosAngle, glm::dot(center, cubeToSphere(face, s0 + size*(c % 2), t0 + size*(c / 2))));
+    }
+    float angle = acos(glm::clamp(cosAngle, -1.0f, 1.0f));
+
+    // Past the horizon, even for the chunk's highest point
+    if (view.horizon >= 0) {
+        float fromEye = acos(glm::clamp(glm::dot(center, view.eye) / view.eyeDistance, -1.0f, 1.0f));
+        float pastHorizon = acos(glm::clamp(TERRAIN_MIN_RADIUS / chunk.maxRadius, -1.0f, 1.0f));
+        if (fromEye - angle > view.horizon + pastHorizon) return false;
+    }
+
+    // Bounding sphere around the patch between both radii - furthest at the cone's rim
+    float mid = (chunk.minRadius + chunk.maxRadius) * 0.5f;
+    glm::vec3 middle = center * mid;
+    float radius = sqrt(glm::max(chunk.maxRadius * (chunk.maxRadius - 2.0f * mid * cosAngle),
+                                 chunk.minRadius * (chunk.minRadius - 2.0f * mid * cosAngle)) + mid * mid);
+    for (int p = 0; p < 6; p++) {
+        if (glm::dot(glm::vec3(view.planes[p]), middle) + view.planes[p].w < -radius * glm::length(glm::vec3(view.planes[p]))) {
+            return false;
+        }
+    }
+
+    float distance = glm::max(glm::length(middle - view.eye) - radius, 1e-4f);
+    float quad = chunk.maxRadius * (float)M_PI / 2.0f * size / TERRAIN_QUADS;
+    *pixels = quad / distance * view.pixelScale;
+    return true;
+}
+
+/**
+ * @brief Queues a node to be made on a worker, unless it's already made or queued, or too much is
+ * Octaves follow the spacing of the node's quads on the unit sphere.
+ * @param key The node
+ */
+void PlanetTerrain::request(quint64 key) {
+    if (m_chunks.contains(key) || m_building >= TERRAIN_MAX_BUILDS) return;
+    m_chunks.insert(key, Chunk());
+    m_building++;
+    float spacing = (float)M_PI / 2.0f / (1 << KEYLEVEL(key)) / TERRAIN_QUADS;
+    NoiseOptions options = m_variants.at(KEYVARIANT(key)).optionsFor(spacing);
+    m_pool.start(new TerrainBuild(this, key, m_seed, options, m_generation));
+}
+
+/**
+ * @brief Moves a chunk to the front of the cache so it's evicted last
+ * @param chunk An uploaded chunk
+ */
+void PlanetTerrain::use(Chunk *chunk) {
+    chunk->lastUsed = m_frame;
+    m_lru.splice(m_lru.begin(), m_lru, chunk->lru);
+}
+
+/**
+ * @brief Draws a chunk with the shared indices and marks it as used
+ * @param chunk An uploaded chunk
+ */
+void PlanetTerrain::drawChunk(Chunk *chunk) {
+    use(chunk);
+    glBindVertexArray(chunk->vao);
+    glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, (void*)0);
+    glBindVertexArray(0);
+    m_stats.chunksDrawn++;
+    m_stats.verticesDrawn += TERRAIN_VERTICES;
+}
+
+/**
+ * @brief Makes the triangles every chunk shares: the grid, then the skirt walls
+ * Both are counter clockwise seen from outside, with the walls facing away
+ * from the chunk so whichever side of a crack is seen covers it.
+ */
+void PlanetTerrain::createIndices() {
+    std::vector<GLuint> indices;
+    for (int j = 0; j < TERRAIN_QUADS; j++) {
+        for (int i = 0; i < TERRAIN_QUADS; i++) {
+            GLuint corner = j*TERRAIN_ROW + i;
+            GLuint quad[6] = { corner, corner + 1, corner + TERRAIN_ROW + 1,
+                               corner, corner + TERRAIN_ROW + 1, corner + TERRAIN_ROW };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+    for (int edge = 0; edge < 4; edge++) {
+        for (int k = 0; k < TERRAIN_QUADS; k++) {
+            int i[2], j[2];
+            for (int n = 0; n < 2; n++) {
+                int m = k + n;
+                i[n] = edge == 0 ? m : edge == 1 ? TERRAIN_QUADS : edge == 2 ? TERRAIN_QUADS - m : 0;
+                j[n] = edge == 0 ? 0 : edge == 1 ? m : edge == 2 ? TERRAIN_QUADS : TERRAIN_QUADS - m;
+            }
+            GLuint a = j[0]*TERRAIN_ROW + i[0], b = j[1]*TERRAIN_ROW + i[1];
+            GLuint skirtA = TERRAIN_ROW*TERRAIN_ROW + edge*TERRAIN_ROW + k, skirtB = skirtA + 1;
+            GLuint wall[6] = { a, skirtA, b, b, skirtA, skirtB };
+            indices.insert(indices.end(), wall, wall + 6);
+        }
+    }
+
+    m_indexCount = indices.size();
+    glGenBuffers(1, &m_indices);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indices);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexCount*sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/**
+ * @brief Deletes every chunk's buffers and forgets them
+ */
+void PlanetTerrain::deleteChunks() {
+    for (QHash<quint64, Chunk>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it) {
+        if (it->vao != 0) glDeleteVertexArrays(1, &it->vao);
+        if (it->vbo != 0) glDeleteBuffers(1, &it->vbo);
+    }
+    m_chunks.clear();
+    m_lru.clear();
+}
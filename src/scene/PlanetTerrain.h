@@ -0,0 +1,130 @@
+#ifndef PLANETTERRAIN_H
+#define PLANETTERRAIN_H
+
+#include "GLCommon.h"
+#include "PlanetDataParser.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <list>
+
+/**
+ * @brief What the terrain drew and holds in one frame
+ */
+struct TerrainStats {
+    TerrainStats() : chunksDrawn(0), verticesDrawn(0), chunksCached(0), chunksBuilding(0) {}
+
+    int chunksDrawn;
+    int verticesDrawn;
+    int chunksCached; // Uploaded chunks kept for reuse
+    int chunksBuilding; // Chunks queued or being made on worker threads
+};
+
+/**
+ * @brief Planet surface as a cube sphere quadtree of noised chunks
+ * Each cube face is a quadtree, and every node is a grid of quads warped
+ * onto the sphere with the same noise as the baked meshes. Nodes split
+ * while their quads would be too big on screen, and nodes past the
+ * horizon or outside the view aren't drawn at all. Chunks are made on
+ * worker threads and uploaded a few per frame, and a node keeps drawing
+ * itself until all its children are ready, so nothing ever waits. Skirts
+ * hang off every chunk edge to hide cracks between different levels.
+ * If a frame draws more chunks than the budget, nodes split less eagerly
+ * until it's back under.
+ * The noise only depends on the position on the unit sphere, the seed,
+ * and the planet's noise settings, so planets with the same settings share
+ * chunks. Deeper levels have their vertices closer together, so they're
+ * made with more octaves.
+ */
+class PlanetTerrain {
+public:
+    PlanetTerrain();
+    ~PlanetTerrain();
+
+    // Forgets every chunk and starts making them with a new seed
+    void reset(float seed);
+
+    // Uploads finished chunks and evicts old ones - once per frame, before draw()
+    void beginFrame(GLuint drawShader);
+
+    // Draws one planet, given how its local space is seen - false if it isn't ready yet
+    bool draw(const glm::mat4 &modelView, const glm::mat4 &projection, float height, const PlanetNoise &noise);
+
+    TerrainStats getStats();
+
+private:
+    friend class TerrainBuild;
+
+    /**
+     * @brief A drawable chunk, or one still being made if vao is 0
+     */
+    struct Chunk {
+        Chunk() : vao(0), vbo(0), minRadius(0), maxRadius(0), lastUsed(0) {}
+
+        GLuint vao;
+        GLuint vbo;
+        float minRadius; // How far its vertices are from the center, once uploaded
+        float maxRadius;
+        int lastUsed; // Frame it was last drawn or needed in
+        std::list<quint64>::iterator lru; // Place in m_lru once uploaded
+    };
+
+    /**
+     * @brief Vertices a worker made for a chunk, waiting to be uploaded
+     */
+    struct Finished {
+        quint64 key;
+        int generation;
+        std::vector<GLfloat> vertices;
+    };
+
+    /**
+     * @brief Everything about the camera a node needs to be culled and measured, in planet space
+     */
+    struct View {
+        glm::vec3 eye;
+        float eyeDistance;
+        float horizon; // Angle from the eye direction where the lowest possible surface ends
+        glm::vec4 planes[6];
+        float pixelScale; // Turns size over distance into pixels
+    };
+
+    PlanetTerrain(const PlanetTerrain &);
+    PlanetTerrain &operator=(const PlanetTerrain &);
+
+    // Chunk making, on worker threads
+    static void buildChunk(quint64 key, float seed, NoiseOptions options, std::vector<GLfloat> *out);
+    static glm::vec3 cubeToSphere(int face, float s, float t);
+    void finish(quint64 key, int generation, std::vector<GLfloat> &vertices);
+
+    // Quadtree traversal, on the GL thread
+    void drawNode(quint64 key, const View &view);
+    bool isReady(quint64 key);
+    bool isVisible(quint64 key, const Chunk &chunk, const View &view, float *pixels);
+    void request(quint64 key);
+    void use(Chunk *chunk);
+    void drawChunk(Chunk *chunk);
+
+    void createIndices();
+    void deleteChunks();
+
+    QThreadPool m_pool;
+    QMutex m_mutex; // Guards m_finished
+    QList<Finished> m_finished;
+
+    QList<PlanetNoise> m_variants; // Noise settings seen so far - their index is part of each key
+    QHash<quint64, Chunk> m_chunks;
+    std::list<quint64> m_lru; // Uploaded chunks, most recently used first
+    GLuint m_indices; // Same triangles for every chunk
+    int m_indexCount;
+    float m_seed;
+    int m_generation; // Bumped by reset() so old builds are thrown away
+    int m_building;
+    int m_frame;
+    float m_pixelsPerQuad; // Split threshold, raised while over the chunk budget
+    int m_splitDrawn; // Chunks below face level drawn this frame, which the threshold can cut
+    TerrainStats m_stats;
+};
+
+#endif // PLANETTERRAIN_H
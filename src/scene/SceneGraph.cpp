@@ -0,0 +1,153 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+
+/**
+ * @brief Starts out empty
+ */
+SceneGraph::SceneGraph() : m_unsorted(false), m_lastUpdated(0) {}
+
+/**
+ * @brief Drops every node - every handle given out so far stops meaning anything
+ */
+void SceneGraph::clear() {
+    m_nodes.clear();
+    m_index.clear();
+    m_parents.clear();
+    m_unsorted = false;
+    m_lastUpdated = 0;
+}
+
+/**
+ * @brief Adds a node, to be put in depth order on the next update
+ * @param parent The parent's handle, or SCENE_NO_PARENT for a root
+ * @param local The node's transform relative to its parent
+ * @return The new node's handle, one more than the last one added
+ */
+SceneHandle SceneGraph::add(SceneHandle parent, const glm::mat4 &local) {
+    SceneHandle handle = m_index.size();
+    SceneNode node;
+    node.local = local;
+    node.world = local;
+    node.parent = parent == SCENE_NO_PARENT ? SCENE_NO_PARENT : m_index[parent];
+    node.handle = handle;
+    node.dirty = true;
+
+    // Depth order holds as long as the parent is the last node or one of its ancestors
+    if (parent != SCENE_NO_PARENT && !m_unsorted) {
+        int i = m_nodes.size() - 1;
+        while (i != SCENE_NO_PARENT && i != node.parent) i = m_nodes[i].parent;
+        if (i == SCENE_NO_PARENT) m_unsorted = true;
+    }
+
+    m_index.push_back(m_nodes.size());
+    m_parents.push_back(parent);
+    m_nodes.push_back(node);
+    return handle;
+}
+
+/**
+ * @brief Changes a node's transform, so it and everything under it is redone on update
+ * @param node The node's handle
+ * @param local The node's new transform relative to its parent
+ */
+void SceneGraph::setLocal(SceneHandle node, const glm::mat4 &local) {
+    SceneNode &n = m_nodes[m_index[node]];
+    n.local = local;
+    n.dirty = true;
+}
+
+/**
+ * @brief Works out world transforms, parents before their children
+ * A node is redone if it's dirty or its parent was just redone, and
+ * parents always come first, so one pass in order covers every change.
+ * @return How many nodes were redone
+ */
+int SceneGraph::update() {
+    if (m_unsorted) sortNodes();
+    m_changed.resize(m_nodes.size());
+    m_lastUpdated = 0;
+    for (size_t i = 0; i < m_nodes.size(); i++) {
+        SceneNode &node = m_nodes[i];
+        bool changed = node.dirty || (node.parent != SCENE_NO_PARENT && m_changed[node.parent]);
+        m_changed[i] = changed;
+        if (!changed) continue;
+        node.world = node.parent == SCENE_NO_PARENT ? node.local : m_nodes[node.parent].world * node.local;
+        node.dirty = false;
+        m_lastUpdated++;
+    }
+    return m_lastUpdated;
+}
+
+/**
+ * @brief Puts the nodes back in depth order, with siblings in the order they were added
+ * Every node keeps its handle, and nodes keep whether they're dirty.
+ */
+void SceneGraph::sortNodes() {
+    int count = m_nodes.size();
+
+    // Children of each handle as linked lists, built backwards so they come out in handle order
+    std::vector<SceneHandle> firstChild(count, SCENE_NO_PARENT), nextSibling(count, SCENE_NO_PARENT);
+    std::vector<SceneHandle> stack;
+    for (int h = count - 1; h >= 0; h--) {
+        if (m_parents[h] == SCENE_NO_PARENT) {
+            stack.push_back(h);
+        } else {
+            nextSibling[h] = firstChild[m_parents[h]];
+            firstChild[m_parents[h]] = h;
+        }
+    }
+
+    // Depth first from every root, in handle order - parents are placed before they're looked up
+    std::vector<SceneNode> sorted;
+    sorted.reserve(count);
+    while (!stack.empty()) {
+        SceneHandle h = stack.back();
+        stack.pop_back();
+        SceneNode node = m_nodes[m_index[h]];
+        node.parent = m_parents[h] == SCENE_NO_PARENT ? SCENE_NO_PARENT : m_index[m_parents[h]];
+        m_index[h] = sorted.size();
+        sorted.push_back(node);
+
+        // Pushed last child first, so the first child comes off next
+        int children = stack.size();
+        for (SceneHandle c = firstChild[h]; c != SCENE_NO_PARENT; c = nextSibling[c]) stack.push_back(c);
+        std::reverse(stack.begin() + children, stack.end());
+    }
+    m_nodes.swap(sorted);
+    m_unsorted = false;
+}
+
+/**
+ * @brief Returns a node's transform in world space
+ * @param node The node's handle
+ * @return The world transform worked out by the last update
+ */
+const glm::mat4 &SceneGraph::getWorld(SceneHandle node) const {
+    return m_nodes[m_index[node]].world;
+}
+
+/**
+ * @brief Returns a node's transform relative to its parent
+ * @param node The node's handle
+ * @return The last local transform set
+ */
+const glm::mat4 &SceneGraph::getLocal(SceneHandle node) const {
+    return m_nodes[m_index[node]].local;
+}
+
+/**
+ * @brief Returns how many nodes the graph has
+ * @return The node count
+ */
+int SceneGraph::getNodeCount() const {
+    return m_nodes.size();
+}
+
+/**
+ * @brief Returns how many world transforms the last update worked out
+ * @return The nodes redone
+ */
+int SceneGraph::getLastUpdated() const {
+    return m_lastUpdated;
+}
@@ -0,0 +1,68 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include "GLCommon.h"
+#include <vector>
+
+#define SCENE_NO_PARENT -1 // Parent of a root node
+
+/**
+ * @brief Stands for a node for as long as the graph isn't cleared
+ * Handles are handed out in order from 0, so nodes added one after
+ * another get handles one after another.
+ */
+typedef int SceneHandle;
+
+/**
+ * @brief A transform in the graph, stored in depth order
+ */
+struct SceneNode {
+    glm::mat4 local; // Relative to the parent
+    glm::mat4 world; // parent's world * local, as of the last update
+    int parent; // Index of the parent in depth order, SCENE_NO_PARENT for roots
+    SceneHandle handle; // Which handle points here
+    bool dirty; // If local changed since the last update
+};
+
+/**
+ * @brief Parent and child transforms, with world transforms cached
+ * Nodes live in one array in depth order, so every parent comes before
+ * its children and an update is one pass down the array. Only nodes whose
+ * own local transform changed, or whose parent's world did, are worked
+ * out again - a paused scene recomputes nothing. Nodes can be added in
+ * any order; the array is put back into depth order on the next update,
+ * and handles keep pointing at the same node throughout.
+ */
+class SceneGraph {
+public:
+    SceneGraph();
+
+    // Drops every node, so every handle
+    void clear();
+
+    // Adds a node under parent (or as a root), with the new node's handle back
+    SceneHandle add(SceneHandle parent, const glm::mat4 &local = glm::mat4(1.0f));
+    void setLocal(SceneHandle node, const glm::mat4 &local);
+
+    // Works out every world transform that changed, giving back how many
+    int update();
+
+    // Only up to date after update
+    const glm::mat4 &getWorld(SceneHandle node) const;
+    const glm::mat4 &getLocal(SceneHandle node) const;
+
+    int getNodeCount() const;
+    int getLastUpdated() const;
+
+private:
+    void sortNodes();
+
+    std::vector<SceneNode> m_nodes; // Depth order, once sorted
+    std::vector<int> m_index; // Where each handle's node is in m_nodes
+    std::vector<SceneHandle> m_parents; // Each handle's parent handle, for sorting
+    std::vector<char> m_changed; // If each node's world changed this update, scratch
+    bool m_unsorted; // If nodes were added since the last sort
+    int m_lastUpdated; // Nodes the last update worked out
+};
+
+#endif // SCENEGRAPH_H
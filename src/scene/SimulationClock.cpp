@@ -0,0 +1,115 @@
+#include "SimulationClock.h"
+
+/**
+ * @brief Sets up a clock at time 0, running at normal speed
+ * @param step Simulation ms per fixed step
+ * @param maxSteps The most steps one call to advance can ask for
+ */
+SimulationClock::SimulationClock(float step, int maxSteps)
+    : m_step(step), m_maxSteps(maxSteps), m_multiplier(1.0f), m_paused(false) {
+    reset();
+}
+
+/**
+ * @brief Goes back to time 0 with nothing accumulated
+ */
+void SimulationClock::reset() {
+    m_accumulator = 0;
+    m_steps = 0;
+}
+
+/**
+ * @brief Adds real time to the accumulator and takes out whole steps
+ * If more than maxSteps are owed, the extra time is dropped so the
+ * simulation slows down instead of falling further behind.
+ * @param realMs Real milliseconds since the last call
+ * @return How many fixed steps the simulation should take now
+ */
+int SimulationClock::advance(float realMs) {
+    if (m_paused || realMs <= 0) return 0;
+    m_accumulator += realMs * m_multiplier;
+
+    int steps = 0;
+    while (m_accumulator >= m_step && steps < m_maxSteps) {
+        m_accumulator -= m_step;
+        steps++;
+    }
+    if (steps == m_maxSteps && m_accumulator >= m_step) {
+        m_accumulator -= m_step * (int)(m_accumulator / m_step);
+    }
+
+    m_steps += steps;
+    return steps;
+}
+
+/**
+ * @brief Sets how many simulation ms pass per real ms
+ * @param multiplier The new multiplier
+ */
+void SimulationClock::setMultiplier(float multiplier) {
+    m_multiplier = multiplier;
+}
+
+/**
+ * @brief Returns the speed multiplier
+ * @return m_multiplier
+ */
+float SimulationClock::getMultiplier() {
+    return m_multiplier;
+}
+
+/**
+ * @brief Stops or restarts time - nothing accumulates while paused
+ * @param paused If the clock should be paused
+ */
+void SimulationClock::setPaused(bool paused) {
+    m_paused = paused;
+}
+
+/**
+ * @brief Returns if the clock is paused
+ * @return m_paused
+ */
+bool SimulationClock::isPaused() {
+    return m_paused;
+}
+
+/**
+ * @brief Returns the length of one step
+ * @return Simulation ms per step
+ */
+float SimulationClock::getStep() {
+    return m_step;
+}
+
+/**
+ * @brief Returns simulation time as of the last step
+ * @return Simulation ms since reset
+ */
+float SimulationClock::getTime() {
+    return m_steps * (double)m_step;
+}
+
+/**
+ * @brief Returns simulation time between the last step and the next one
+ * @return Simulation ms since reset, plus what's accumulated
+ */
+float SimulationClock::getInterpolatedTime() {
+    return (m_steps + (double)getAlpha()) * m_step;
+}
+
+/**
+ * @brief Returns how far between the last step and the next one we are
+ * @return A float in [0,1)
+ */
+float SimulationClock::getAlpha() {
+    return m_accumulator / m_step;
+}
+
+/**
+ * @brief Returns the number of steps since reset
+ * @return m_steps
+ */
+unsigned long long SimulationClock::getStepCount() {
+    return m_steps;
+}
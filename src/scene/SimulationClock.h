@@ -0,0 +1,42 @@
+#ifndef SIMULATIONCLOCK_H
+#define SIMULATIONCLOCK_H
+
+/**
+ * @brief Fixed timestep clock for the simulation
+ * Real time goes into an accumulator (scaled by the speed multiplier)
+ * and comes out as a whole number of fixed steps, so the simulation
+ * advances the same way no matter how fast frames are drawn. What's
+ * left over in the accumulator gives an interpolation factor to draw
+ * between the last two steps.
+ */
+class SimulationClock {
+public:
+    SimulationClock(float step = 1000.0f / 60.0f, int maxSteps = 240);
+
+    // Adds real ms and gives back how many fixed steps to run now
+    int advance(float realMs);
+    void reset();
+
+    // Speed and pausing
+    void setMultiplier(float multiplier);
+    float getMultiplier();
+    void setPaused(bool paused);
+    bool isPaused();
+
+    // Time queries
+    float getStep();
+    float getTime();
+    float getInterpolatedTime();
+    float getAlpha();
+    unsigned long long getStepCount();
+
+private:
+    float m_step; // Simulation ms per step
+    int m_maxSteps; // Most steps per advance, so slow frames can't snowball
+    float m_accumulator; // Simulation ms not yet stepped
+    float m_multiplier;
+    bool m_paused;
+    unsigned long long m_steps; // Steps taken since reset
+};
+
+#endif // SIMULATIONCLOCK_H
@@ -0,0 +1,205 @@
+#include "SkyGrid.h"
+#include "Parallel.h"
+
+#include <math.h>
+#include <algorithm>
+
+#define NUMFACES 6
+#define HULLPOINTS 8
+
+/**
+ * @brief Sets up an empty grid
+ * @param tilesPerEdge Tiles along each edge of each cube face
+ */
+SkyGrid::SkyGrid(int tilesPerEdge) : m_tilesPerEdge(tilesPerEdge), m_tilesDrawn(0) {}
+
+/**
+ * @brief Returns the number of tiles over the whole sky
+ * @return Tiles on all six faces
+ */
+int SkyGrid::getTileCount() {
+    return NUMFACES * m_tilesPerEdge * m_tilesPerEdge;
+}
+
+/**
+ * @brief Finds which tile a position falls in, by direction from the center
+ * @param pos Any nonzero position
+ * @return An index in [0, getTileCount())
+ */
+int SkyGrid::tileOf(glm::vec3 pos) {
+    glm::vec3 a = glm::abs(pos);
+    int face;
+    float u, v, major;
+    if (a.x >= a.y && a.x >= a.z) {
+        face = pos.x > 0 ? 0 : 1;
+        major = a.x; u = pos.y; v = pos.z;
+    } else if (a.y >= a.z) {
+        face = pos.y > 0 ? 2 : 3;
+        major = a.y; u = pos.x; v = pos.z;
+    } else {
+        face = pos.z > 0 ? 4 : 5;
+        major = a.z; u = pos.x; v = pos.y;
+    }
+
+    // atan evens out how much sky each tile covers, then [-1,1] -> [0,tilesPerEdge)
+    float warpU = atan(u / major) * 4.0f / M_PI;
+    float warpV = atan(v / major) * 4.0f / M_PI;
+    int i = std::min(m_tilesPerEdge - 1, std::max(0, (int)((warpU + 1.0f) * 0.5f * m_tilesPerEdge)));
+    int j = std::min(m_tilesPerEdge - 1, std::max(0, (int)((warpV + 1.0f) * 0.5f * m_tilesPerEdge)));
+    return (face * m_tilesPerEdge + j) * m_tilesPerEdge + i;
+}
+
+/**
+ * @brief Reorders stars so each tile's stars are together and bounds each tile
+ * @param stars floatsPerStar floats per star, starting with its position - sorted in place
+ * @param floatsPerStar How many floats make up one star
+ * @param margin Added to every radius, for how big a star is drawn
+ */
+void SkyGrid::build(std::vector<float> &stars, int floatsPerStar, float margin) {
+    int numStars = stars.size() / floatsPerStar;
+    int numTiles = getTileCount();
+
+    // Counting sort by tile, finding tiles on every core
+    std::vector<int> tiles(numStars);
+    parallelFor(numStars, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            tiles[i] = tileOf(glm::vec3(stars[i*floatsPerStar], stars[i*floatsPerStar + 1], stars[i*floatsPerStar + 2]));
+        }
+    });
+    m_tileStart.assign(numTiles + 1, 0);
+    for (int i = 0; i < numStars; i++) m_tileStart[tiles[i] + 1]++;
+    for (int t = 0; t < numTiles; t++) m_tileStart[t + 1] += m_tileStart[t];
+
+    std::vector<int> next(m_tileStart.begin(), m_tileStart.end() - 1);
+    std::vector<float> sorted(stars.size());
+    for (int i = 0; i < numStars; i++) {
+        std::copy(&stars[i*floatsPerStar], &stars[i*floatsPerStar] + floatsPerStar,
+                  &sorted[next[tiles[i]]++ * floatsPerStar]);
+    }
+    stars.swap(sorted);
+
+    // Bounding hull of each tile's wedge of the shell, a few tiles per thread
+    m_hulls.assign(numTiles * HULLPOINTS, glm::vec3(0));
+    parallelFor(numTiles, [&](int begin, int end) {
+        for (int t = begin; t < end; t++) {
+            if (m_tileStart[t] == m_tileStart[t + 1]) continue;
+            float inner = INFINITY, outer = 0;
+            for (int i = m_tileStart[t]; i < m_tileStart[t + 1]; i++) {
+                float radius = glm::length(glm::vec3(stars[i*floatsPerStar], stars[i*floatsPerStar + 1], stars[i*floatsPerStar + 2]));
+                inner = std::min(inner, radius);
+                outer = std::max(outer, radius);
+            }
+            buildHull(t, std::max(0.0f, inner - margin), outer + margin, margin);
+        }
+    }, std::min(parallelThreadCount(), numTiles));
+}
+
+/**
+ * @brief Finds 8 points whose hull holds everything in a tile between two radii
+ * The tile is a cone out of the center with four flat sides. Cutting it
+ * with two planes across its axis - one inside the inner radius, one
+ * outside the outer - leaves a convex shape with the 4 + 4 corners.
+ * @param tile The index of the tile
+ * @param inner The smallest radius of anything in it
+ * @param outer The largest radius of anything in it
+ * @param margin How far to push the sides out, for how big a star is drawn
+ */
+void SkyGrid::buildHull(int tile, float inner, float outer, float margin) {
+    int face = tile / (m_tilesPerEdge * m_tilesPerEdge);
+    int j = (tile / m_tilesPerEdge) % m_tilesPerEdge;
+    int i = tile % m_tilesPerEdge;
+
+    // Corner directions, undoing the atan warp from tileOf
+    glm::vec3 corners[4];
+    glm::vec3 axis(0);
+    for (int k = 0; k < 4; k++) {
+        float u = tan(((i + (k & 1)) * 2.0f / m_tilesPerEdge - 1.0f) * M_PI / 4.0f);
+        float v = tan(((j + (k >> 1)) * 2.0f / m_tilesPerEdge - 1.0f) * M_PI / 4.0f);
+        float sign = face % 2 == 0 ? 1.0f : -1.0f;
+        if (face < 2) corners[k] = glm::vec3(sign, u, v);
+        else if (face < 4) corners[k] = glm::vec3(u, sign, v);
+        else corners[k] = glm::vec3(u, v, sign);
+        corners[k] = glm::normalize(corners[k]);
+        axis += corners[k];
+    }
+    axis = glm::normalize(axis);
+
+    float minDot = 1.0f;
+    for (int k = 0; k < 4; k++) minDot = std::min(minDot, glm::dot(corners[k], axis));
+
+    // Points along each corner where it crosses the near and far planes
+    float nearDepth = inner * minDot;
+    float farDepth = outer;
+    for (int k = 0; k < 4; k++) {
+        float along = glm::dot(corners[k], axis);
+        glm::vec3 nearPoint = corners[k] * (nearDepth / along);
+        glm::vec3 farPoint = corners[k] * (farDepth / along);
+        glm::vec3 out = glm::normalize(corners[k] - axis * along) * margin;
+        m_hulls[tile * HULLPOINTS + k] = nearPoint + out;
+        m_hulls[tile * HULLPOINTS + 4 + k] = farPoint + out;
+    }
+}
+
+/**
+ * @brief Culls every tile against the view frustum and the eye's half of the sky
+ * Neighboring tiles that survive are merged into one range.
+ * @param clip Takes star positions to clip space (projection * view * sky rotation)
+ * @param eye The eye direction in star space - stars with dot(eye, pos) >= 0 aren't drawn
+ * @param ranges Filled in with (first star, count) for each run of visible tiles
+ * @return The total number of stars in all ranges
+ */
+int SkyGrid::cull(const glm::mat4 &clip, glm::vec3 eye, std::vector<glm::ivec2> *ranges) {
+    // Frustum planes straight out of the matrix, pointing inwards
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; r++) rows[r] = glm::vec4(clip[0][r], clip[1][r], clip[2][r], clip[3][r]);
+    glm::vec4 planes[6] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+                            rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2] };
+
+    ranges->clear();
+    m_tilesDrawn = 0;
+    int numStars = 0;
+    int numTiles = m_tileStart.size() - 1;
+    for (int t = 0; t < numTiles; t++) {
+        int count = m_tileStart[t + 1] - m_tileStart[t];
+        if (count == 0 || !isVisible(t, planes, eye)) continue;
+
+        if (!ranges->empty() && ranges->back().x + ranges->back().y == m_tileStart[t]) ranges->back().y += count;
+        else ranges->push_back(glm::ivec2(m_tileStart[t], count));
+        numStars += count;
+        m_tilesDrawn++;
+    }
+    return numStars;
+}
+
+/**
+ * @brief Returns how many tiles survived the last cull
+ * @return m_tilesDrawn
+ */
+int SkyGrid::getTilesDrawn() {
+    return m_tilesDrawn;
+}
+
+/**
+ * @brief Tests one tile's hull - it's culled if every point is outside the same plane
+ * @param tile The index of the tile
+ * @param planes The six frustum planes
+ * @param eye The eye direction in star space
+ * @return If any of the tile might be drawn
+ */
+bool SkyGrid::isVisible(int tile, const glm::vec4 *planes, glm::vec3 eye) {
+    const glm::vec3 *hull = &m_hulls[tile * HULLPOINTS];
+
+    // Entirely on the eye's side of the sky
+    bool eyeSide = true;
+    for (int k = 0; k < HULLPOINTS && eyeSide; k++) eyeSide = glm::dot(eye, hull[k]) >= 0;
+    if (eyeSide) return false;
+
+    for (int p = 0; p < 6; p++) {
+        bool outside = true;
+        for (int k = 0; k < HULLPOINTS && outside; k++) {
+            outside = glm::dot(glm::vec3(planes[p]), hull[k]) + planes[p].w < 0;
+        }
+        if (outside) return false;
+    }
+    return true;
+}
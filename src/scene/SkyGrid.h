@@ -0,0 +1,39 @@
+#ifndef SKYGRID_H
+#define SKYGRID_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+/**
+ * @brief Splits the star shell into tiles so whole tiles can be culled
+ * Directions are put on one of the six faces of a cube, and each face
+ * is cut into tilesPerEdge x tilesPerEdge tiles. Face coordinates are
+ * warped by atan first so tiles cover close to the same area of sky.
+ * Stars are sorted by tile, so every tile (and every run of neighboring
+ * tiles) is one contiguous range of instances.
+ */
+class SkyGrid {
+public:
+    SkyGrid(int tilesPerEdge = 8);
+
+    int getTileCount();
+    int tileOf(glm::vec3 pos);
+
+    // Sorts stars by tile and bounds each tile
+    void build(std::vector<float> &stars, int floatsPerStar, float margin);
+
+    // Gives back ranges of stars (first, count) in tiles that might be seen
+    int cull(const glm::mat4 &clip, glm::vec3 eye, std::vector<glm::ivec2> *ranges);
+    int getTilesDrawn();
+
+private:
+    void buildHull(int tile, float inner, float outer, float margin);
+    bool isVisible(int tile, const glm::vec4 *planes, glm::vec3 eye);
+
+    int m_tilesPerEdge;
+    std::vector<int> m_tileStart; // First star of each tile, plus one past the end
+    std::vector<glm::vec3> m_hulls; // 8 points around each tile
+    int m_tilesDrawn; // Tiles that survived the last cull
+};
+
+#endif // SKYGRID_H
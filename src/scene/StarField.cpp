@@ -0,0 +1,287 @@
+#include "StarField.h"
+#include "GLMath.h"
+#include "SIMD.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Every array is padded to a multiple of this many floats and aligned to it
+#define STARFIELD_ALIGN 8
+#define STARFIELD_ARRAYS 8
+
+#ifdef SIMD_WIDTH
+/**
+ * @brief hashN for SIMD_WIDTH ints at once
+ * @param x Any unsigned ints
+ * @return Well mixed unsigned ints
+ */
+static inline vint vhash(vint x) {
+    x = vixor(x, vishift16(x));
+    x = vimul(x, viset1(0x7feb352dU));
+    x = vixor(x, vishift15(x));
+    x = vimul(x, viset1(0x846ca68bU));
+    x = vixor(x, vishift16(x));
+    return x;
+}
+
+/**
+ * @brief hashRandN for SIMD_WIDTH indices at once
+ * @param seed The seed, in every lane
+ * @param i The indices
+ * @param hashedN hashN of the counter, in every lane
+ * @return Floats in [0,1)
+ */
+static inline vfloat vhashRand(vint seed, vint i, vint hashedN) {
+    vint h = vhash(vixor(seed, vhash(vixor(i, hashedN))));
+    return vmul(vitof(vishift8(h)), vset1(1.0f / 16777216.0f));
+}
+#endif
+
+/**
+ * @brief Starts out empty
+ */
+StarField::StarField() : m_count(0), m_capacity(0), m_block(NULL) {
+    m_posX = m_posY = m_posZ = m_life = NULL;
+    m_dirX = m_dirY = m_dirZ = m_decay = NULL;
+}
+
+/**
+ * @brief Frees all arrays
+ */
+StarField::~StarField() {
+#ifdef SIMD_WIDTH
+    if (m_block) _mm_free(m_block);
+#else
+    free(m_block);
+#endif
+}
+
+/**
+ * @brief Makes room for count stars, all zeroed
+ * @param count The number of stars
+ */
+void StarField::resize(int count) {
+    m_count = count;
+    if (count > m_capacity) {
+        m_capacity = (count + STARFIELD_ALIGN - 1) / STARFIELD_ALIGN * STARFIELD_ALIGN;
+        size_t bytes = STARFIELD_ARRAYS * m_capacity * sizeof(float);
+#ifdef SIMD_WIDTH
+        if (m_block) _mm_free(m_block);
+        m_block = (float *)_mm_malloc(bytes, STARFIELD_ALIGN * sizeof(float));
+#else
+        free(m_block);
+        m_block = (float *)malloc(bytes);
+#endif
+        float **arrays[STARFIELD_ARRAYS] = { &m_posX, &m_posY, &m_posZ, &m_life,
+                                             &m_dirX, &m_dirY, &m_dirZ, &m_decay };
+        for (int a = 0; a < STARFIELD_ARRAYS; a++) *arrays[a] = m_block + a * m_capacity;
+    }
+    memset(m_block, 0, STARFIELD_ARRAYS * m_capacity * sizeof(float));
+}
+
+/**
+ * @brief Returns the number of stars
+ * @return m_count
+ */
+int StarField::size() {
+    return m_count;
+}
+
+/**
+ * @brief Overwrites one star
+ * @param i The index of the star
+ * @param star What to write there
+ */
+void StarField::set(int i, const Star &star) {
+    m_posX[i] = star.pos.x;
+    m_posY[i] = star.pos.y;
+    m_posZ[i] = star.pos.z;
+    m_life[i] = star.life;
+    m_dirX[i] = star.dir.x;
+    m_dirY[i] = star.dir.y;
+    m_dirZ[i] = star.dir.z;
+    m_decay[i] = star.decay;
+}
+
+/**
+ * @brief Reads one star back
+ * @param i The index of the star
+ * @return A copy of the star
+ */
+Star StarField::get(int i) {
+    Star star;
+    star.pos = glm::vec3(m_posX[i], m_posY[i], m_posZ[i]);
+    star.life = m_life[i];
+    star.dir = glm::vec3(m_dirX[i], m_dirY[i], m_dirZ[i]);
+    star.decay = m_decay[i];
+    return star;
+}
+
+/**
+ * @brief Moves and fades every star by one step
+ * Life bounces between 0 and maxLife by flipping decay. Shooting stars
+ * that fade out respawn from hashRandN(seed, i, stepCount*3 + axis), the
+ * same numbers starSim.vert uses.
+ * @param maxLife The life stars bounce back from
+ * @param spread How far out on each axis shooting stars can respawn
+ * @param seed Seed for respawning
+ * @param stepCount Steps taken so far
+ */
+void StarField::step(float maxLife, float spread, unsigned int seed, unsigned int stepCount) {
+    int simdEnd = 0;
+#ifdef SIMD_WIDTH
+    simdEnd = m_count - m_count % SIMD_WIDTH;
+    const vfloat zero = vset1(0.0f);
+    const vfloat signBit = vset1(-0.0f);
+    const vfloat vmaxLife = vset1(maxLife);
+    const vfloat low = vset1(-spread);
+    const vfloat range = vset1(2.0f * spread);
+    const vint vseed = viset1(seed);
+    const unsigned int n = stepCount * 3;
+    const vint hashedN[3] = { viset1(hashN(n)), viset1(hashN(n + 1)), viset1(hashN(n + 2)) };
+
+    for (int i = 0; i < simdEnd; i += SIMD_WIDTH) {
+        vfloat dirX = vload(m_dirX + i);
+        vfloat dirY = vload(m_dirY + i);
+        vfloat dirZ = vload(m_dirZ + i);
+        vfloat posX = vadd(vload(m_posX + i), dirX);
+        vfloat posY = vadd(vload(m_posY + i), dirY);
+        vfloat posZ = vadd(vload(m_posZ + i), dirZ);
+        vfloat decay = vload(m_decay + i);
+        vfloat life = vadd(vload(m_life + i), decay);
+
+        // Flip the sign of decay wherever life went out of range
+        vfloat dead = vle(life, zero);
+        vfloat bounce = vor(dead, vge(life, vmaxLife));
+        vstore(m_decay + i, vxor(decay, vand(bounce, signBit)));
+        vstore(m_life + i, life);
+
+        // Rare, so only hash when some lane actually needs it
+        vfloat speed = vadd(vadd(vmul(dirX, dirX), vmul(dirY, dirY)), vmul(dirZ, dirZ));
+        vfloat respawn = vand(dead, vgt(speed, zero));
+        if (vmask(respawn)) {
+            vint index = viadd(viset1(i), viramp());
+            posX = vselect(respawn, vadd(low, vmul(range, vhashRand(vseed, index, hashedN[0]))), posX);
+            posY = vselect(respawn, vadd(low, vmul(range, vhashRand(vseed, index, hashedN[1]))), posY);
+            posZ = vselect(respawn, vadd(low, vmul(range, vhashRand(vseed, index, hashedN[2]))), posZ);
+        }
+        vstore(m_posX + i, posX);
+        vstore(m_posY + i, posY);
+        vstore(m_posZ + i, posZ);
+    }
+#endif
+    stepScalar(simdEnd, m_count, maxLife, spread, seed, stepCount);
+}
+
+/**
+ * @brief The same as step, one star at a time, for what's left after the SIMD loop
+ * @param begin The first star to step
+ * @param end One past the last star to step
+ * @param maxLife The life stars bounce back from
+ * @param spread How far out on each axis shooting stars can respawn
+ * @param seed Seed for respawning
+ * @param stepCount Steps taken so far
+ */
+void StarField::stepScalar(int begin, int end, float maxLife, float spread, unsigned int seed, unsigned int stepCount) {
+    unsigned int n = stepCount * 3;
+    for (int i = begin; i < end; i++) {
+        m_posX[i] += m_dirX[i];
+        m_posY[i] += m_dirY[i];
+        m_posZ[i] += m_dirZ[i];
+        m_life[i] += m_decay[i];
+
+        if (m_life[i] <= 0 || m_life[i] >= maxLife) {
+            m_decay[i] = -m_decay[i];
+            bool shooting = m_dirX[i]*m_dirX[i] + m_dirY[i]*m_dirY[i] + m_dirZ[i]*m_dirZ[i] > 0;
+            if (shooting && m_life[i] <= 0) {
+                m_posX[i] = -spread + 2.0f * spread * hashRandN(seed, i, n);
+                m_posY[i] = -spread + 2.0f * spread * hashRandN(seed, i, n + 1);
+                m_posZ[i] = -spread + 2.0f * spread * hashRandN(seed, i, n + 2);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Writes every star in order, interleaved for an instance buffer
+ * @param out Room for size() * STARFIELD_PACKED_FLOATS floats
+ */
+void StarField::pack(float *out) {
+    for (int i = 0; i < m_count; i++) packStar(i, out + i * STARFIELD_PACKED_FLOATS);
+}
+
+/**
+ * @brief Writes only the stars on the far side of the sky from the eye, in order
+ * Same test as star.vert, dot(eye, rotation * normalize(-pos)) > 0, but
+ * turned around to dot(transpose(rotation) * eye, pos) < 0 so no star
+ * has to be normalized or rotated.
+ * @param eye The normalized eye position
+ * @param rotation The rotation applied to the whole sky
+ * @param shootingEnd Stars before this index are shooting stars
+ * @param out Room for size() * STARFIELD_PACKED_FLOATS floats
+ * @param visibleShooting Filled in with how many of the written stars are shooting stars
+ * @return The number of stars written
+ */
+int StarField::packVisible(glm::vec3 eye, glm::mat3 rotation, int shootingEnd, float *out, int *visibleShooting) {
+    glm::vec3 e = glm::transpose(rotation) * eye;
+    int written = 0;
+    int shooting = 0;
+    int simdEnd = 0;
+#ifdef SIMD_WIDTH
+    simdEnd = m_count - m_count % SIMD_WIDTH;
+    const vfloat zero = vset1(0.0f);
+    const vfloat eyeX = vset1(e.x);
+    const vfloat eyeY = vset1(e.y);
+    const vfloat eyeZ = vset1(e.z);
+
+    for (int i = 0; i < simdEnd; i += SIMD_WIDTH) {
+        vfloat facing = vadd(vadd(vmul(eyeX, vload(m_posX + i)), vmul(eyeY, vload(m_posY + i))),
+                             vmul(eyeZ, vload(m_posZ + i)));
+        int bits = vmask(vlt(facing, zero));
+        if (bits == 0) continue;
+        for (int lane = 0; lane < SIMD_WIDTH; lane++) {
+            if (!(bits & (1 << lane))) continue;
+            packStar(i + lane, out + written * STARFIELD_PACKED_FLOATS);
+            if (i + lane < shootingEnd) shooting++;
+            written++;
+        }
+    }
+#endif
+    for (int i = simdEnd; i < m_count; i++) {
+        if (e.x*m_posX[i] + e.y*m_posY[i] + e.z*m_posZ[i] >= 0) continue;
+        packStar(i, out + written * STARFIELD_PACKED_FLOATS);
+        if (i < shootingEnd) shooting++;
+        written++;
+    }
+
+    *visibleShooting = shooting;
+    return written;
+}
+
+/**
+ * @brief Returns how many stars each SIMD iteration handles
+ * @return 8 with AVX2, 4 with SSE2, or 1
+ */
+int StarField::width() {
+#ifdef SIMD_WIDTH
+    return SIMD_WIDTH;
+#else
+    return 1;
+#endif
+}
+
+/**
+ * @brief Interleaves one star
+ * @param i The index of the star
+ * @param out Room for STARFIELD_PACKED_FLOATS floats
+ */
+void StarField::packStar(int i, float *out) {
+    out[0] = m_posX[i];
+    out[1] = m_posY[i];
+    out[2] = m_posZ[i];
+    out[3] = m_life[i];
+    out[4] = m_dirX[i];
+    out[5] = m_dirY[i];
+    out[6] = m_dirZ[i];
+    out[7] = m_decay[i];
+}
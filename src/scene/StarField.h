@@ -0,0 +1,65 @@
+#ifndef STARFIELD_H
+#define STARFIELD_H
+
+#include <glm/glm.hpp>
+
+// Floats written per star by pack and packVisible: position + life, then direction + decay
+#define STARFIELD_PACKED_FLOATS 8
+
+/**
+ * @brief One star, for setting up or reading back a single entry
+ */
+struct Star {
+    glm::vec3 pos;
+    float life;
+    glm::vec3 dir; // Moved each step - zero for everything but shooting stars
+    float decay; // Added to life each step
+};
+
+/**
+ * @brief Structure of arrays store of stars with SIMD kernels
+ * Every field lives in its own aligned array, so stepping, respawning,
+ * and the backface test work on 8 (AVX2) or 4 (SSE2) stars at a time
+ * with nothing but straight loads and stores. Falls back to scalar code
+ * when neither is available. Respawning uses the same hash as
+ * starSim.vert, so a seed steps identically here and on the GPU.
+ */
+class StarField {
+public:
+    StarField();
+    ~StarField();
+
+    // Keeps nothing - every star needs to be set again
+    void resize(int count);
+    int size();
+
+    void set(int i, const Star &star);
+    Star get(int i);
+
+    // Advances every star by one fixed step
+    void step(float maxLife, float spread, unsigned int seed, unsigned int stepCount);
+
+    // Writes every star, or only the ones facing eye, as STARFIELD_PACKED_FLOATS each
+    void pack(float *out);
+    int packVisible(glm::vec3 eye, glm::mat3 rotation, int shootingEnd, float *out, int *visibleShooting);
+
+    // Number of stars handled per SIMD iteration
+    static int width();
+
+private:
+    StarField(const StarField &);
+    StarField &operator=(const StarField &);
+
+    void stepScalar(int begin, int end, float maxLife, float spread, unsigned int seed, unsigned int stepCount);
+    void packStar(int i, float *out);
+
+    int m_count;
+    int m_capacity; // Always a multiple of the SIMD width
+    float *m_block; // One aligned allocation holding every array
+
+    // Each points into m_block
+    float *m_posX, *m_posY, *m_posZ, *m_life;
+    float *m_dirX, *m_dirY, *m_dirZ, *m_decay;
+};
+
+#endif // STARFIELD_H
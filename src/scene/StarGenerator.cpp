@@ -0,0 +1,80 @@
+#include "StarGenerator.h"
+#include "Parallel.h"
+
+#include <math.h>
+
+// Keep each kind of star's numbers apart
+#define STATICSTREAM 0
+#define SHOOTINGSTREAM 1
+
+/**
+ * @brief Sets up generators for a seed
+ * @param seed Decides every star
+ * @param minRadius Closest a star can be to the center
+ * @param maxRadius Furthest a star can be from the center
+ * @param maxLife Life stars bounce back from
+ */
+StarGenerator::StarGenerator(unsigned int seed, float minRadius, float maxRadius, float maxLife)
+    : m_static(seed, STATICSTREAM), m_shooting(seed, SHOOTINGSTREAM),
+      m_minCubed(minRadius * minRadius * minRadius), m_maxCubed(maxRadius * maxRadius * maxRadius),
+      m_maxLife(maxLife) {}
+
+/**
+ * @brief Makes static star i
+ * Life bounces between 0 and maxLife, so half rising and half falling from
+ * an even life is the same as an even phase over the whole bounce.
+ * @param i The index of the star
+ * @param out Room for 4 floats: position, then twinkle phase
+ */
+void StarGenerator::staticStar(int i, float *out) const {
+    float u[4];
+    m_static.uniform(i, 0, u);
+    glm::vec3 pos = shellPosition(u);
+    out[0] = pos.x;
+    out[1] = pos.y;
+    out[2] = pos.z;
+    out[3] = u[3] * 2.0f * m_maxLife;
+}
+
+/**
+ * @brief Makes static stars [0, count) on worker threads
+ * @param count The number of stars
+ * @param out Room for 4 floats per star
+ * @param threads How many threads to use, 0 for all of them
+ */
+void StarGenerator::staticStars(int count, float *out, int threads) const {
+    parallelFor(count, [this, out](int begin, int end) {
+        for (int i = begin; i < end; i++) staticStar(i, out + i * 4);
+    }, threads);
+}
+
+/**
+ * @brief Makes shooting star i
+ * @param i The index of the star
+ * @return A star somewhere in the shell, moving in a random direction and fading out
+ */
+Star StarGenerator::shootingStar(int i) const {
+    float u[4], v[4];
+    m_shooting.uniform(i, 0, u);
+    m_shooting.uniform(i, 1, v);
+
+    Star star;
+    star.pos = shellPosition(u);
+    star.life = u[3] * m_maxLife;
+    star.dir = glm::vec3(v[0], v[1], v[2]) * (float)(2.0 * M_PI) - (float)M_PI;
+    star.decay = -1;
+    return star;
+}
+
+/**
+ * @brief Turns three even numbers into a point spread evenly through the shell's volume
+ * @param u Three floats in [0,1)
+ * @return The position
+ */
+glm::vec3 StarGenerator::shellPosition(const float u[3]) const {
+    float cosTheta = 1.0f - 2.0f * u[0];
+    float sinTheta = sqrtf(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+    float phi = 2.0f * M_PI * u[1];
+    float radius = cbrtf(m_minCubed + u[2] * (m_maxCubed - m_minCubed));
+    return radius * glm::vec3(sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta);
+}
@@ -0,0 +1,35 @@
+#ifndef STARGENERATOR_H
+#define STARGENERATOR_H
+
+#include "StarField.h"
+#include "Random.h"
+
+/**
+ * @brief Makes stars as a pure function of a seed and their index
+ * Every star's numbers come from a Philox counter keyed by the seed, so
+ * star i is the same no matter which thread makes it or in what order.
+ * Positions are sampled straight from the shell between the two radii,
+ * evenly by volume, instead of rejecting points from a cube.
+ */
+class StarGenerator {
+public:
+    StarGenerator(unsigned int seed, float minRadius, float maxRadius, float maxLife);
+
+    // Static stars: position, then twinkle phase in [0, 2*maxLife)
+    void staticStar(int i, float *out) const;
+    void staticStars(int count, float *out, int threads = 0) const;
+
+    // Shooting stars come from their own stream, so they don't depend on the static count
+    Star shootingStar(int i) const;
+
+private:
+    glm::vec3 shellPosition(const float u[3]) const;
+
+    Philox m_static;
+    Philox m_shooting;
+    float m_minCubed; // Radius cubed, since volume grows with it
+    float m_maxCubed;
+    float m_maxLife;
+};
+
+#endif // STARGENERATOR_H
@@ -0,0 +1,103 @@
+#include "CubeSphere.h"
+
+#include <map>
+#include <vector>
+
+#define FACES 6
+
+/**
+ * @brief Creates the cube sphere for a UV resolution
+ * @param shader The GLuint for the shader
+ * @param resolution The resolution a UV Sphere would be made with
+ */
+CubeSphere::CubeSphere(GLuint shader, int resolution)
+    : Sphere(shader, resolution, resolution, false) {
+    createGeometry();
+}
+
+/**
+ * @brief Nothing to delete
+ */
+CubeSphere::~CubeSphere() {}
+
+/**
+ * @brief Splits every cube face into cells^2 quads, sharing vertices along edges
+ * A UV sphere at p has 2p^2 triangles and the cube sphere 12c^2, so c is
+ * p/sqrt(6). Grid points are whole numbers on the cube's surface, which
+ * key them so faces meeting at an edge share the same vertices.
+ */
+void CubeSphere::createGeometry() {
+    int cells = glm::max(1, (int)(m_p1 / sqrt(6.0) + 0.5));
+
+    std::map<int, int> indexOf;
+    std::vector<glm::vec3> positions;
+    std::vector<GLuint> indices;
+    std::vector<int> grid((cells + 1) * (cells + 1));
+
+    for (int face = 0; face < FACES; face++) {
+        int axis = face / 2;
+        int side = face % 2 == 0 ? cells : 0;
+
+        // Every grid point on this face
+        for (int u = 0; u <= cells; u++) {
+            for (int v = 0; v <= cells; v++) {
+                glm::ivec3 lattice;
+                lattice[axis] = side;
+                lattice[(axis + 1) % 3] = u;
+                lattice[(axis + 2) % 3] = v;
+                int key = (lattice.x * (cells + 1) + lattice.y) * (cells + 1) + lattice.z;
+
+                std::map<int, int>::iterator found = indexOf.find(key);
+                if (found == indexOf.end()) {
+                    found = indexOf.insert(std::make_pair(key, (int)positions.size())).first;
+                    glm::vec3 warped;
+                    for (int c = 0; c < 3; c++) warped[c] = tan((lattice[c] * 2.0f / cells - 1.0f) * M_PI / 4.0f);
+                    positions.push_back(glm::normalize(warped) * (float)RADIUS);
+                }
+                grid[u * (cells + 1) + v] = found->second;
+            }
+        }
+
+        // Two triangles per cell
+        for (int u = 0; u < cells; u++) {
+            for (int v = 0; v < cells; v++) {
+                int tri[2][3] = {
+                    { grid[u * (cells + 1) + v], grid[(u + 1) * (cells + 1) + v], grid[(u + 1) * (cells + 1) + v + 1] },
+                    { grid[u * (cells + 1) + v], grid[(u + 1) * (cells + 1) + v + 1], grid[u * (cells + 1) + v + 1] }
+                };
+                for (int t = 0; t < 2; t++) {
+                    // Counter clockwise seen from outside
+                    glm::vec3 a = positions[tri[t][0]], b = positions[tri[t][1]], c = positions[tri[t][2]];
+                    bool flip = glm::dot(glm::cross(b - a, c - a), a + b + c) < 0;
+                    indices.push_back(tri[t][0]);
+                    indices.push_back(tri[t][flip ? 2 : 1]);
+                    indices.push_back(tri[t][flip ? 1 : 2]);
+                }
+            }
+        }
+    }
+
+    // Same layout as every other shape
+    m_numTriangles = positions.size(); // Count of all verts
+    m_vertexData = new GLfloat[6*m_numTriangles];
+    int arrayPos = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        storeVectors(positions[i], glm::normalize(positions[i]), &arrayPos);
+    }
+    m_numIndices = indices.size();
+    m_indexData = new GLuint[m_numIndices];
+    std::copy(indices.begin(), indices.end(), m_indexData);
+
+    // Pass all vertices and indices to GL
+    passIndicesToGL();
+    passVerticesToGL(sizeof(GLfloat)*6*m_numTriangles);
+}
+
+/**
+ * @brief Simply binds and draws the indexed triangles
+ */
+void CubeSphere::renderGeometry() {
+    glBindVertexArray(m_vaoID);
+    glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, (void*)0);
+    glBindVertexArray(0);
+}
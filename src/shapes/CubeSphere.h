@@ -0,0 +1,23 @@
+#ifndef CUBESPHERE_H
+#define CUBESPHERE_H
+
+#include "Sphere.h"
+
+/**
+ * @brief CubeSphere - A Sphere
+ * A cube with each face split into a grid, pushed out to the sphere with
+ * an equal angle warp so cells stay close to the same size. Vertices are
+ * shared through an element buffer, including along the cube's edges.
+ * The resolution is matched to a UV Sphere's, so both have about as many
+ * triangles.
+ */
+class CubeSphere : public Sphere {
+public:
+    CubeSphere(GLuint shader, int resolution);
+    virtual ~CubeSphere();
+
+    void createGeometry();
+    void renderGeometry();
+};
+
+#endif // CUBESPHERE_H
@@ -193,3 +193,40 @@ void Cylinder::renderGeometry() {
     glDrawArrays(GL_TRIANGLES, pos3, NUM_VERTS*(m_restRingTri+2*m_p1*m_p2));
     glBindVertexArray(0);
 }
+
+/**
+ * @brief Lists the same fans and triangles as renderGeometry draws, all as triangles
+ * @param indices Replaced with three indices per triangle
+ */
+void Cylinder::getTriangles(std::vector<GLuint> *indices) {
+    const int pos1 = m_oneRingTri+2;
+    const int pos2 = pos1+NUM_VERTS*m_restRingTri;
+    const int pos3 = pos2+m_oneRingTri+2;
+    const int end = pos3+NUM_VERTS*(m_restRingTri+2*m_p1*m_p2);
+    const int fans[2] = { 0, pos2 };
+    const int lists[2][2] = { { pos1, pos2 }, { pos3, end } };
+    indices->clear();
+    for (int f = 0; f < 2; f++) {
+        // Bottom, then top - each fan turns around its first vertex
+        for (int i = 1; i < m_oneRingTri+1; i++) {
+            indices->push_back(fans[f]);
+            indices->push_back(fans[f] + i);
+            indices->push_back(fans[f] + i + 1);
+        }
+        for (int i = lists[f][0]; i < lists[f][1]; i++) indices->push_back(i);
+    }
+}
+
+/**
+ * @brief Draws the same fans and triangles as renderGeometry, once per instance
+ * @param count The number of instances to draw
+ */
+void Cylinder::drawInstances(int count) {
+    const int pos1 = m_oneRingTri+2;
+    const int pos2 = pos1+NUM_VERTS*m_restRingTri;
+    const int pos3 = pos2+m_oneRingTri+2;
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, m_oneRingTri+2, count);
+    glDrawArraysInstanced(GL_TRIANGLES, pos1, NUM_VERTS*m_restRingTri, count);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, pos2, m_oneRingTri+2, count);
+    glDrawArraysInstanced(GL_TRIANGLES, pos3, NUM_VERTS*(m_restRingTri+2*m_p1*m_p2), count);
+}
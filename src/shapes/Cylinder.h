@@ -31,6 +31,11 @@ public:
     // Helper to create sides
     void createSideGeometry(int *arrayPos, const float st, const float theta);
 
+    // The caps' fans come out as triangles too
+    void getTriangles(std::vector<GLuint> *indices);
+
+protected:
+    void drawInstances(int count);
 };
 
 #endif // CYLINDER_H
@@ -0,0 +1,126 @@
+#include "IcoSphere.h"
+
+#include <map>
+#include <vector>
+
+#define CORNERS 12
+#define FACES 20
+#define WEIGHTBITS 11 // Bits per (corner, weight) pair in a vertex key
+
+// Icosahedron corners, before normalizing
+static const float GOLDEN = 1.61803398875f;
+static const glm::vec3 CORNERPOSITIONS[CORNERS] = {
+    glm::vec3(-1, GOLDEN, 0), glm::vec3(1, GOLDEN, 0), glm::vec3(-1, -GOLDEN, 0), glm::vec3(1, -GOLDEN, 0),
+    glm::vec3(0, -1, GOLDEN), glm::vec3(0, 1, GOLDEN), glm::vec3(0, -1, -GOLDEN), glm::vec3(0, 1, -GOLDEN),
+    glm::vec3(GOLDEN, 0, -1), glm::vec3(GOLDEN, 0, 1), glm::vec3(-GOLDEN, 0, -1), glm::vec3(-GOLDEN, 0, 1)
+};
+
+// Corners of each icosahedron face
+static const int FACECORNERS[FACES][3] = {
+    {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+    {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+    {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+    {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+};
+
+/**
+ * @brief Creates the geodesic sphere for a UV resolution
+ * @param shader The GLuint for the shader
+ * @param resolution The resolution a UV Sphere would be made with
+ */
+IcoSphere::IcoSphere(GLuint shader, int resolution)
+    : Sphere(shader, resolution, resolution, false) {
+    createGeometry();
+}
+
+/**
+ * @brief Nothing to delete
+ */
+IcoSphere::~IcoSphere() {}
+
+/**
+ * @brief Splits every face into frequency^2 triangles, sharing vertices along edges
+ * A UV sphere at p has 2p^2 triangles and the geodesic one 20f^2, so f is
+ * p/sqrt(10). Each vertex is a weighted sum of its face's corners, so
+ * it's keyed by its nonzero (corner, weight) pairs - the same point on
+ * two faces always has the same key and position.
+ */
+void IcoSphere::createGeometry() {
+    int frequency = glm::max(1, (int)(m_p1 / sqrt(10.0) + 0.5));
+
+    std::map<unsigned long long, int> indexOf;
+    std::vector<glm::vec3> positions;
+    std::vector<GLuint> indices;
+
+    for (int face = 0; face < FACES; face++) {
+        const int *corners = FACECORNERS[face];
+
+        // Index of every grid point on this face, by (i, j): weight i on the second corner, j on the third
+        std::vector<int> grid((frequency + 1) * (frequency + 1));
+        for (int i = 0; i <= frequency; i++) {
+            for (int j = 0; i + j <= frequency; j++) {
+                int weights[3] = { frequency - i - j, i, j };
+
+                // Sort nonzero weights by corner so shared points match
+                std::map<int, int> pairs;
+                for (int c = 0; c < 3; c++) if (weights[c] > 0) pairs[corners[c]] = weights[c];
+                unsigned long long key = 0;
+                glm::vec3 point(0);
+                for (std::map<int, int>::iterator it = pairs.begin(); it != pairs.end(); ++it) {
+                    key = (key << WEIGHTBITS) | (unsigned long long)(it->first << 7 | it->second);
+                    point += (float)it->second * CORNERPOSITIONS[it->first];
+                }
+
+                std::map<unsigned long long, int>::iterator found = indexOf.find(key);
+                if (found == indexOf.end()) {
+                    found = indexOf.insert(std::make_pair(key, (int)positions.size())).first;
+                    positions.push_back(glm::normalize(point) * (float)RADIUS);
+                }
+                grid[i * (frequency + 1) + j] = found->second;
+            }
+        }
+
+        // Up and down triangles in the grid
+        for (int i = 0; i < frequency; i++) {
+            for (int j = 0; i + j < frequency; j++) {
+                int tri[2][3] = {
+                    { grid[i * (frequency + 1) + j], grid[(i + 1) * (frequency + 1) + j], grid[i * (frequency + 1) + j + 1] },
+                    { grid[(i + 1) * (frequency + 1) + j], grid[(i + 1) * (frequency + 1) + j + 1], grid[i * (frequency + 1) + j + 1] }
+                };
+                int count = i + j + 1 < frequency ? 2 : 1;
+                for (int t = 0; t < count; t++) {
+                    // Counter clockwise seen from outside
+                    glm::vec3 a = positions[tri[t][0]], b = positions[tri[t][1]], c = positions[tri[t][2]];
+                    bool flip = glm::dot(glm::cross(b - a, c - a), a + b + c) < 0;
+                    indices.push_back(tri[t][0]);
+                    indices.push_back(tri[t][flip ? 2 : 1]);
+                    indices.push_back(tri[t][flip ? 1 : 2]);
+                }
+            }
+        }
+    }
+
+    // Same layout as every other shape
+    m_numTriangles = positions.size(); // Count of all verts
+    m_vertexData = new GLfloat[6*m_numTriangles];
+    int arrayPos = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        storeVectors(positions[i], glm::normalize(positions[i]), &arrayPos);
+    }
+    m_numIndices = indices.size();
+    m_indexData = new GLuint[m_numIndices];
+    std::copy(indices.begin(), indices.end(), m_indexData);
+
+    // Pass all vertices and indices to GL
+    passIndicesToGL();
+    passVerticesToGL(sizeof(GLfloat)*6*m_numTriangles);
+}
+
+/**
+ * @brief Simply binds and draws the indexed triangles
+ */
+void IcoSphere::renderGeometry() {
+    glBindVertexArray(m_vaoID);
+    glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, (void*)0);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,23 @@
+#ifndef ICOSPHERE_H
+#define ICOSPHERE_H
+
+#include "Sphere.h"
+
+/**
+ * @brief IcoSphere - A Sphere
+ * A geodesic sphere made by splitting each face of an icosahedron into a
+ * triangular grid and pushing it out to the sphere. Vertices are shared
+ * through an element buffer, and triangles are all about the same size,
+ * with nothing piling up at the poles. The resolution is matched to a UV
+ * Sphere's, so both have about as many triangles.
+ */
+class IcoSphere : public Sphere {
+public:
+    IcoSphere(GLuint shader, int resolution);
+    virtual ~IcoSphere();
+
+    void createGeometry();
+    void renderGeometry();
+};
+
+#endif // ICOSPHERE_H
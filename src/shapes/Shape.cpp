@@ -27,6 +27,123 @@ Shape::~Shape() {
     cleanupGL();
 }
 
+/**
+ * @brief Draws each vertex once as a point, in the same order as the triangles
+ * Used to run vertices through a transform feedback shader
+ */
+void Shape::renderPoints() {
+    glBindVertexArray(m_vaoID);
+    glDrawArrays(GL_POINTS, 0, m_numTriangles);
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Sets which attributes come from the instance buffer
+ * Each is a vec4, packed one after another in every instance, so a mat4
+ * attribute takes its four locations in a row.
+ * @param locations The attribute locations, in the order they're packed
+ */
+void Shape::setInstanceAttributes(const std::vector<GLint> &locations) {
+    m_instanceLocations = locations;
+    m_instanceSource = 0;
+    m_instanceFirst = 0;
+}
+
+/**
+ * @brief Draws the shape once per instance, however many parts it's drawn in
+ * @param buffer The buffer holding instances, a vec4 per instance attribute each
+ * @param first The first instance in the buffer to draw
+ * @param count The number of instances to draw
+ */
+void Shape::renderInstanced(GLuint buffer, int first, int count) {
+    if (count <= 0 || m_instanceLocations.empty()) return;
+    if (buffer != m_instanceSource || first != m_instanceFirst) pointInstancesAt(buffer, first);
+    glBindVertexArray(m_vaoID);
+    drawInstances(count);
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Draws every triangle once per instance, indexed if the shape is
+ * @param count The number of instances to draw
+ */
+void Shape::drawInstances(int count) {
+    if (m_numIndices > 0) glDrawElementsInstanced(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, (void*)0, count);
+    else glDrawArraysInstanced(GL_TRIANGLES, 0, m_numTriangles, count);
+}
+
+/**
+ * @brief Points the instance attributes of the VAO at a buffer
+ * Starting partway in stands in for base instances, which need GL 4.2
+ * @param buffer The buffer to read instances from
+ * @param first The instance in the buffer that's drawn as instance 0
+ */
+void Shape::pointInstancesAt(GLuint buffer, int first) {
+    m_instanceSource = buffer;
+    m_instanceFirst = first;
+    glBindVertexArray(m_vaoID);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    GLsizei stride = 4*m_instanceLocations.size()*sizeof(GLfloat);
+    for (size_t i = 0; i < m_instanceLocations.size(); i++) {
+        if (m_instanceLocations[i] < 0) continue;
+        GLintptr offset = first*stride + 4*i*sizeof(GLfloat);
+        glEnableVertexAttribArray(m_instanceLocations[i]);
+        glVertexAttribPointer(m_instanceLocations[i], 4, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+        glVertexAttribDivisor(m_instanceLocations[i], 1);
+    }
+
+    // Clean up
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Returns the vertices the triangles use, kept on the CPU
+ * @return 6 floats per vertex: position, then normal
+ */
+const GLfloat *Shape::getVertexData() {
+    return m_vertexData;
+}
+
+/**
+ * @brief Returns how many vertices the triangles use
+ * @return m_numTriangles, which counts vertices
+ */
+int Shape::getVertexCount() {
+    return m_numTriangles;
+}
+
+/**
+ * @brief Returns the triangles' indices, kept on the CPU
+ * @return Three indices per triangle, or NULL if the shape isn't indexed
+ */
+const GLuint *Shape::getIndexData() {
+    return m_indexData;
+}
+
+/**
+ * @brief Returns how many indices the triangles use
+ * @return m_numIndices, 0 if the shape isn't indexed
+ */
+int Shape::getIndexCount() {
+    return m_numIndices;
+}
+
+/**
+ * @brief Lists every triangle as indices into the vertex data, for merging shapes
+ * Shapes drawn as plain triangles, indexed or not, list them in order.
+ * @param indices Replaced with three indices per triangle
+ */
+void Shape::getTriangles(std::vector<GLuint> *indices) {
+    indices->clear();
+    if (m_numIndices > 0) {
+        indices->assign(m_indexData, m_indexData + m_numIndices);
+        return;
+    }
+    for (int i = 0; i < m_numTriangles; i++) indices->push_back(i);
+}
+
 /**
  * @brief Intersects a ray with a cap (top or bottom by y)
  * @param p The point to start from
@@ -147,6 +264,9 @@ void Shape::initShape(GLuint shader, int param1, int param2) {
     m_p1 = param1;
     m_p2 = param2;
     m_vertexData = NULL;
+    m_indexData = NULL;
+    m_numIndices = 0;
+    m_eboID = 0;
 
     // Initialize the vao and vbo and create vertex array
     setupGL();
@@ -170,7 +290,16 @@ void Shape::cleanupGL() {
         delete[] m_vertexData;
         m_vertexData = NULL;
     }
+    if (m_indexData != NULL) {
+        delete[] m_indexData;
+        m_indexData = NULL;
+        m_numIndices = 0;
+    }
     // Delete ID data
+    if (m_eboID != 0) {
+        glDeleteBuffers(1, &m_eboID);
+        m_eboID = 0;
+    }
     if (m_vboID != 0) {
         glDeleteBuffers(1, &m_vboID);
         m_vboID = 0;
@@ -183,8 +312,12 @@ void Shape::cleanupGL() {
 
 /**
  * @brief Creates VAO and VBO for vertices
+ * A new VAO has no instance attributes pointed anywhere yet.
  */
 void Shape::setupGL() {
+    m_instanceSource = 0;
+    m_instanceFirst = 0;
+
     // Initialize the vertex array and buffer
     glGenVertexArrays(1, &m_vaoID);
     glBindVertexArray(m_vaoID);
@@ -199,31 +332,49 @@ void Shape::setupGL() {
 void Shape::passVerticesToGL(int bufDataSize) {
     // Pass vertex data to OpenGL.
     float stride = sizeof(GLfloat)*6;
+    GLint position = glGetAttribLocation(m_shader, "position");
+    GLint normal = glGetAttribLocation(m_shader, "normal");
     glBufferData(GL_ARRAY_BUFFER, bufDataSize, m_vertexData, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(glGetAttribLocation(m_shader, "position"));
-    glEnableVertexAttribArray(glGetAttribLocation(m_shader, "normal"));
-    glVertexAttribPointer(
-        glGetAttribLocation(m_shader, "position"),
-        3,                   // Num coordinates per position
-        GL_FLOAT,            // Type
-        GL_FALSE,            // Normalized
-        stride, // Stride
-        (void*) 0            // Array buffer offset
-    );
-    glVertexAttribPointer(
-        glGetAttribLocation(m_shader, "normal"),
-        3,           // Num coordinates per normal
-        GL_FLOAT,    // Type
-        GL_TRUE,     // Normalized
-        stride,           // Stride
-        (void*) (sizeof(GLfloat) * 3)    // Array buffer offset
-    );
+
+    // Shaders that don't use one of them just don't get it
+    if (position >= 0) {
+        glEnableVertexAttribArray(position);
+        glVertexAttribPointer(
+            position,
+            3,                   // Num coordinates per position
+            GL_FLOAT,            // Type
+            GL_FALSE,            // Normalized
+            stride, // Stride
+            (void*) 0            // Array buffer offset
+        );
+    }
+    if (normal >= 0) {
+        glEnableVertexAttribArray(normal);
+        glVertexAttribPointer(
+            normal,
+            3,           // Num coordinates per normal
+            GL_FLOAT,    // Type
+            GL_TRUE,     // Normalized
+            stride,           // Stride
+            (void*) (sizeof(GLfloat) * 3)    // Array buffer offset
+        );
+    }
 
     // Unbind buffers.
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
 
+/**
+ * @brief Loads the current indices into an element buffer the VAO keeps
+ * Assumes the VAO is still bound from setupGL
+ */
+void Shape::passIndicesToGL() {
+    glGenBuffers(1, &m_eboID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_eboID);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*m_numIndices, m_indexData, GL_STATIC_DRAW);
+}
+
 /**
  * @brief Helper to save vec and norm at the next positions in vertdata
  * @param vec The vector to save
@@ -20,6 +20,22 @@ public:
     // Renders a given shape (assumes GL is setup with correct vertices)
     virtual void renderGeometry() = 0;
 
+    // Renders the shape once per instance, reading vec4 instance attributes from a buffer
+    void setInstanceAttributes(const std::vector<GLint> &locations);
+    void renderInstanced(GLuint buffer, int first, int count);
+
+    // Draws every vertex as a point, for transform feedback
+    void renderPoints();
+    const GLfloat *getVertexData();
+    int getVertexCount();
+
+    // Triangles as indices into the vertices, for shapes that share vertices (NULL and 0 otherwise)
+    const GLuint *getIndexData();
+    int getIndexCount();
+
+    // Every triangle as three indices into the vertices, however the shape is drawn
+    virtual void getTriangles(std::vector<GLuint> *indices);
+
     // Creates vertex array and readies GL for drawing
     virtual void createGeometry() = 0;
 
@@ -50,6 +66,7 @@ public:
 protected:
     GLuint m_vaoID;
     GLuint m_vboID;
+    GLuint m_eboID;
     GLuint m_shader;
 
     // Creates the shape (constructor just calls this)
@@ -67,14 +84,29 @@ protected:
     // Gives the vertices to GL to create and do stuff with
     void passVerticesToGL(int bufDataSize);
 
+    // Gives the indices to GL too - call before passVerticesToGL, which unbinds the VAO
+    void passIndicesToGL();
+
+    // Draws every triangle count times with the VAO bound - shapes drawn in parts override it
+    virtual void drawInstances(int count);
+    void pointInstancesAt(GLuint buffer, int first);
+
     // Main array used for vertices and normals
     GLfloat* m_vertexData;
 
+    // Triangles as indices into m_vertexData, only for indexed shapes
+    GLuint* m_indexData;
+    int m_numIndices;
+
     // Current parameters
     int m_p1;
     int m_p2;
     int m_numTriangles; // Total num of triangles on face currently
 
+    // Instance attributes, one vec4 each in order, and where they read from right now
+    std::vector<GLint> m_instanceLocations;
+    GLuint m_instanceSource;
+    int m_instanceFirst;
 };
 
 #endif // SHAPE_H
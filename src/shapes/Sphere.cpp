@@ -16,6 +16,19 @@ Sphere::Sphere(GLuint shader, int param1, int param2)
     createGeometry();
 }
 
+/**
+ * @brief Sets up the sphere without creating any geometry
+ * @param shader The GLuint for the shader
+ * @param param1 The resolution horizontally
+ * @param param2 The resolution vertically
+ * @param createNow If the UV sphere's geometry should be created now
+ */
+Sphere::Sphere(GLuint shader, int param1, int param2, bool createNow)
+    : Shape(shader, param1, param2) {
+    boundParams();
+    if (createNow) createGeometry();
+}
+
 /**
  * @brief Nothing to delete
  */
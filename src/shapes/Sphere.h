@@ -23,6 +23,10 @@ public:
     void computeT(glm::vec3 p, glm::vec3 d, RayData *data);
     void computeNorm(glm::vec3 eye, glm::vec3 d, RayData *data);
     void computeTexture(RayData *rayData, TexturePointData *texData);
+
+protected:
+    // For subclasses that tesselate differently - geometry is left to them
+    Sphere(GLuint shader, int param1, int param2, bool createNow);
 };
 
 #endif // SPHERE_H